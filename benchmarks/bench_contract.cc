@@ -0,0 +1,299 @@
+// Benchmarks of the contraction engine
+//
+// Usage: wicked_bench [options] [workload ...]
+//
+// Each workload builds an operator expression and contracts it with
+// WickTheorem. The results (wall time, contractions per second, estimated
+// peak memory, number of terms) are written in the JSON format. Run
+// "wicked_bench --help" for the list of options and workloads.
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include "fmt/format.h"
+
+#include "algebra/expression.h"
+#include "diagrams/operator.h"
+#include "diagrams/operator_expression.h"
+#include "diagrams/wick_theorem.h"
+#include "helpers/helpers.h"
+#include "helpers/orbital_space.h"
+#include "helpers/profile.h"
+#include "helpers/timer.hpp"
+
+namespace {
+
+/// A contraction to benchmark
+struct workload {
+  std::string name;
+  std::string description;
+  /// Add the orbital spaces used by this workload
+  std::function<void(OrbitalSpaceInfo &)> spaces;
+  /// Build the expression to contract
+  std::function<OperatorExpression()> expr;
+  int minrank;
+  int maxrank;
+};
+
+OperatorExpression op(const std::string &label,
+                      const std::vector<std::string> &components) {
+  return make_diag_operator_expression(label, components);
+}
+
+void occupied_virtual_spaces(OrbitalSpaceInfo &osi) {
+  osi.add_space('o', FieldType::Fermion, SpaceType::Occupied,
+                {"i", "j", "k", "l", "m", "n"});
+  osi.add_space('v', FieldType::Fermion, SpaceType::Unoccupied,
+                {"a", "b", "c", "d", "e", "f"});
+}
+
+void core_active_virtual_spaces(OrbitalSpaceInfo &osi) {
+  osi.add_space('c', FieldType::Fermion, SpaceType::Occupied, {"m", "n"});
+  osi.add_space('a', FieldType::Fermion, SpaceType::General,
+                {"u", "v", "w", "x", "y", "z"});
+  osi.add_space('v', FieldType::Fermion, SpaceType::Unoccupied, {"e", "f"});
+}
+
+/// The similarity-transformed Hamiltonian of coupled cluster theory with
+/// excitations up to the given rank
+OperatorExpression cc_hbar(int max_excitation) {
+  auto F = op("f", {"o+ o", "v+ o", "o+ v", "v+ v"});
+  auto V = op("v", {"o+ o+ o o", "v+ o+ o o", "o+ o+ v o", "v+ v+ o o",
+                    "o+ o+ v v", "v+ o+ v o", "v+ v+ v o", "v+ o+ v v",
+                    "v+ v+ v v"});
+  OperatorExpression T;
+  for (int n = 1; n <= max_excitation; n++) {
+    std::vector<std::string> sqops(n, "v+");
+    sqops.insert(sqops.end(), n, "o");
+    T += op("t", {join(sqops, " ")});
+  }
+  return bch_series(F + V, T, 4);
+}
+
+/// The commutator [H, T] of multireference theories with a general (active)
+/// space
+OperatorExpression mr_commutator() {
+  std::vector<std::string> one_body, two_body;
+  const std::string spaces = "cav";
+  for (char p : spaces) {
+    for (char q : spaces) {
+      one_body.push_back(fmt::format("{}+ {}", p, q));
+    }
+  }
+  for (int p = 0; p < 3; p++) {
+    for (int q = p; q < 3; q++) {
+      for (int r = 0; r < 3; r++) {
+        for (int s = r; s < 3; s++) {
+          two_body.push_back(fmt::format("{}+ {}+ {} {}", spaces[p],
+                                         spaces[q], spaces[r], spaces[s]));
+        }
+      }
+    }
+  }
+  auto H = op("f", one_body) + op("v", two_body);
+  auto T1 = op("t", {"a+ c", "v+ c", "v+ a"});
+  auto T2 = op("t", {"a+ a+ c c", "v+ a+ c c", "v+ v+ c c", "a+ a+ a c",
+                     "v+ a+ a c", "v+ v+ a c", "v+ a+ a a", "v+ v+ a a"});
+  return commutator(H, T1 + T2);
+}
+
+std::vector<workload> all_workloads() {
+  std::vector<workload> w;
+  w.push_back({"ccsd", "CCSD energy and residuals", occupied_virtual_spaces,
+               [] { return cc_hbar(2); }, 0, 4});
+  w.push_back({"ccsdt", "CCSDT energy and residuals", occupied_virtual_spaces,
+               [] { return cc_hbar(3); }, 0, 6});
+  w.push_back({"ccsdtq", "CCSDTQ energy and residuals",
+               occupied_virtual_spaces, [] { return cc_hbar(4); }, 0, 8});
+  w.push_back({"mr", "[H, T1 + T2] with a general active space",
+               core_active_virtual_spaces, mr_commutator, 0, 4});
+  w.push_back({"cancellation", "[V, T2] in a general space (0-body part)",
+               [](OrbitalSpaceInfo &osi) {
+                 osi.add_space('a', FieldType::Fermion, SpaceType::General,
+                               {"u", "v", "w", "x", "y", "z"});
+               },
+               [] {
+                 return commutator(op("v", {"a+ a+ a a"}),
+                                   op("t", {"a+ a+ a a"}));
+               },
+               0, 0});
+  return w;
+}
+
+/// The maximum resident set size of this process (KB, 0 if not available)
+long max_rss_kb() {
+#if defined(__unix__) || defined(__APPLE__)
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+#else
+  return 0;
+#endif
+}
+
+struct options {
+  std::vector<std::string> workloads;
+  int repeat = 1;
+  bool canonicalize_graph = true;
+  bool profile = false;
+  std::string output;
+};
+
+void print_usage(const std::vector<workload> &workloads) {
+  std::cout << "Usage: wicked_bench [options] [workload ...]\n\n"
+               "Options:\n"
+               "  --repeat N                run each workload N times\n"
+               "  --no-canonicalize-graph   turn off graph canonicalization\n"
+               "  --profile                 collect performance counters\n"
+               "  --output FILE             write the results to FILE\n"
+               "  --list                    list the workloads\n\n"
+               "Workloads (default: all):\n";
+  for (const auto &w : workloads) {
+    std::cout << fmt::format("  {:<14s}{}\n", w.name, w.description);
+  }
+}
+
+/// Run a workload and return its results as a JSON object
+std::string run(const workload &w, const options &opts) {
+  auto osi = std::make_shared<OrbitalSpaceInfo>();
+  w.spaces(*osi);
+  osi_scope scope(osi);
+
+  const OperatorExpression expr = w.expr();
+  WickTheorem wt;
+  wt.do_canonicalize_graph(opts.canonicalize_graph);
+
+  // the number of contractions is counted without contracting
+  uint64_t contractions = 0;
+  for (const auto &e : wt.estimate(expr, w.minrank, w.maxrank)) {
+    contractions += e.contractions;
+  }
+
+  reset_profile();
+  std::vector<double> times;
+  size_t terms = 0;
+  for (int r = 0; r < opts.repeat; r++) {
+    timer t;
+    Expression result = wt.contract(scalar_t(1), expr, w.minrank, w.maxrank);
+    times.push_back(t.get());
+    terms = result.size();
+  }
+  const double best = *std::min_element(times.begin(), times.end());
+  double mean = 0.0;
+  for (double t : times) {
+    mean += t / times.size();
+  }
+
+  std::string json = fmt::format(
+      "    {{\n"
+      "      \"name\": \"{}\",\n"
+      "      \"products\": {},\n"
+      "      \"contractions\": {},\n"
+      "      \"terms\": {},\n"
+      "      \"wall_time\": {:.6f},\n"
+      "      \"wall_time_mean\": {:.6f},\n"
+      "      \"contractions_per_second\": {:.1f},\n"
+      "      \"memory_peak_bytes\": {},\n"
+      "      \"max_rss_kb\": {}",
+      w.name, expr.size(), contractions, terms, best, mean,
+      best > 0.0 ? contractions / best : 0.0, wt.memory()["peak"],
+      max_rss_kb());
+  if (opts.profile) {
+    const profile_data p = profile();
+    json += ",\n      \"counters\": {";
+    for (int i = 0; i < num_counters; i++) {
+      json += fmt::format("{}\"{}\": {}", i ? ", " : "",
+                          counter_name(static_cast<Counter>(i)),
+                          p.counters[i]);
+    }
+    json += "}";
+  }
+  json += "\n    }";
+  return json;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const auto workloads = all_workloads();
+  options opts;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if ((arg == "--repeat") and (i + 1 < argc)) {
+      opts.repeat = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--no-canonicalize-graph") {
+      opts.canonicalize_graph = false;
+    } else if (arg == "--profile") {
+      opts.profile = true;
+    } else if ((arg == "--output") and (i + 1 < argc)) {
+      opts.output = argv[++i];
+    } else if ((arg == "--list") or (arg == "--help") or (arg == "-h")) {
+      print_usage(workloads);
+      return 0;
+    } else if (std::any_of(workloads.begin(), workloads.end(),
+                           [&](const workload &w) { return w.name == arg; })) {
+      opts.workloads.push_back(arg);
+    } else {
+      std::cerr << "wicked_bench: unknown argument " << arg << "\n\n";
+      print_usage(workloads);
+      return 1;
+    }
+  }
+  if (opts.workloads.empty()) {
+    for (const auto &w : workloads) {
+      opts.workloads.push_back(w.name);
+    }
+  }
+  enable_profile(opts.profile);
+
+  std::vector<std::string> results;
+  for (const auto &w : workloads) {
+    if (std::find(opts.workloads.begin(), opts.workloads.end(), w.name) !=
+        opts.workloads.end()) {
+      std::cerr << "Running " << w.name << "..." << std::endl;
+      results.push_back(run(w, opts));
+    }
+  }
+
+  std::string json = fmt::format(
+      "{{\n"
+      "  \"benchmark\": \"wicked_bench\",\n"
+      "  \"version\": 1,\n"
+      "  \"boost_1024_int\": {},\n"
+      "  \"canonicalize_graph\": {},\n"
+      "  \"profile\": {},\n"
+      "  \"repeat\": {},\n"
+      "  \"workloads\": [\n",
+      use_boost_1024_int(), opts.canonicalize_graph, opts.profile,
+      opts.repeat);
+  for (size_t i = 0; i < results.size(); i++) {
+    json += results[i] + (i + 1 < results.size() ? ",\n" : "\n");
+  }
+  json += "  ]\n}\n";
+
+  if (opts.output.empty()) {
+    std::cout << json;
+  } else {
+    std::ofstream file(opts.output);
+    if (not file) {
+      std::cerr << "wicked_bench: cannot open the file " << opts.output
+                << std::endl;
+      return 1;
+    }
+    file << json;
+  }
+  return 0;
+}
@@ -0,0 +1,351 @@
+// Microbenchmarks of the core algebra primitives
+//
+// Usage: wicked_microbench [--samples N] [--seed N] [--output FILE] [filter]
+//
+// Each benchmark runs a kernel on a fixed set of inputs generated from a
+// seeded random number generator. The kernel is repeated until a sample takes
+// at least 10 ms, and the statistics (min, median, mean, standard deviation)
+// of the time per item are computed over several samples and written in the
+// JSON format. Only the benchmarks whose name contains filter are run.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "fmt/format.h"
+
+#include "algebra/expression.h"
+#include "algebra/index.h"
+#include "algebra/symbolic_term.h"
+#include "algebra/tensor.h"
+#include "diagrams/graph_matrix.h"
+#include "diagrams/operator.h"
+#include "diagrams/operator_expression.h"
+#include "diagrams/wick_theorem.h"
+#include "helpers/combinatorics.h"
+#include "helpers/orbital_space.h"
+#include "helpers/timer.hpp"
+
+namespace {
+
+/// The results of the kernels are accumulated here so that the compiler
+/// cannot remove them
+volatile long sink = 0;
+
+struct options {
+  int samples = 20;
+  unsigned seed = 42;
+  std::string filter;
+  std::string output;
+};
+
+/// The statistics of the time per item (ns)
+struct statistics {
+  std::string name;
+  size_t items;
+  size_t iterations;
+  double min;
+  double median;
+  double mean;
+  double stddev;
+};
+
+/// Time a kernel that processes items inputs per call
+statistics measure(const std::string &name, size_t items,
+                   const std::function<void()> &kernel, int samples) {
+  // warm up and find how many calls make a sample of at least 10 ms
+  size_t iterations = 1;
+  while (true) {
+    timer t;
+    for (size_t i = 0; i < iterations; i++) {
+      kernel();
+    }
+    if ((t.get() >= 0.01) or (iterations >= (1 << 20))) {
+      break;
+    }
+    iterations *= 2;
+  }
+
+  std::vector<double> times;
+  for (int s = 0; s < samples; s++) {
+    timer t;
+    for (size_t i = 0; i < iterations; i++) {
+      kernel();
+    }
+    times.push_back(1.0e9 * t.get() / (iterations * items));
+  }
+  std::sort(times.begin(), times.end());
+  const double mean =
+      std::accumulate(times.begin(), times.end(), 0.0) / times.size();
+  double var = 0.0;
+  for (double t : times) {
+    var += (t - mean) * (t - mean);
+  }
+  var = times.size() > 1 ? var / (times.size() - 1) : 0.0;
+  const size_t n = times.size();
+  const double median =
+      n % 2 ? times[n / 2] : 0.5 * (times[n / 2 - 1] + times[n / 2]);
+  return {name, items, iterations, times.front(), median, mean,
+          std::sqrt(var)};
+}
+
+/// Return n random indices in the spaces 0 and 1 without repetitions
+std::vector<Index> random_indices(int n, std::mt19937 &rng) {
+  std::vector<Index> indices;
+  std::uniform_int_distribution<int> space(0, 1);
+  std::uniform_int_distribution<int> pos(0, 5);
+  while (static_cast<int>(indices.size()) < n) {
+    Index idx(space(rng), pos(rng));
+    if (std::find(indices.begin(), indices.end(), idx) == indices.end()) {
+      indices.push_back(idx);
+    }
+  }
+  return indices;
+}
+
+/// Return a random antisymmetric tensor with 1 to 3 upper and lower indices
+Tensor random_tensor(const std::string &label, std::mt19937 &rng) {
+  std::uniform_int_distribution<int> rank(1, 3);
+  const int n = rank(rng);
+  const auto indices = random_indices(2 * n, rng);
+  return Tensor(label, std::vector<Index>(indices.begin(), indices.begin() + n),
+                std::vector<Index>(indices.begin() + n, indices.end()),
+                SymmetryType::Antisymmetric);
+}
+
+/// Return a random product of two tensors
+SymbolicTerm random_term(std::mt19937 &rng) {
+  SymbolicTerm term;
+  term.add(random_tensor("v", rng));
+  term.add(random_tensor("t", rng));
+  return term;
+}
+
+std::vector<statistics> run(const options &opts) {
+  std::vector<statistics> results;
+  auto bench = [&](const std::string &name, size_t items,
+                   const std::function<void()> &kernel) {
+    if (name.find(opts.filter) != std::string::npos) {
+      std::cerr << "Running " << name << "..." << std::endl;
+      results.push_back(measure(name, items, kernel, opts.samples));
+    }
+  };
+  std::mt19937 rng(opts.seed);
+  const size_t n = 1000;
+
+  // rational arithmetic
+  std::vector<scalar_t> a, b;
+  {
+    std::uniform_int_distribution<int> num(-12, 12);
+    std::uniform_int_distribution<int> den(1, 24);
+    for (size_t i = 0; i < n; i++) {
+      a.push_back(scalar_t(num(rng), den(rng)));
+      b.push_back(scalar_t(num(rng) | 1, den(rng)));
+    }
+  }
+  bench("rational/add", n, [&] {
+    scalar_t sum;
+    for (size_t i = 0; i < n; i++) {
+      sum += a[i];
+    }
+    sink = sink + (sum == scalar_t(0));
+  });
+  bench("rational/multiply", n, [&] {
+    for (size_t i = 0; i < n; i++) {
+      sink = sink + (a[i] * b[i] == scalar_t(0));
+    }
+  });
+  bench("rational/divide", n, [&] {
+    for (size_t i = 0; i < n; i++) {
+      sink = sink + (a[i] / b[i] == scalar_t(0));
+    }
+  });
+
+  // permutation_sign and canonicalize_indices
+  std::vector<std::vector<int>> perms;
+  for (size_t i = 0; i < n; i++) {
+    std::vector<int> perm(8);
+    std::iota(perm.begin(), perm.end(), 0);
+    std::shuffle(perm.begin(), perm.end(), rng);
+    perms.push_back(perm);
+  }
+  bench("permutation_sign", n, [&] {
+    for (const auto &perm : perms) {
+      sink = sink + permutation_sign(perm);
+    }
+  });
+  std::vector<std::vector<Index>> index_vecs;
+  for (size_t i = 0; i < n; i++) {
+    index_vecs.push_back(random_indices(2 + i % 5, rng));
+  }
+  // includes the cost of copying the input
+  bench("canonicalize_indices", n, [&] {
+    for (const auto &indices : index_vecs) {
+      std::vector<Index> copy = indices;
+      sink = sink + (canonicalize_indices(copy, false) == scalar_t(1));
+    }
+  });
+
+  // Tensor::canonicalize (includes the cost of copying the input)
+  std::vector<Tensor> tensors;
+  for (size_t i = 0; i < n; i++) {
+    tensors.push_back(random_tensor("t", rng));
+  }
+  bench("Tensor::canonicalize", n, [&] {
+    for (const auto &tensor : tensors) {
+      Tensor copy = tensor;
+      sink = sink + (copy.canonicalize() == scalar_t(1));
+    }
+  });
+
+  // SymbolicTerm::canonicalize on the terms of the CCSD equations with the
+  // tensors shuffled (includes the cost of copying the input)
+  std::vector<SymbolicTerm> terms;
+  {
+    auto op = [](const std::string &label,
+                 const std::vector<std::string> &components) {
+      return make_diag_operator_expression(label, components);
+    };
+    auto F = op("f", {"o+ o", "v+ o", "o+ v", "v+ v"});
+    auto V = op("v", {"o+ o+ o o", "v+ o+ o o", "o+ o+ v o", "v+ v+ o o",
+                      "o+ o+ v v", "v+ o+ v o", "v+ v+ v o", "v+ o+ v v",
+                      "v+ v+ v v"});
+    auto T = op("t", {"v+ o"}) + op("t", {"v+ v+ o o"});
+    WickTheorem wt;
+    const auto ccsd = wt.contract(scalar_t(1), bch_series(F + V, T, 4), 0, 4);
+    for (const auto &[term, c] : ccsd.terms()) {
+      SymbolicTerm shuffled = term;
+      std::shuffle(shuffled.tensors().begin(), shuffled.tensors().end(), rng);
+      terms.push_back(shuffled);
+    }
+  }
+  bench("SymbolicTerm::canonicalize", terms.size(), [&] {
+    for (const auto &term : terms) {
+      SymbolicTerm copy = term;
+      sink = sink + (copy.canonicalize() == scalar_t(1));
+    }
+  });
+
+  // Expression::add of random terms into an empty expression
+  for (size_t size : {100, 1000, 10000}) {
+    std::vector<SymbolicTerm> random_terms;
+    for (size_t i = 0; i < size; i++) {
+      random_terms.push_back(random_term(rng));
+    }
+    bench(fmt::format("Expression::add/{}", size), size, [&] {
+      Expression expr;
+      for (const auto &term : random_terms) {
+        expr.add(term, scalar_t(1));
+      }
+      sink = sink + expr.size();
+    });
+  }
+
+  // GraphMatrix arithmetic
+  std::vector<GraphMatrix> graph_matrices;
+  {
+    std::uniform_int_distribution<int> count(0, 2);
+    for (size_t i = 0; i < n; i++) {
+      std::vector<int> cre(3), ann(3);
+      for (int s = 0; s < 3; s++) {
+        cre[s] = count(rng);
+        ann[s] = count(rng);
+      }
+      graph_matrices.push_back(GraphMatrix(cre, ann));
+    }
+  }
+  bench("GraphMatrix/add_subtract", n, [&] {
+    GraphMatrix sum;
+    for (const auto &g : graph_matrices) {
+      sum += g;
+      sum += g;
+      sum -= g;
+    }
+    sink = sink + sum.num_ops();
+  });
+  bench("GraphMatrix/compare", n, [&] {
+    for (size_t i = 1; i < n; i++) {
+      sink = sink + (graph_matrices[i - 1] < graph_matrices[i]);
+    }
+  });
+
+  // integer_partitions
+  for (int k : {4, 8, 12}) {
+    bench(fmt::format("integer_partitions/{}", k), 1,
+          [&] { sink = sink + integer_partitions(k).size(); });
+  }
+  return results;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  options opts;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if ((arg == "--samples") and (i + 1 < argc)) {
+      opts.samples = std::max(1, std::atoi(argv[++i]));
+    } else if ((arg == "--seed") and (i + 1 < argc)) {
+      opts.seed = std::strtoul(argv[++i], nullptr, 10);
+    } else if ((arg == "--output") and (i + 1 < argc)) {
+      opts.output = argv[++i];
+    } else if ((arg == "--help") or (arg == "-h")) {
+      std::cout << "Usage: wicked_microbench [--samples N] [--seed N] "
+                   "[--output FILE] [filter]\n";
+      return 0;
+    } else {
+      opts.filter = arg;
+    }
+  }
+
+  // the orbital spaces used by all the benchmarks (spaces 0 and 1)
+  auto osi = std::make_shared<OrbitalSpaceInfo>();
+  osi->add_space('o', FieldType::Fermion, SpaceType::Occupied,
+                 {"i", "j", "k", "l", "m", "n"});
+  osi->add_space('v', FieldType::Fermion, SpaceType::Unoccupied,
+                 {"a", "b", "c", "d", "e", "f"});
+  osi_scope scope(osi);
+
+  const auto results = run(opts);
+
+  std::string json = fmt::format("{{\n"
+                                 "  \"benchmark\": \"wicked_microbench\",\n"
+                                 "  \"version\": 1,\n"
+                                 "  \"boost_1024_int\": {},\n"
+                                 "  \"samples\": {},\n"
+                                 "  \"seed\": {},\n"
+                                 "  \"unit\": \"ns per item\",\n"
+                                 "  \"results\": [\n",
+                                 use_boost_1024_int(), opts.samples,
+                                 opts.seed);
+  for (size_t i = 0; i < results.size(); i++) {
+    const auto &r = results[i];
+    json += fmt::format(
+        "    {{\"name\": \"{}\", \"items\": {}, \"iterations\": {}, "
+        "\"min\": {:.3f}, \"median\": {:.3f}, \"mean\": {:.3f}, "
+        "\"stddev\": {:.3f}}}{}\n",
+        r.name, r.items, r.iterations, r.min, r.median, r.mean, r.stddev,
+        i + 1 < results.size() ? "," : "");
+  }
+  json += "  ]\n}\n";
+
+  if (opts.output.empty()) {
+    std::cout << json;
+  } else {
+    std::ofstream file(opts.output);
+    if (not file) {
+      std::cerr << "wicked_microbench: cannot open the file " << opts.output
+                << std::endl;
+      return 1;
+    }
+    file << json;
+  }
+  return 0;
+}
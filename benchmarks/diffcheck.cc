@@ -0,0 +1,450 @@
+// Differential checking of the contraction engine on random workloads
+//
+// Usage: wicked_diffcheck [--cases N] [--seed N] [--no-minimize]
+//                         [--output FILE]
+//
+// Each case is a product of two or three random operators defined over random
+// orbital spaces (occupied, unoccupied, and general), contracted with a random
+// range of ranks. Case i is generated from the seed seed + i, so a failing
+// case can be reproduced with --seed seed + i --cases 1. Every case is
+// contracted in several modes that must give the same Expression:
+//
+//   graph        graph canonicalization on (the reference)
+//   no-graph     graph canonicalization off
+//   per-product  each product of operators contracted separately
+//   thread-pool  the products contracted concurrently on the thread pool
+//
+// When profiling is enabled, the number of contractions predicted by
+// WickTheorem::estimate is also checked. Failing cases are reduced by removing
+// operators, components, second quantized operators, spaces, and ranks while
+// the failure persists, and are printed as Python scripts. The time spent in
+// each mode and the failures are written in the JSON format.
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "fmt/format.h"
+
+#include "algebra/expression.h"
+#include "diagrams/operator.h"
+#include "diagrams/operator_expression.h"
+#include "diagrams/wick_theorem.h"
+#include "helpers/orbital_space.h"
+#include "helpers/profile.h"
+#include "helpers/thread_pool.hpp"
+#include "helpers/timer.hpp"
+
+namespace {
+
+const std::vector<std::string> mode_names = {"graph", "no-graph",
+                                             "per-product", "thread-pool"};
+
+/// The labels used for the orbital spaces and their indices
+const std::vector<char> space_labels = {'o', 'v', 'a', 'g'};
+const std::vector<std::vector<std::string>> space_indices = {
+    {"i", "j", "k", "l", "m", "n"},
+    {"a", "b", "c", "d", "e", "f"},
+    {"u", "v", "w", "x", "y", "z"},
+    {"p", "q", "r", "s", "t", "g"}};
+
+/// The number of creation and annihilation operators in each space
+struct component {
+  std::vector<int> cre;
+  std::vector<int> ann;
+
+  int num_ops() const {
+    int n = 0;
+    for (size_t s = 0; s < cre.size(); s++) {
+      n += cre[s] + ann[s];
+    }
+    return n;
+  }
+};
+
+/// A random workload: the product of the operators in factors, contracted
+/// with rank in [minrank, maxrank]
+struct case_spec {
+  std::vector<SpaceType> spaces;
+  /// each factor is a sum of components
+  std::vector<std::vector<component>> factors;
+  int minrank = 0;
+  int maxrank = 0;
+};
+
+std::string space_type_str(SpaceType type) {
+  switch (type) {
+  case SpaceType::Occupied:
+    return "occupied";
+  case SpaceType::Unoccupied:
+    return "unoccupied";
+  default:
+    return "general";
+  }
+}
+
+std::string component_str(const component &c) {
+  std::vector<std::string> sqops;
+  for (size_t s = 0; s < c.cre.size(); s++) {
+    sqops.insert(sqops.end(), c.cre[s], std::string(1, space_labels[s]) + "+");
+  }
+  for (size_t s = 0; s < c.ann.size(); s++) {
+    sqops.insert(sqops.end(), c.ann[s], std::string(1, space_labels[s]));
+  }
+  std::string str;
+  for (const auto &sqop : sqops) {
+    str += (str.empty() ? "" : " ") + sqop;
+  }
+  return str;
+}
+
+std::string factor_label(int f) { return std::string(1, 'A' + f); }
+
+/// Return a Python script that reproduces a case
+std::string python_str(const case_spec &c) {
+  std::string s = "import wicked as w\n\nw.reset_space()\n";
+  for (size_t i = 0; i < c.spaces.size(); i++) {
+    std::string indices;
+    for (const auto &idx : space_indices[i]) {
+      indices += fmt::format("{}\"{}\"", indices.empty() ? "" : ", ", idx);
+    }
+    s += fmt::format("w.add_space(\"{}\", \"fermion\", \"{}\", [{}])\n",
+                     space_labels[i], space_type_str(c.spaces[i]), indices);
+  }
+  std::string product;
+  for (size_t f = 0; f < c.factors.size(); f++) {
+    std::string components;
+    for (const auto &comp : c.factors[f]) {
+      components += fmt::format("{}\"{}\"", components.empty() ? "" : ", ",
+                                component_str(comp));
+    }
+    s += fmt::format("{} = w.op(\"{}\", [{}])\n", factor_label(f),
+                     factor_label(f), components);
+    product += (product.empty() ? "" : " @ ") + factor_label(f);
+  }
+  s += fmt::format("wt = w.WickTheorem()\nwt.contract({}, {}, {})\n", product,
+                   c.minrank, c.maxrank);
+  return s;
+}
+
+/// Generate a random case. The products of operators have at most 10 second
+/// quantized operators, so that each case takes at most a fraction of a second
+case_spec random_case(unsigned seed) {
+  std::mt19937 rng(seed);
+  auto uniform = [&](int a, int b) {
+    return std::uniform_int_distribution<int>(a, b)(rng);
+  };
+  case_spec c;
+  const int nspaces = uniform(1, 3);
+  for (int s = 0; s < nspaces; s++) {
+    c.spaces.push_back(static_cast<SpaceType>(uniform(0, 2)));
+  }
+  const int nfactors = uniform(2, 3);
+  const int max_ops_per_factor = 10 / nfactors;
+  int total_ops = 0;
+  for (int f = 0; f < nfactors; f++) {
+    std::vector<component> factor;
+    const int ncomponents = uniform(1, 3);
+    for (int k = 0; k < ncomponents; k++) {
+      component comp{std::vector<int>(nspaces, 0),
+                     std::vector<int>(nspaces, 0)};
+      const int nops = uniform(1, std::min(4, max_ops_per_factor));
+      for (int n = 0; n < nops; n++) {
+        auto &counts = uniform(0, 1) ? comp.cre : comp.ann;
+        counts[uniform(0, nspaces - 1)] += 1;
+      }
+      factor.push_back(comp);
+    }
+    int max_ops = 0;
+    for (const auto &comp : factor) {
+      max_ops = std::max(max_ops, comp.num_ops());
+    }
+    total_ops += max_ops;
+    c.factors.push_back(factor);
+  }
+  c.minrank = uniform(0, 2);
+  c.maxrank = std::min(total_ops, c.minrank + uniform(0, 6));
+  return c;
+}
+
+/// Contract a case in all the modes and return a description of the first
+/// disagreement (empty if all modes agree). If times is not null, the time
+/// spent in each mode is added to it
+std::string check(const case_spec &c, std::vector<double> *times = nullptr) {
+  auto osi = std::make_shared<OrbitalSpaceInfo>();
+  for (size_t s = 0; s < c.spaces.size(); s++) {
+    osi->add_space(space_labels[s], FieldType::Fermion, c.spaces[s],
+                   space_indices[s]);
+  }
+  osi_scope scope(osi);
+
+  try {
+    OperatorExpression expr;
+    for (size_t f = 0; f < c.factors.size(); f++) {
+      OperatorExpression factor;
+      for (const auto &comp : c.factors[f]) {
+        factor.add({Operator(factor_label(f), comp.cre, comp.ann)});
+      }
+      expr = (f == 0) ? factor : expr * factor;
+    }
+
+    std::vector<Expression> results;
+    auto run_mode = [&](int mode, const std::function<Expression()> &fn) {
+      timer t;
+      results.push_back(fn());
+      if (times) {
+        (*times)[mode] += t.get();
+      }
+    };
+
+    WickTheorem wt;
+    reset_profile();
+    run_mode(0, [&] {
+      return wt.contract(scalar_t(1), expr, c.minrank, c.maxrank);
+    });
+    if (profile_enabled()) {
+      uint64_t predicted = 0;
+      for (const auto &e : wt.estimate(expr, c.minrank, c.maxrank)) {
+        predicted += e.contractions;
+      }
+      const uint64_t counted = profile()[Counter::CompositeContractions];
+      if (predicted != counted) {
+        return fmt::format("estimate predicts {} contractions, contract() "
+                           "generated {}",
+                           predicted, counted);
+      }
+    }
+
+    WickTheorem wt_no_graph;
+    wt_no_graph.do_canonicalize_graph(false);
+    run_mode(1, [&] {
+      return wt_no_graph.contract(scalar_t(1), expr, c.minrank, c.maxrank);
+    });
+
+    run_mode(2, [&] {
+      Expression sum;
+      for (const auto &[ops, f] : expr.terms()) {
+        sum += wt.contract(f, ops, c.minrank, c.maxrank);
+      }
+      return sum;
+    });
+
+    run_mode(3, [&] {
+      std::vector<std::future<Expression>> futures;
+      for (const auto &[ops, f] : expr.terms()) {
+        futures.push_back(default_thread_pool().submit(
+            [&wt, ops = ops, f = f, &c] {
+              return wt.contract(f, ops, c.minrank, c.maxrank);
+            }));
+      }
+      Expression sum;
+      for (auto &future : futures) {
+        sum += future.get();
+      }
+      return sum;
+    });
+
+    for (size_t mode = 1; mode < results.size(); mode++) {
+      if (not(results[mode] == results[0])) {
+        return fmt::format("mode {} disagrees with mode {}:\n{}\n{}:\n{}",
+                           mode_names[mode], mode_names[0], results[0].str(),
+                           mode_names[mode], results[mode].str());
+      }
+    }
+  } catch (const std::exception &e) {
+    return std::string("exception: ") + e.what();
+  }
+  return "";
+}
+
+/// Return the cases obtained by removing one part of c
+std::vector<case_spec> reductions(const case_spec &c) {
+  std::vector<case_spec> result;
+  // remove a factor
+  if (c.factors.size() > 1) {
+    for (size_t f = 0; f < c.factors.size(); f++) {
+      case_spec r = c;
+      r.factors.erase(r.factors.begin() + f);
+      result.push_back(r);
+    }
+  }
+  for (size_t f = 0; f < c.factors.size(); f++) {
+    // remove a component
+    if (c.factors[f].size() > 1) {
+      for (size_t k = 0; k < c.factors[f].size(); k++) {
+        case_spec r = c;
+        r.factors[f].erase(r.factors[f].begin() + k);
+        result.push_back(r);
+      }
+    }
+    // remove a second quantized operator
+    for (size_t k = 0; k < c.factors[f].size(); k++) {
+      if (c.factors[f][k].num_ops() < 2) {
+        continue;
+      }
+      for (size_t s = 0; s < c.spaces.size(); s++) {
+        for (bool cre : {true, false}) {
+          case_spec r = c;
+          auto &counts = cre ? r.factors[f][k].cre : r.factors[f][k].ann;
+          if (counts[s] > 0) {
+            counts[s] -= 1;
+            result.push_back(r);
+          }
+        }
+      }
+    }
+  }
+  // remove a space that is not used
+  for (size_t s = 0; (c.spaces.size() > 1) and (s < c.spaces.size()); s++) {
+    bool used = false;
+    for (const auto &factor : c.factors) {
+      for (const auto &comp : factor) {
+        used = used or (comp.cre[s] + comp.ann[s] > 0);
+      }
+    }
+    if (not used) {
+      case_spec r = c;
+      r.spaces.erase(r.spaces.begin() + s);
+      for (auto &factor : r.factors) {
+        for (auto &comp : factor) {
+          comp.cre.erase(comp.cre.begin() + s);
+          comp.ann.erase(comp.ann.begin() + s);
+        }
+      }
+      result.push_back(r);
+    }
+  }
+  // make a space simpler (general -> occupied)
+  for (size_t s = 0; s < c.spaces.size(); s++) {
+    if (c.spaces[s] == SpaceType::General) {
+      case_spec r = c;
+      r.spaces[s] = SpaceType::Occupied;
+      result.push_back(r);
+    }
+  }
+  // narrow the range of ranks
+  if (c.minrank < c.maxrank) {
+    case_spec r = c;
+    r.minrank += 1;
+    result.push_back(r);
+    r = c;
+    r.maxrank -= 1;
+    result.push_back(r);
+  }
+  return result;
+}
+
+/// Reduce a failing case while it keeps failing
+case_spec minimize(case_spec c, std::string &message) {
+  bool reduced = true;
+  while (reduced) {
+    reduced = false;
+    for (const auto &r : reductions(c)) {
+      std::string msg = check(r);
+      if (not msg.empty()) {
+        c = r;
+        message = msg;
+        reduced = true;
+        break;
+      }
+    }
+  }
+  return c;
+}
+
+std::string json_escape(const std::string &s) {
+  std::string result;
+  for (char ch : s) {
+    if (ch == '"' or ch == '\\') {
+      result += '\\';
+      result += ch;
+    } else if (ch == '\n') {
+      result += "\\n";
+    } else {
+      result += ch;
+    }
+  }
+  return result;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int ncases = 100;
+  unsigned seed = 1;
+  bool do_minimize = true;
+  std::string output;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if ((arg == "--cases") and (i + 1 < argc)) {
+      ncases = std::atoi(argv[++i]);
+    } else if ((arg == "--seed") and (i + 1 < argc)) {
+      seed = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--no-minimize") {
+      do_minimize = false;
+    } else if ((arg == "--output") and (i + 1 < argc)) {
+      output = argv[++i];
+    } else {
+      std::cout << "Usage: wicked_diffcheck [--cases N] [--seed N] "
+                   "[--no-minimize] [--output FILE]\n";
+      return arg == "--help" or arg == "-h" ? 0 : 1;
+    }
+  }
+  enable_profile(true);
+
+  std::vector<double> times(mode_names.size(), 0.0);
+  std::vector<std::string> failures;
+  for (int i = 0; i < ncases; i++) {
+    const unsigned case_seed = seed + i;
+    case_spec c = random_case(case_seed);
+    std::string message = check(c, &times);
+    if (message.empty()) {
+      continue;
+    }
+    std::cerr << fmt::format("Case with seed {} failed: {}\n", case_seed,
+                             message);
+    if (do_minimize) {
+      c = minimize(c, message);
+      std::cerr << "Reduced case:\n" << python_str(c) << message << "\n";
+    }
+    failures.push_back(fmt::format(
+        "    {{\"seed\": {}, \"message\": \"{}\", \"python\": \"{}\"}}",
+        case_seed, json_escape(message), json_escape(python_str(c))));
+  }
+
+  std::string json = fmt::format("{{\n"
+                                 "  \"benchmark\": \"wicked_diffcheck\",\n"
+                                 "  \"version\": 1,\n"
+                                 "  \"seed\": {},\n"
+                                 "  \"cases\": {},\n"
+                                 "  \"times\": {{",
+                                 seed, ncases);
+  for (size_t mode = 0; mode < mode_names.size(); mode++) {
+    json += fmt::format("{}\"{}\": {:.6f}", mode ? ", " : "",
+                        mode_names[mode], times[mode]);
+  }
+  json += "},\n  \"failures\": [\n";
+  for (size_t i = 0; i < failures.size(); i++) {
+    json += failures[i] + (i + 1 < failures.size() ? ",\n" : "\n");
+  }
+  json += "  ]\n}\n";
+
+  if (output.empty()) {
+    std::cout << json;
+  } else {
+    std::ofstream file(output);
+    if (not file) {
+      std::cerr << "wicked_diffcheck: cannot open the file " << output
+                << std::endl;
+      return 1;
+    }
+    file << json;
+  }
+  return failures.empty() ? 0 : 1;
+}
@@ -0,0 +1,5 @@
+# Config file used by find_package(wicked). It defines the target
+# wicked::wicked_core
+include(CMakeFindDependencyMacro)
+find_dependency(Threads)
+include("${CMAKE_CURRENT_LIST_DIR}/wickedTargets.cmake")
@@ -72,12 +72,16 @@ class CMakeBuild(build_ext):
         )
 
         cmake_args += [f"-DCODE_COVERAGE={str(self.code_coverage).upper()}"]
+        cmake_args += ["-DBUILD_BENCHMARKS=OFF"]
 
         if not os.path.exists(self.build_temp):
             os.makedirs(self.build_temp)
 
         subprocess.check_call(["cmake"] + cmake_args)
-        subprocess.check_call(["cmake", "--build", ".", "-j2"] + build_args)
+        # build only the Python module (not the tools and benchmarks)
+        subprocess.check_call(
+            ["cmake", "--build", ".", "--target", "_wicked", "-j2"] + build_args
+        )
 
         print()  # Add empty line for nicer output
 
@@ -0,0 +1,53 @@
+import wicked as w
+
+
+def initialize():
+    w.reset_space()
+    w.add_space("c", "fermion", "occupied", ["i", "j", "k", "l", "m", "n"])
+    w.add_space("a", "fermion", "general", ["u", "v", "w", "x", "y", "z"])
+    w.add_space("v", "fermion", "unoccupied", ["a", "b", "c", "d", "e", "f"])
+
+
+def test_expression_adjoint():
+    """Test that contraction commutes with taking the adjoint"""
+    initialize()
+    F = w.gen_op("f", 1, "cav", "cav")
+    T = w.op("t", ["a+ c", "v+ c", "v+ a", "v+ v+ c c", "v+ a+ a c"])
+    wt = w.WickTheorem()
+    for maxrank in [0, 2, 4]:
+        val = wt.contract(F @ T, 0, maxrank).adjoint()
+        ref = wt.contract(T.adjoint() @ F.adjoint(), 0, maxrank)
+        assert val == ref
+        assert val.adjoint() == wt.contract(F @ T, 0, maxrank)
+
+
+def test_adjoint_symmetry():
+    """Test the reuse of the contractions of adjoint products"""
+    initialize()
+    H = w.gen_op("f", 1, "cav", "cav") + w.gen_op("v", 2, "cav", "cav")
+    T = w.gen_op("t", 1, "av", "ca", diagonal=False)
+    T += w.gen_op("t", 2, "av", "ca", diagonal=False)
+    A = T - T.adjoint()
+
+    wt = w.WickTheorem()
+    wt_adjoint = w.WickTheorem()
+    wt_adjoint.use_adjoint_symmetry(True)
+    expr = w.commutator(H, A)
+    for maxrank in [0, 2, 4]:
+        ref = wt.contract(expr, 0, maxrank)
+        assert wt_adjoint.contract(expr, 0, maxrank) == ref
+
+    # the products may be canonicalized
+    expr = w.commutator(w.gen_op("f", 1, "cav", "cav"), A, A)
+    expr.canonicalize()
+    ref = wt.contract(expr, 0, 2)
+    assert wt_adjoint.contract(expr, 0, 2) == ref
+
+    # products with no adjoint are contracted as usual
+    expr = H @ T
+    assert wt_adjoint.contract(expr, 0, 2) == wt.contract(expr, 0, 2)
+
+
+if __name__ == "__main__":
+    test_expression_adjoint()
+    test_adjoint_symmetry()
@@ -0,0 +1,52 @@
+import threading
+
+import wicked as w
+
+
+def initialize():
+    w.reset_space()
+    w.add_space("o", "fermion", "occupied", ["i", "j", "k", "l", "m", "n"])
+    w.add_space("v", "fermion", "unoccupied", ["a", "b", "c", "d", "e", "f"])
+
+
+def test_contract_async():
+    """Test that asynchronous contractions give the same result as contract"""
+    initialize()
+    T1 = w.op("t", ["v+ o"])
+    T2 = w.op("t", ["v+ v+ o o"])
+    V = w.op("v", ["o+ o+ v v", "v+ v+ o o", "v+ o+ v o"])
+    wt = w.WickTheorem()
+
+    exprs = [w.commutator(V, T2), w.commutator(w.commutator(V, T1), T2)]
+    futures = [wt.contract_async(expr, 0, 4) for expr in exprs]
+    future = wt.contract_async(w.rational(1, 2), exprs[0], 0, 2)
+    for expr, f in zip(exprs, futures):
+        assert f.result() == wt.contract(expr, 0, 4)
+        assert f.done()
+    assert future.result() == wt.contract(w.rational(1, 2), exprs[0], 0, 2)
+
+
+def test_contract_threads():
+    """Test contractions running on several Python threads"""
+    initialize()
+    T2 = w.op("t", ["v+ v+ o o"])
+    V = w.op("v", ["o+ o+ v v", "v+ v+ o o", "v+ o+ v o"])
+    wt = w.WickTheorem()
+    ref = wt.contract(w.commutator(w.commutator(V, T2), T2), 0, 4)
+
+    results = [None] * 4
+
+    def run(i):
+        results[i] = wt.contract(w.commutator(w.commutator(V, T2), T2), 0, 4)
+
+    threads = [threading.Thread(target=run, args=(i,)) for i in range(4)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    assert all(r == ref for r in results)
+
+
+if __name__ == "__main__":
+    test_contract_async()
+    test_contract_threads()
@@ -0,0 +1,100 @@
+import os
+
+import pytest
+import wicked as w
+
+
+def initialize():
+    w.reset_space()
+    w.add_space("o", "fermion", "occupied", ["i", "j", "k", "l", "m", "n"])
+    w.add_space("v", "fermion", "unoccupied", ["a", "b", "c", "d", "e", "f"])
+
+
+def ccsd_hbar():
+    F = w.op("f", ["o+ o", "v+ o", "o+ v", "v+ v"])
+    V = w.op("v", ["o+ o+ v v", "v+ v+ o o", "v+ o+ v o"])
+    T = w.op("t", ["v+ o", "v+ v+ o o"])
+    return w.bch_series(F + V, T, 4)
+
+
+def test_checkpoint_resume(tmp_path):
+    """Test that an interrupted contraction resumes from its checkpoint"""
+    initialize()
+    expr = ccsd_hbar()
+    reference = w.WickTheorem().contract(expr, 0, 4)
+
+    path = str(tmp_path / "ccsd.checkpoint")
+    wt = w.WickTheorem()
+    wt.set_checkpoint(path, 0.0)
+    # interrupt the contraction by exceeding a memory limit
+    wt.set_memory_limit(2000)
+    with pytest.raises(RuntimeError):
+        wt.contract(expr, 0, 4)
+    assert os.path.exists(path)
+    with open(path) as f:
+        assert f.readline() == "wicked checkpoint 1\n"
+
+    wt.set_memory_limit(0)
+    assert wt.contract(expr, 0, 4) == reference
+    assert not os.path.exists(path)
+
+
+def test_checkpoint_mismatch(tmp_path):
+    """Test that a checkpoint of another contraction is rejected"""
+    initialize()
+    expr = ccsd_hbar()
+    path = str(tmp_path / "ccsd.checkpoint")
+    wt = w.WickTheorem()
+    wt.set_checkpoint(path, 0.0)
+    wt.set_memory_limit(2000)
+    with pytest.raises(RuntimeError):
+        wt.contract(expr, 0, 4)
+    wt.set_memory_limit(0)
+    with pytest.raises(RuntimeError):
+        wt.contract(expr, 0, 2)
+    # without resuming, the file is overwritten
+    wt.set_checkpoint(path, 0.0, False)
+    wt.contract(expr, 0, 2)
+    assert not os.path.exists(path)
+
+
+def test_checkpoint_settings(tmp_path):
+    """Test that a checkpoint written with other spaces or settings is not used"""
+    initialize()
+    path = str(tmp_path / "ccsd.checkpoint")
+    wt = w.WickTheorem()
+    wt.set_checkpoint(path, 0.0)
+    wt.set_memory_limit(2000)
+    with pytest.raises(RuntimeError):
+        wt.contract(ccsd_hbar(), 0, 4)
+    wt.set_memory_limit(0)
+
+    # the same expression with other indices for the occupied space
+    w.reset_space()
+    w.add_space("o", "fermion", "occupied", ["m", "n", "o", "p", "q", "r"])
+    w.add_space("v", "fermion", "unoccupied", ["a", "b", "c", "d", "e", "f"])
+    expr = ccsd_hbar()
+    reference = w.WickTheorem().contract(expr, 0, 4)
+    with pytest.raises(RuntimeError):
+        wt.contract(expr, 0, 4)
+
+    # the same spaces and expression with another maximum cumulant
+    initialize()
+    wt.set_max_cumulant(2)
+    with pytest.raises(RuntimeError):
+        wt.contract(ccsd_hbar(), 0, 4)
+    wt.set_max_cumulant(100)
+
+    # without resuming, the file is overwritten
+    w.reset_space()
+    w.add_space("o", "fermion", "occupied", ["m", "n", "o", "p", "q", "r"])
+    w.add_space("v", "fermion", "unoccupied", ["a", "b", "c", "d", "e", "f"])
+    wt.set_checkpoint(path, 0.0, False)
+    assert wt.contract(expr, 0, 4) == reference
+    assert not os.path.exists(path)
+
+
+if __name__ == "__main__":
+    test_checkpoint_resume()
+    test_checkpoint_mismatch()
+    test_checkpoint_settings()
@@ -0,0 +1,37 @@
+import wicked as w
+
+
+def initialize():
+    w.reset_space()
+    w.add_space("o", "fermion", "occupied", ["i", "j", "k", "l", "m", "n"])
+    w.add_space("v", "fermion", "unoccupied", ["a", "b", "c", "d", "e", "f"])
+
+
+def test_estimate():
+    """Test that the estimated number of contractions matches contract()"""
+    initialize()
+    T1 = w.op("t", ["v+ o"])
+    T2 = w.op("t", ["v+ v+ o o"])
+    V = w.op("v", ["o+ o+ v v", "v+ v+ o o", "v+ o+ v o"])
+    expr = w.commutator(w.commutator(V, T1), T2)
+    wt = w.WickTheorem()
+
+    for maxrank in [0, 2, 4]:
+        estimates = wt.estimate(expr, 0, maxrank)
+        assert len(estimates) == expr.size()
+
+        w.enable_profile(True)
+        w.reset_profile()
+        result = wt.contract(expr, 0, maxrank)
+        w.enable_profile(False)
+        p = w.profile()
+        assert p.composite_contractions == sum(e.contractions for e in estimates)
+        assert p.operator_permutations == sum(
+            e.operator_permutations for e in estimates
+        )
+        assert result.size() <= sum(e.terms for e in estimates)
+        assert wt.memory()["peak"] <= max(e.bytes for e in estimates)
+
+
+if __name__ == "__main__":
+    test_estimate()
@@ -1,3 +1,4 @@
+import pytest
 import wicked as w
 
 
@@ -21,7 +22,7 @@ def test_mr1():
     wt = w.WickTheorem()
     val = wt.contract(w.rational(1), Faa @ T1aa, 0, 0)
     ref = w.utils.string_to_expr(
-        """eta1^{a1}_{a0} f^{a0}_{a2} gamma1^{a2}_{a3} t^{a3}_{a1}"
+        """eta1^{a1}_{a0} f^{a0}_{a2} gamma1^{a2}_{a3} t^{a3}_{a1}
 f^{a1}_{a0} lambda2^{a0,a3}_{a1,a2} t^{a2}_{a3}"""
     )
     print_comparison(val, ref)
@@ -69,7 +70,31 @@ def test_mr3():
     ref = w.utils.string_to_expr(ref_expr)
 
 
+def test_mr_composite_space():
+    """Test that operators in a composite space are expanded when contracted"""
+    initialize()
+    w.add_composite_space("g", ["o", "a", "v"])
+    H = w.op("h", ["g+ g", "g+ g+ g g"])
+    assert str(H) == "+ h { g+ g }\n+ 1/4 h { g+ g+ g g }"
+    H_elementary = w.gen_op("h", 1, "oav", "oav") + w.gen_op("h", 2, "oav", "oav")
+    assert w.expand_composite_spaces(H) == H_elementary
+    T = w.op("t", ["a+ o", "v+ o", "v+ a", "v+ v+ o o", "a+ v+ o o", "v+ v+ a o"])
+
+    wt = w.WickTheorem()
+    for maxrank in [0, 2, 4]:
+        val = wt.contract(w.rational(1), H @ T @ T, 0, maxrank)
+        ref = wt.contract(w.rational(1), H_elementary @ T @ T, 0, maxrank)
+        assert val == ref
+
+    # composite spaces are expanded before serialization
+    with pytest.raises(RuntimeError):
+        H.to_bytes()
+    with pytest.raises(RuntimeError):
+        w.add_composite_space("a", ["o", "v"])
+
+
 if __name__ == "__main__":
     test_mr1()
     test_mr2()
     test_mr3()
+    test_mr_composite_space()
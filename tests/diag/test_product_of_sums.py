@@ -0,0 +1,31 @@
+import wicked as w
+
+
+def initialize():
+    w.reset_space()
+    w.add_space("o", "fermion", "occupied", ["i", "j", "k", "l", "m", "n"])
+    w.add_space("v", "fermion", "unoccupied", ["a", "b", "c", "d", "e", "f"])
+
+
+def test_product_of_sums():
+    """Test that a product of sums is contracted like its expansion"""
+    initialize()
+    F = w.op("f", ["o+ o", "v+ o", "o+ v", "v+ v"])
+    V = w.op("v", ["o+ o+ v v", "v+ v+ o o", "v+ o+ v o"])
+    T = w.op("t", ["v+ o", "v+ v+ o o"])
+    wt = w.WickTheorem()
+
+    for factors in [[F + V, T], [F + V, T, T], [F, V, T, T]]:
+        expanded = factors[0]
+        for factor in factors[1:]:
+            expanded = expanded @ factor
+        for minrank, maxrank in [(0, 0), (2, 2), (0, 4)]:
+            ref = wt.contract(expanded, minrank, maxrank)
+            assert wt.contract(factors, minrank, maxrank) == ref
+            val = wt.contract(w.rational(-1, 2), factors, minrank, maxrank)
+            ref *= w.rational(-1, 2)
+            assert val == ref
+
+
+if __name__ == "__main__":
+    test_product_of_sums()
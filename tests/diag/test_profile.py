@@ -0,0 +1,104 @@
+import json
+
+import pytest
+
+import wicked as w
+
+
+def initialize():
+    w.reset_space()
+    w.add_space("o", "fermion", "occupied", ["i", "j", "k", "l", "m", "n"])
+    w.add_space("v", "fermion", "unoccupied", ["a", "b", "c", "d", "e", "f"])
+
+
+def test_profile():
+    """Test the performance counters"""
+    initialize()
+    T2 = w.op("t", ["v+ v+ o o"])
+    V = w.op("v", ["o+ o+ v v", "v+ v+ o o", "v+ o+ v o"])
+    wt = w.WickTheorem()
+
+    w.enable_profile(False)
+    w.reset_profile()
+    wt.contract(w.commutator(V, T2), 0, 0)
+    assert w.profile().composite_contractions == 0
+
+    w.enable_profile(True)
+    assert w.profile_enabled()
+    wt.contract(w.commutator(V, T2), 0, 0)
+    w.enable_profile(False)
+    p = w.profile()
+    assert p.elementary_contractions > 0
+    assert p.operator_permutations > 0
+    # only the product v^{ij}_{ab} t^{ab}_{ij} can be fully contracted
+    assert p.composite_contractions == 1
+    assert p.terms_cancelled == 0
+    # [V,T2] has 6 products of operators: 3 V T2 and 3 T2 V
+    assert len(p.product_time) == 6
+
+    w.reset_profile()
+    assert w.profile().composite_contractions == 0
+
+
+def test_trace(tmp_path):
+    """Test writing a trace of the contractions"""
+    initialize()
+    T2 = w.op("t", ["v+ v+ o o"])
+    V = w.op("v", ["o+ o+ v v", "v+ v+ o o", "v+ o+ v o"])
+    wt = w.WickTheorem()
+
+    path = str(tmp_path / "trace.json")
+    with w.trace(path):
+        wt.contract(w.commutator(V, T2), 0, 0)
+
+    with open(path) as f:
+        events = json.load(f)["traceEvents"]
+    contract_events = [e for e in events if e["name"] == "contract"]
+    assert len(contract_events) == 6
+    assert {e["args"]["operators"] for e in contract_events} == {"v t", "t v"}
+    # the phases of a contraction are nested within it (times are rounded to
+    # 1 ns)
+    steps = [e for e in events if e["name"] == "composite contractions"]
+    assert len(steps) == 6
+    for step in steps:
+        assert any(
+            c["ts"] <= step["ts"] + 0.01
+            and step["ts"] + step["dur"] <= c["ts"] + c["dur"] + 0.01
+            for c in contract_events
+        )
+
+
+def test_memory():
+    """Test the memory accounting and the memory limit"""
+    initialize()
+    T2 = w.op("t", ["v+ v+ o o"])
+    V = w.op("v", ["o+ o+ v v", "v+ v+ o o", "v+ o+ v o"])
+    wt = w.WickTheorem()
+    result = wt.contract(w.commutator(V, T2), 0, 0)
+
+    memory = wt.memory()
+    assert memory["elementary contractions"] > 0
+    assert memory["peak"] >= memory["result"] > 0
+    assert memory["peak"] >= memory["elementary contractions"]
+
+    # a limit above the peak does not change the result
+    wt.set_memory_limit(memory["peak"])
+    assert wt.contract(w.commutator(V, T2), 0, 0) == result
+
+    wt.set_memory_limit(1)
+    with pytest.raises(RuntimeError, match="exceeds the limit"):
+        wt.contract(w.commutator(V, T2), 0, 0)
+
+    # a limit of zero turns off the check
+    wt.set_memory_limit(0)
+    assert wt.contract(w.commutator(V, T2), 0, 0) == result
+
+
+if __name__ == "__main__":
+    import pathlib
+    import tempfile
+
+    test_profile()
+    test_memory()
+    with tempfile.TemporaryDirectory() as d:
+        test_trace(pathlib.Path(d))
@@ -0,0 +1,53 @@
+import wicked as w
+
+
+def initialize():
+    w.reset_space()
+    w.add_space("o", "fermion", "occupied", ["i", "j", "k", "l", "m", "n"])
+    w.add_space("v", "fermion", "unoccupied", ["a", "b", "c", "d", "e", "f"])
+
+
+def ccsd_hbar():
+    F = w.op("f", ["o+ o", "v+ o", "o+ v", "v+ v"])
+    V = w.op("v", ["o+ o+ v v", "v+ v+ o o", "v+ o+ v o"])
+    T = w.op("t", ["v+ o", "v+ v+ o o"])
+    return w.bch_series(F + V, T, 2)
+
+
+def check_shards(expr, shards, wt):
+    assert sum(s.size() for s in shards) == expr.size()
+    total = w.Expression()
+    for s in shards:
+        total += wt.contract(s, 0, 4)
+    assert total == wt.contract(expr, 0, 4)
+
+
+def test_shard_by_hash():
+    """Test that the contractions of the shards add up to the full result"""
+    initialize()
+    expr = ccsd_hbar()
+    wt = w.WickTheorem()
+    shards = w.shard_by_hash(expr, 3)
+    assert len(shards) == 3
+    check_shards(expr, shards, wt)
+    # the assignment is reproducible
+    assert all(a == b for a, b in zip(shards, w.shard_by_hash(expr, 3)))
+    assert w.shard_by_hash(expr, 1)[0] == expr
+
+
+def test_shard_by_cost():
+    """Test that the shards have a similar estimated cost"""
+    initialize()
+    expr = ccsd_hbar()
+    wt = w.WickTheorem()
+    shards = wt.shard_by_cost(expr, 4, 0, 4)
+    assert len(shards) == 4
+    check_shards(expr, shards, wt)
+    costs = [sum(e.contractions + 1 for e in wt.estimate(s, 0, 4)) for s in shards]
+    largest = max(e.contractions + 1 for e in wt.estimate(expr, 0, 4))
+    assert max(costs) - min(costs) <= largest
+
+
+if __name__ == "__main__":
+    test_shard_by_hash()
+    test_shard_by_cost()
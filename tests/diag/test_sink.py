@@ -0,0 +1,160 @@
+import pytest
+import wicked as w
+
+
+def initialize():
+    w.reset_space()
+    w.add_space("o", "fermion", "occupied", ["i", "j", "k", "l", "m", "n"])
+    w.add_space("v", "fermion", "unoccupied", ["a", "b", "c", "d", "e", "f"])
+
+
+def ccsd_hbar():
+    F = w.op("f", ["o+ o", "v+ o", "o+ v", "v+ v"])
+    V = w.op("v", ["o+ o+ v v", "v+ v+ o o", "v+ o+ v o"])
+    T = w.op("t", ["v+ o", "v+ v+ o o"])
+    return w.bch_series(F + V, T, 2)
+
+
+class Collector(w.TermSink):
+    """A sink that adds up the terms and checks the groups"""
+
+    def __init__(self):
+        super().__init__()
+        self.terms = []
+        self.groups = 0
+
+    def add(self, term, coefficient):
+        self.terms.append((term, coefficient))
+
+    def flush(self):
+        self.groups += 1
+
+
+def test_sink():
+    """Test that a sink receives the terms of the contraction once"""
+    initialize()
+    expr = ccsd_hbar()
+    wt = w.WickTheorem()
+    result = wt.contract(expr, 0, 4)
+
+    sink = Collector()
+    wt.contract(expr, 0, 4, sink)
+    assert len(sink.terms) == result.size()
+    assert len(set(str(term) for term, c in sink.terms)) == result.size()
+    # f, v, f t, v t, f t t, v t t
+    assert sink.groups == 6
+
+    total = w.Expression()
+    for term, c in sink.terms:
+        total.add(term, c)
+    assert total == result
+
+
+class Forwarder(w.TermSink):
+    """A sink that calls the add() of the base class"""
+
+    def add(self, term, coefficient):
+        super().add(term, coefficient)
+
+
+def test_sink_base_add():
+    """Test that the add() of the base class is not implemented"""
+    initialize()
+    sink = Collector()
+    wt = w.WickTheorem()
+    wt.contract(w.op("f", ["v+ o"]), 2, 2, sink)
+    term, c = sink.terms[0]
+    with pytest.raises(NotImplementedError):
+        Forwarder().add(term, c)
+
+
+class BlockCounter(w.EquationSink):
+    def __init__(self):
+        super().__init__("r")
+        self.equations_count = {}
+
+    def equations(self, block, eqs):
+        self.equations_count[block] = self.equations_count.get(block, 0) + len(
+            eqs
+        )
+
+
+def test_equation_sink():
+    """Test that an equation sink receives all the equations"""
+    initialize()
+    expr = ccsd_hbar()
+    wt = w.WickTheorem()
+    equations = wt.contract(expr, 0, 4).to_manybody_equation("r")
+
+    sink = BlockCounter()
+    wt.contract(expr, 0, 4, sink)
+    assert sink.equations_count == {k: len(v) for k, v in equations.items()}
+
+
+class CountingEquationSink(BlockCounter):
+    """An equation sink that overrides add() and flush()"""
+
+    def __init__(self):
+        super().__init__()
+        self.nterms = 0
+        self.groups = 0
+
+    def add(self, term, coefficient):
+        self.nterms += 1
+        super().add(term, coefficient)
+
+    def flush(self):
+        self.groups += 1
+        super().flush()
+
+
+def test_equation_sink_overrides():
+    """Test that the add() and flush() of an equation sink are called"""
+    initialize()
+    expr = ccsd_hbar()
+    wt = w.WickTheorem()
+    result = wt.contract(expr, 0, 4)
+    equations = result.to_manybody_equation("r")
+
+    sink = CountingEquationSink()
+    wt.contract(expr, 0, 4, sink)
+    assert sink.nterms == result.size()
+    assert sink.groups == 6
+    # the base class still converts the terms into equations
+    assert sink.equations_count == {k: len(v) for k, v in equations.items()}
+
+
+def test_writers(tmp_path):
+    """Test the streaming writers"""
+    initialize()
+    expr = ccsd_hbar()
+    wt = w.WickTheorem()
+    result = wt.contract(expr, 0, 2)
+
+    wt.contract(expr, 0, 2, w.BinaryWriter(str(tmp_path / "terms.bin")))
+    assert w.read_binary_stream(str(tmp_path / "terms.bin")) == result
+
+    wt.contract(expr, 0, 2, w.TextWriter(str(tmp_path / "terms.txt")))
+    lines = (tmp_path / "terms.txt").read_text().splitlines()
+    assert len(lines) == result.size()
+    assert sorted(lines) == sorted(
+        (l if l[0] in "+-" else "+" + l) for l in str(result).splitlines()
+    )
+
+    wt.contract(expr, 0, 0, w.LatexWriter(str(tmp_path / "terms.tex")))
+    text = (tmp_path / "terms.tex").read_text()
+    assert text.count("\\\\\n") == wt.contract(expr, 0, 0).size()
+
+    wt.contract(expr, 0, 2, w.EinsumWriter(str(tmp_path / "eqs.py"), "r"))
+    text = (tmp_path / "eqs.py").read_text()
+    nequations = sum(
+        len(v) for v in result.to_manybody_equation("r").values()
+    )
+    assert text.count("np.einsum") == nequations
+
+
+if __name__ == "__main__":
+    test_sink()
+    test_sink_base_add()
+    test_equation_sink()
+    test_equation_sink_overrides()
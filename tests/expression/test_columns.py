@@ -0,0 +1,68 @@
+import pytest
+import wicked as w
+
+np = pytest.importorskip("numpy")
+
+
+def initialize():
+    w.reset_space()
+    w.add_space("o", "fermion", "occupied", ["i", "j", "k", "l", "m", "n"])
+    w.add_space("v", "fermion", "unoccupied", ["a", "b", "c", "d", "e", "f"])
+
+
+def term_from_columns(cols, n, spaces):
+    """Rebuild the string of a term from the columns of an expression"""
+    idx = lambda s, p: f"{spaces[s]}{p}"
+    parts = [f"{cols['numerator'][n]}/{cols['denominator'][n]}"]
+    for t in range(cols["tensor_offsets"][n], cols["tensor_offsets"][n + 1]):
+        b, e = cols["index_offsets"][t], cols["index_offsets"][t + 1]
+        indices = [idx(cols["index_space"][i], cols["index_pos"][i]) for i in range(b, e)]
+        nu = cols["tensor_nupper"][t]
+        label = cols["labels"][cols["tensor_label"][t]]
+        parts.append(f"{label}^{{{','.join(indices[:nu])}}}_{{{','.join(indices[nu:])}}}")
+    ops = []
+    for o in range(cols["op_offsets"][n], cols["op_offsets"][n + 1]):
+        sign = "+" if cols["op_creation"][o] else "-"
+        ops.append(f"a{sign}({idx(cols['op_space'][o], cols['op_pos'][o])})")
+    if cols["normal_ordered"][n]:
+        ops = ["{"] + ops + ["}"]
+    return " ".join(parts + ops)
+
+
+def test_columns():
+    """Test the columnar representation of an expression"""
+    initialize()
+    F = w.op("f", ["o+ o", "v+ o", "o+ v", "v+ v"])
+    V = w.op("v", ["o+ o+ v v", "v+ v+ o o", "v+ o+ v o"])
+    T = w.op("t", ["v+ o", "v+ v+ o o"])
+    H = w.bch_series(F + V, T, 2)
+    expr = w.WickTheorem().contract(H, 0, 4)
+    cols = expr.to_columns()
+
+    nterms = len(expr)
+    assert len(cols["coefficient"]) == nterms
+    assert len(cols["tensor_offsets"]) == nterms + 1
+    assert len(cols["op_offsets"]) == nterms + 1
+    assert len(cols["index_offsets"]) == len(cols["tensor_id"]) + 1
+    assert cols["tensor_offsets"][-1] == len(cols["tensor_id"])
+    assert cols["index_offsets"][-1] == len(cols["index_space"])
+    assert cols["op_offsets"][-1] == len(cols["op_space"])
+    assert sorted(cols["labels"]) == ["f", "t", "v"]
+    assert np.allclose(cols["coefficient"], cols["numerator"] / cols["denominator"])
+
+    # the terms can be rebuilt from the columns
+    lines = [term_from_columns(cols, n, ["o", "v"]) for n in range(nterms)]
+    assert w.expression("\n".join(lines)) == expr
+
+    # vectorized statistics: the number of scalar terms
+    nops = np.diff(cols["op_offsets"])
+    assert np.count_nonzero(nops == 0) == len(w.WickTheorem().contract(H, 0, 0))
+
+    # an empty expression
+    cols = w.Expression().to_columns()
+    assert len(cols["coefficient"]) == 0
+    assert list(cols["tensor_offsets"]) == [0]
+
+
+if __name__ == "__main__":
+    test_columns()
@@ -1,3 +1,6 @@
+import gc
+
+import pytest
 import wicked as w
 
 
@@ -90,9 +93,157 @@ def test_expression5():
     assert str(expr) == "f^{o0}_{}"
 
 
+def test_expression6():
+    """Test terms with many tensors and the cancellation of terms"""
+    w.reset_space()
+    w.add_space("o", "fermion", "occupied", ["i", "j", "k", "l", "m"])
+    w.add_space("v", "fermion", "unoccupied", ["a", "b", "c", "d", "e", "f"])
+    s = " ".join([f"t^{{o{i}}}_{{v{i}}}" for i in range(8)])
+    expr = w.expression(s)
+    assert str(expr) == s
+    expr2 = w.expression(f"2 {s}")
+    expr.add(expr2, w.rational(-1, 2))
+    assert str(expr) == ""
+    assert len(expr) == 0
+
+
+def test_expression7():
+    """Test that equivalent terms with different index labels are merged"""
+    w.reset_space()
+    w.add_space("c", "fermion", "occupied", ["m", "n"])
+    w.add_space("a", "fermion", "general", ["u", "v", "w", "x", "y", "z"])
+    w.add_space("v", "fermion", "unoccupied", ["e", "f"])
+    expr = w.expression(
+        "eta1^{a1}_{a0} lambda2^{a4,a5}_{a2,a3} t^{c0,a2}_{a1,a5} v^{a0,a3}_{c0,a4}"
+    )
+    expr += w.expression(
+        "-1 eta1^{a1}_{a0} lambda2^{a4,a5}_{a2,a3} t^{c0,a2}_{a1,a4} v^{a0,a3}_{c0,a5}"
+    )
+    expr.canonicalize()
+    assert len(expr) == 1
+    assert (
+        str(expr)
+        == "-2 eta1^{a1}_{a0} lambda2^{a4,a5}_{a2,a3} t^{c0,a2}_{a1,a4} v^{a0,a3}_{c0,a5}"
+    )
+
+
+def test_expression_threads():
+    """Test that processing an expression with several threads gives the
+    same result as with one thread"""
+    w.reset_space()
+    w.add_space("o", "fermion", "occupied", ["i", "j", "k", "l", "m"])
+    w.add_space("v", "fermion", "unoccupied", ["a", "b", "c", "d", "e", "f"])
+    T2 = w.op("t", ["v+ v+ o o"])
+    V = w.op("v", ["o+ o+ v v", "v+ v+ o o", "v+ o+ v o", "v+ v+ v v"])
+    wt = w.WickTheorem()
+    expr = wt.contract(w.rational(1), w.commutator(w.commutator(V, T2), T2), 0, 4)
+
+    results = []
+    for n in [1, 4]:
+        w.set_num_threads(n)
+        canonical = w.Expression()
+        canonical += expr
+        canonical.canonicalize()
+        mbeq = canonical.to_manybody_equation("r")
+        results.append(
+            (str(canonical), {k: [str(eq) for eq in v] for k, v in mbeq.items()})
+        )
+    w.set_num_threads(0)
+    assert results[0] == results[1]
+
+
+def test_expression_inplace():
+    """Test the in-place operators and that copies do not share changes"""
+    w.reset_space()
+    w.add_space("o", "fermion", "occupied", ["i", "j"])
+    w.add_space("v", "fermion", "unoccupied", ["a", "b"])
+    f = w.expression("f^{o0}_{v0} a+(o0) a-(v0)")
+    t = w.expression("1/2 t^{v0}_{o0}")
+
+    expr = w.Expression()
+    expr += f
+    same = expr
+    expr += t
+    assert same is expr
+    assert len(f) == 1 and len(expr) == 2
+    copy = expr.__copy__()
+    expr -= t
+    assert expr == f
+    assert copy == f + t
+    expr *= w.rational(-2)
+    assert str(expr) == "-2 f^{o0}_{v0} a+(o0) a-(v0)"
+    assert str(f) == "f^{o0}_{v0} a+(o0) a-(v0)"
+    assert copy - t == f
+
+    F = w.op("f", ["v+ o"])
+    T = w.op("t", ["v+ o"])
+    H = w.OperatorExpression()
+    H += F
+    H_copy = H.__copy__()
+    H += T
+    H -= F
+    assert H == T
+    assert H_copy == F
+    H *= w.rational(1, 2)
+    assert H == w.rational(1, 2) * T
+
+
+def test_expression_many_equivalent_tensors():
+    """Test the canonical form of terms with many equivalent tensors"""
+    w.reset_space()
+    w.add_space("v", "fermion", "unoccupied", ["a", "b", "c", "d"])
+    # a ring of n tensors, listed in two different orders
+    for n in [9, 12]:
+        ring = [f"g^{{v{i}}}_{{v{(i + 1) % n}}}" for i in range(n)]
+        order = [(5 * i + 3) % n for i in range(n)]
+        expr1 = w.expression(" ".join(ring))
+        expr2 = w.expression(" ".join(ring[i] for i in order))
+        expr1.canonicalize()
+        expr2.canonicalize()
+        assert expr1 == expr2
+        assert len(expr1 - expr2) == 0
+
+    # identical tensors that are connected only to operators
+    terms = [
+        " ".join(f"t^{{v{i}}}_{{v{i + 9}}}" for i in order)
+        + " "
+        + " ".join(f"a+(v{i + 9})" for i in range(9))
+        + " "
+        + " ".join(f"a-(v{i})" for i in range(9))
+        for order in [range(9), reversed(range(9))]
+    ]
+    expr1 = w.expression(terms[0])
+    expr2 = w.expression(terms[1])
+    expr1.canonicalize()
+    expr2.canonicalize()
+    assert expr1 == expr2
+
+
+def test_clear_pools():
+    """Test releasing the tensors and operators shared by the expressions"""
+    w.reset_space()
+    w.add_space("o", "fermion", "occupied", ["i", "j", "k", "l"])
+    w.add_space("v", "fermion", "unoccupied", ["a", "b", "c", "d"])
+    expr = w.expression("f^{v0}_{o0} a+(v0) a-(o0)")
+    text = str(expr)
+    with pytest.raises(RuntimeError):
+        w.clear_pools()
+    del expr
+    gc.collect()
+    w.clear_pools()
+    expr = w.expression("f^{v0}_{o0} a+(v0) a-(o0)")
+    assert str(expr) == text
+
+
 if __name__ == "__main__":
     test_expression()
     test_expression2()
     test_expression3()
     test_expression4()
     test_expression5()
+    test_expression6()
+    test_expression7()
+    test_expression_threads()
+    test_expression_inplace()
+    test_expression_many_equivalent_tensors()
+    test_clear_pools()
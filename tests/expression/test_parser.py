@@ -0,0 +1,86 @@
+import pytest
+import wicked as w
+
+
+def initialize():
+    w.reset_space()
+    w.add_space("o", "fermion", "occupied", ["i", "j", "k", "l", "m", "n"])
+    w.add_space("v", "fermion", "unoccupied", ["a", "b", "c", "d", "e", "f"])
+
+
+def test_parser():
+    """Test that the string representation of expressions can be read back"""
+    initialize()
+    F = w.op("f", ["o+ o", "v+ o", "o+ v", "v+ v"])
+    V = w.op("v", ["o+ o+ v v", "v+ v+ o o", "v+ o+ v o"])
+    T = w.op("t", ["v+ o", "v+ v+ o o"])
+    expr = w.WickTheorem().contract(w.bch_series(F + V, T, 2), 0, 4)
+    text = str(expr)
+
+    # a multi-line string is read in one call
+    assert w.expression(text) == expr
+    assert w.utils.string_to_expr(text) == expr
+
+    # blank lines and comments are skipped
+    assert w.expression("# comment\n\n" + text + "\n\n") == expr
+
+    lines = text.split("\n")
+    assert w.parse_expressions(lines) == expr
+    half = len(lines) // 2
+    assert (
+        w.parse_expressions(["\n".join(lines[:half]), "\n".join(lines[half:])])
+        == expr
+    )
+
+
+def test_parser_syntax():
+    """Test the syntax accepted by the parser"""
+    initialize()
+    expr = w.expression("-1/2 f^{o0}_{v0} t^{v0}_{o0}")
+    assert str(expr) == "-1/2 f^{o0}_{v0} t^{v0}_{o0}"
+
+    expr = w.expression("+3/2 t^{o0,o1}_{v0,v1} a+(v0) a+(v1) a-(o1) a-(o0)")
+    assert str(expr) == "3/2 t^{o0,o1}_{v0,v1} a+(v0) a+(v1) a-(o1) a-(o0)"
+
+    # normal-ordered operators are enclosed in braces
+    expr = w.expression("f^{v0}_{o0} { a+(o0) a-(v0) }")
+    assert str(expr) == "f^{v0}_{o0} { a+(o0) a-(v0) }"
+
+    # a scalar term
+    assert str(w.expression("-2")).strip() == "-2"
+    assert w.expression("") == w.Expression()
+
+    # like terms are combined
+    expr = w.expression("f^{o0}_{o0}\n-1/2 f^{o0}_{o0}")
+    assert str(expr) == "1/2 f^{o0}_{o0}"
+
+    for bad in [
+        "f^{o0}_{v0",
+        "f^{x0}_{v0}",
+        "a+(o0",
+        "1/ f^{o0}_{o0}",
+        "f^{o0}_{o0} % t^{o0}_{o0}",
+    ]:
+        with pytest.raises(RuntimeError):
+            w.expression(bad)
+
+    # the line of the error is reported
+    with pytest.raises(RuntimeError, match="line 2"):
+        w.expression("f^{o0}_{o0}\nf^{o0}_{o0")
+
+
+def test_parse_expression_file(tmp_path):
+    """Test reading an expression from a file"""
+    initialize()
+    expr = w.expression("-1/2 f^{o0}_{v0} t^{v0}_{o0}\n+1/4 v^{o0,o1}_{v0,v1}")
+    path = tmp_path / "expr.txt"
+    path.write_text(str(expr) + "\n")
+    assert w.parse_expression_file(str(path)) == expr
+
+    with pytest.raises(RuntimeError):
+        w.parse_expression_file(str(tmp_path / "missing.txt"))
+
+
+if __name__ == "__main__":
+    test_parser()
+    test_parser_syntax()
@@ -0,0 +1,109 @@
+import pickle
+
+import pytest
+import wicked as w
+
+
+def initialize():
+    w.reset_space()
+    w.add_space("o", "fermion", "occupied", ["i", "j", "k", "l", "m", "n"])
+    w.add_space("v", "fermion", "unoccupied", ["a", "b", "c", "d", "e", "f"])
+
+
+def ccsd():
+    F = w.op("f", ["o+ o", "v+ o", "o+ v", "v+ v"])
+    V = w.op("v", ["o+ o+ v v", "v+ v+ o o", "v+ o+ v o"])
+    T = w.op("t", ["v+ o", "v+ v+ o o"])
+    return w.bch_series(F + V, T, 2)
+
+
+def test_serialization():
+    """Test the binary representation of expressions and equations"""
+    initialize()
+    H = ccsd()
+    expr = w.WickTheorem().contract(H, 0, 4)
+
+    data = expr.to_bytes()
+    assert len(data) < len(str(expr)) / 2
+    assert w.Expression.from_bytes(data) == expr
+    assert w.OperatorExpression.from_bytes(H.to_bytes()) == H
+
+    for eqs in expr.to_manybody_equation("r").values():
+        for eq in eqs:
+            copy = w.Equation.from_bytes(eq.to_bytes())
+            assert str(copy) == str(eq)
+            term = eq.rhs()
+            assert str(w.SymbolicTerm.from_bytes(term.to_bytes())) == str(term)
+
+    for r in [w.rational(0), w.rational(-1, 3), w.rational(1234567, 89)]:
+        assert w.rational.from_bytes(r.to_bytes()) == r
+
+    with pytest.raises(RuntimeError):
+        w.Expression.from_bytes(data[:-1])
+    with pytest.raises(RuntimeError):
+        w.Equation.from_bytes(data)
+
+
+def test_serialization_spaces():
+    """Test that the orbital spaces are matched by label"""
+    initialize()
+    expr = w.WickTheorem().contract(ccsd(), 0, 2)
+    data = expr.to_bytes()
+    text = str(expr)
+
+    # define the spaces in another order
+    w.reset_space()
+    w.add_space("v", "fermion", "unoccupied", ["a", "b", "c", "d", "e", "f"])
+    w.add_space("o", "fermion", "occupied", ["i", "j", "k", "l", "m", "n"])
+    copy = w.Expression.from_bytes(data)
+    # the terms are canonicalized with the new order of the spaces
+    assert copy == w.WickTheorem().contract(ccsd(), 0, 2)
+    assert len(str(copy).split("\n")) == len(text.split("\n"))
+
+    # a missing space is an error
+    w.reset_space()
+    w.add_space("o", "fermion", "occupied", ["i", "j", "k", "l", "m", "n"])
+    with pytest.raises(RuntimeError):
+        w.Expression.from_bytes(data)
+
+
+def test_serialization_duplicate_term():
+    """Test that a duplicate term is an error"""
+    initialize()
+    data = w.expression("f^{v0}_{o0}").to_bytes()
+    # the data ends with the number of terms (1) and the term (6 bytes)
+    assert data[-7] == 1
+    with pytest.raises(RuntimeError):
+        w.Expression.from_bytes(data[:-7] + bytes([2]) + data[-6:] * 2)
+
+
+def test_serialization_overflow():
+    """Test that an integer too large for a rational is an error"""
+    data = w.rational(3).to_bytes()
+    # the data ends with the numerator (6 = 2 * 3) and the denominator (1)
+    assert data[-2:] == bytes([6, 1])
+    for numerator in [bytes([0xFF] * 11 + [1]), bytes([0xFF] * 9 + [3])]:
+        with pytest.raises(RuntimeError):
+            w.rational.from_bytes(data[:-2] + numerator + bytes([1]))
+    with pytest.raises(RuntimeError):
+        w.rational.from_bytes(data[:-1] + bytes([0xFF] * 9 + [1]))
+    for r in [w.rational(-1), w.rational(-(2**62), 3), w.rational(2**62, 7)]:
+        assert w.rational.from_bytes(r.to_bytes()) == r
+
+
+def test_pickle():
+    """Test pickling"""
+    initialize()
+    H = ccsd()
+    expr = w.WickTheorem().contract(H, 0, 4)
+    assert pickle.loads(pickle.dumps(expr)) == expr
+    assert pickle.loads(pickle.dumps(H)) == H
+    assert pickle.loads(pickle.dumps(w.rational(-5, 7))) == w.rational(-5, 7)
+
+
+if __name__ == "__main__":
+    test_serialization()
+    test_serialization_spaces()
+    test_serialization_duplicate_term()
+    test_serialization_overflow()
+    test_pickle()
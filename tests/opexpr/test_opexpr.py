@@ -29,6 +29,56 @@ def test_opexpr2():
     prod.canonicalize()
     assert str(prod) == "+ a { v+ v } c { o+ o } b { o+ o }"
 
+
+def test_gen_op():
+    """Test the generation of operators that span several spaces"""
+    w.reset_space()
+    w.add_space("c", "fermion", "occupied", ["m", "n"])
+    w.add_space("a", "fermion", "general", ["u", "v", "w", "x"])
+    w.add_space("v", "fermion", "unoccupied", ["e", "f"])
+
+    F = w.op(
+        "f",
+        ["c+ c", "a+ c", "v+ c", "c+ a", "a+ a", "v+ a", "c+ v", "a+ v", "v+ v"],
+    )
+    assert w.gen_op("f", 1, "cav", "cav") == F
+    assert w.utils.gen_op("f", 1, "vac", "cav") == F
+
+    # the diagonal components are skipped
+    assert w.gen_op("t", 1, "av", "ca", diagonal=False) == w.op(
+        "t", ["a+ c", "v+ c", "v+ a"]
+    )
+    V = w.gen_op("v", 2, "cav", "cav")
+    assert V.size() == 36
+    assert w.gen_op("v", 2, "cav", "cav", diagonal=False).size() == 30
+    assert w.gen_op("v", 2, "av", "ca", diagonal=False) == w.op(
+        "v",
+        ["a+ a+ c c", "a+ a+ a c", "a+ v+ c c", "a+ v+ a c", "a+ v+ a a",
+         "v+ v+ c c", "v+ v+ a c", "v+ v+ a a"],
+    )
+
+    # a component is diagonal if it has the same number of creation and
+    # annihilation operators in every space, whatever their order (the
+    # components "o+ v+ v o" and "v+ o+ o v" are skipped too)
+    w.add_space("o", "fermion", "occupied", ["i", "j"])
+    V = w.op(
+        "v",
+        ["o+ o+ v o", "o+ o+ v v", "o+ v+ o o", "o+ v+ v v", "v+ v+ o o",
+         "v+ v+ v o"],
+    )
+    assert w.gen_op("v", 2, "ov", "ov", diagonal=False) == V
+    assert w.utils.gen_op("v", 2, "vo", "vo", diagonal=False) == V
+
+    # only the excitations (the number of holes and particles created minus
+    # the number destroyed)
+    T2 = w.gen_op("t", 2, "cav", "cav", excitation_classes=[4])
+    assert T2 == w.op("t", ["v+ v+ c c"])
+    T = w.gen_op("t", 1, "cav", "cav", excitation_classes=[1, 2])
+    assert T == w.op("t", ["a+ c", "v+ c", "v+ a"])
+    assert w.gen_op("e", 0, "", "") == w.op("e", [""])
+
+
 if __name__ == "__main__":
     test_opexpr1()
     test_opexpr2()
+    test_gen_op()
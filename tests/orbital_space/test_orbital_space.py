@@ -1,3 +1,5 @@
+import threading
+
 import wicked as w
 import pytest
 
@@ -19,6 +21,54 @@ def test_orbital_space_exceptions():
         w.add_space("v", "fermion", "occupied", ["m", "n"])
 
 
+def test_orbital_space_threads():
+    """Test using different orbital spaces on different threads"""
+    w.reset_space()
+    w.add_space("o", "fermion", "occupied", ["i", "j", "k", "l"])
+    w.add_space("v", "fermion", "unoccupied", ["a", "b", "c", "d"])
+
+    osi = w.OrbitalSpaceInfo()
+    osi.add_space("a", "fermion", "general", ["u", "v", "w", "x", "y", "z"])
+    assert osi.num_spaces() == 1
+
+    # a WickTheorem object shared by the two threads
+    wt = w.WickTheorem()
+    results = {}
+
+    def run():
+        w.set_osi(osi)
+        T2 = w.op("t", ["a+ a+ a a"])
+        V = w.op("v", ["a+ a+ a a"])
+        results["general"] = str(wt.contract(w.commutator(V, T2), 0, 0))
+
+    run()
+    w.set_osi(None)
+    reference = results.pop("general")
+    assert "lambda2^{a6,a7}_{a4,a5}" in reference
+
+    thread = threading.Thread(target=run)
+    thread.start()
+    F = w.op("f", ["o+ v"])
+    T1 = w.op("t", ["v+ o"])
+    results["default"] = str(wt.contract(F @ T1, 0, 0))
+    thread.join()
+
+    # the calling thread still uses the default spaces
+    assert w.num_spaces() == 2
+    assert results["default"] == "f^{v0}_{o0} t^{o0}_{v0}"
+    assert results["general"] == reference
+
+    # a WickTheorem object bound to a given set of orbital spaces
+    w.set_osi(osi)
+    T2 = w.op("t", ["a+ a+ a a"])
+    V = w.op("v", ["a+ a+ a a"])
+    expr = w.WickTheorem().contract(w.commutator(V, T2), 0, 0)
+    w.set_osi(None)
+    assert w.WickTheorem(osi).contract(w.commutator(V, T2), 0, 0) == expr
+    assert w.num_spaces() == 2
+
+
 if __name__ == "__main__":
     test_orbital_space()
     test_orbital_space_exceptions()
+    test_orbital_space_threads()
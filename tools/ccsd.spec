@@ -0,0 +1,13 @@
+# The CCSD energy and amplitude equations
+# Run with: wicked-gen tools/ccsd.spec
+space o fermion occupied i j k l m n
+space v fermion unoccupied a b c d e f
+
+operator H f o+ o, v+ o, o+ v, v+ v
+operator H v o+ o+ o o, v+ o+ o o, o+ o+ v o, v+ v+ o o, o+ o+ v v
+operator H v v+ o+ v o, v+ v+ v o, v+ o+ v v, v+ v+ v v
+operator T t v+ o, v+ v+ o o
+
+bch H T 4
+rank 0 4
+target | o|v oo|vv
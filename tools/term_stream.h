@@ -0,0 +1,97 @@
+// The term stream format shared by wicked-gen and wicked-merge
+//
+// A term stream stores the terms of an Expression, one per line:
+//
+//   COEFFICIENT TERM
+//
+// where COEFFICIENT is a signed rational number (e.g., +1, -1/2) and TERM is
+// the string representation of the term (empty for a scalar), e.g.,
+//
+//   -1/2 t^{o0,o1}_{v0,v1} v^{v0,v1}_{o0,o1}
+//
+// The lines are sorted by TERM, so that several streams can be merged by
+// reading one line of each at a time. Lines starting with # are comments.
+
+#ifndef _wicked_tools_term_stream_h_
+#define _wicked_tools_term_stream_h_
+
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "algebra/expression.h"
+#include "algebra/symbolic_term.h"
+#include "helpers/rational.h"
+
+/// Return the coefficient of a term in the term stream format
+inline std::string term_stream_coefficient(scalar_t c) {
+  std::string s = c.str(true);
+  // rational::str() omits a unit numerator
+  if ((s == "+") or (s == "-")) {
+    s += "1";
+  }
+  return s;
+}
+
+/// Write an expression as a sorted term stream
+inline void write_term_stream(const Expression &expr, std::ostream &out) {
+  std::vector<std::pair<std::string, scalar_t>> lines;
+  lines.reserve(expr.size());
+  for (const auto &[term, c] : expr.compact_terms()) {
+    lines.emplace_back(term.term().str(), c);
+  }
+  std::sort(lines.begin(), lines.end(),
+            [](const auto &a, const auto &b) { return a.first < b.first; });
+  for (const auto &[term, c] : lines) {
+    out << term_stream_coefficient(c) << (term.empty() ? "" : " ") << term
+        << '\n';
+  }
+}
+
+/// Split a line of a term stream into its coefficient and its term. Return
+/// false if the line is blank or a comment
+inline bool parse_term_line(const std::string &line, std::string &coefficient,
+                            std::string &term) {
+  const auto begin = line.find_first_not_of(" \t\r");
+  if ((begin == std::string::npos) or (line[begin] == '#')) {
+    return false;
+  }
+  auto end = line.find_first_of(" \t", begin);
+  coefficient = line.substr(begin, end - begin);
+  if ((coefficient[0] != '+') and (coefficient[0] != '-')) {
+    throw std::runtime_error("the line \"" + line +
+                             "\" does not start with a signed coefficient");
+  }
+  term.clear();
+  if (end != std::string::npos) {
+    end = line.find_first_not_of(" \t", end);
+    if (end != std::string::npos) {
+      term = line.substr(end, line.find_last_not_of(" \t\r") + 1 - end);
+    }
+  }
+  return true;
+}
+
+/// Read a term stream into an expression (requires the orbital spaces used
+/// to write it)
+inline Expression read_term_stream(std::istream &in) {
+  Expression result;
+  std::string line, coefficient, term;
+  for (int n = 1; std::getline(in, line); n++) {
+    try {
+      if (parse_term_line(line, coefficient, term)) {
+        result.add(string_to_expr(coefficient + " " + term,
+                                  SymmetryType::Antisymmetric));
+      }
+    } catch (const std::exception &e) {
+      throw std::runtime_error("line " + std::to_string(n) + ": " + e.what());
+    }
+  }
+  return result;
+}
+
+#endif // _wicked_tools_term_stream_h_
@@ -0,0 +1,444 @@
+// wicked-gen: generate many-body equations from a specification file
+//
+// Usage: wicked-gen [--format FORMAT] [--output FILE] [--threads N]
+//                   [--shard I/N] [--shard-by hash|cost] [--input FILE]
+//                   [--checkpoint FILE] [--stream] SPEC
+//
+// The specification is a text file with one statement per line (SPEC = "-"
+// reads the standard input). Lines starting with # are comments.
+//
+//   space LABEL FIELD TYPE INDEX...   add an orbital space, e.g.,
+//                                     space o fermion occupied i j k l
+//   operator NAME LABEL COMPONENTS    add to the operator NAME a sum of
+//                                     components (separated by commas) of a
+//                                     tensor LABEL, e.g.,
+//                                     operator T t v+ o, v+ v+ o o
+//   bch A B N                         add exp(-B) A exp(B) truncated at order
+//                                     N to the expression
+//   commutator A B [C ...]            add [[A, B], C] ... to the expression
+//   product A B [C ...]               add the product A B C ... to the
+//                                     expression
+//   rank MIN MAX                      keep only terms with MIN to MAX
+//                                     uncontracted operators (default 0 100)
+//   label LABEL                       the label of the left-hand side tensor
+//                                     (default R)
+//   target BLOCK...                   write only these blocks, e.g., o|v
+//                                     oo|vv (default: all blocks)
+//   format FORMAT                     the output format: wicked, latex,
+//                                     einsum, ambit, or terms (default
+//                                     wicked)
+//
+// The command-line option --format overrides the format statement. The
+// format terms writes the terms of the contracted expression as a sorted
+// term stream (see term_stream.h) instead of equations.
+//
+// Large expressions can be generated by several independent processes. With
+// --shard I/N only the products of the shard I (0 <= I < N) are contracted.
+// The products are split into shards by a hash of their text (--shard-by
+// hash, the default) or so that the shards have a similar estimated number
+// of contractions (--shard-by cost). The partial results are written with
+// --format terms, merged with wicked-merge, and converted to equations with
+// --input, which reads a term stream instead of contracting, e.g.,
+//
+//   for i in 0 1 2 3; do
+//     wicked-gen --shard $i/4 --format terms --output part$i ccsd.spec &
+//   done; wait
+//   wicked-merge --output ccsd.terms part0 part1 part2 part3
+//   wicked-gen --input ccsd.terms ccsd.spec
+//
+// With --checkpoint FILE the progress of the contraction is saved to FILE
+// every minute. If the run is interrupted, running the same command again
+// resumes from the last checkpoint.
+//
+// With --stream the equations are written as soon as the products that
+// produce them are contracted, and the whole expression is never stored.
+// The products made of the same operators are contracted together, so a
+// block (e.g., oo|vv) is written once for each such group instead of once.
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "fmt/format.h"
+
+#include "algebra/equation.h"
+#include "algebra/expression.h"
+#include "algebra/term_sink.h"
+#include "diagrams/operator.h"
+#include "diagrams/operator_expression.h"
+#include "diagrams/wick_theorem.h"
+#include "helpers/orbital_space.h"
+#include "helpers/parallel.hpp"
+
+#include "term_stream.h"
+
+namespace {
+
+/// A generation job read from a specification file
+struct spec {
+  std::shared_ptr<OrbitalSpaceInfo> osi = std::make_shared<OrbitalSpaceInfo>();
+  std::map<std::string, OperatorExpression> operators;
+  OperatorExpression expr;
+  int minrank = 0;
+  int maxrank = 100;
+  std::string label = "R";
+  std::vector<std::string> targets;
+  std::string format = "wicked";
+};
+
+/// How the products are split among processes
+struct sharding {
+  int index = 0;
+  int count = 1;
+  bool by_cost = false;
+};
+
+std::vector<std::string> split_words(const std::string &line) {
+  std::istringstream ss(line);
+  std::vector<std::string> words;
+  for (std::string w; ss >> w;) {
+    words.push_back(w);
+  }
+  return words;
+}
+
+int to_int(const std::string &s) {
+  size_t pos = 0;
+  const int n = std::stoi(s, &pos);
+  if (pos != s.size()) {
+    throw std::runtime_error("expected an integer, found " + s);
+  }
+  return n;
+}
+
+const OperatorExpression &find_operator(const spec &job,
+                                        const std::string &name) {
+  auto it = job.operators.find(name);
+  if (it == job.operators.end()) {
+    throw std::runtime_error("the operator " + name + " is not defined");
+  }
+  return it->second;
+}
+
+/// Parse one statement of a specification
+void parse_statement(spec &job, const std::string &line) {
+  const auto words = split_words(line);
+  if (words.empty()) {
+    return;
+  }
+  const std::string &keyword = words[0];
+  auto require = [&](size_t n) {
+    if (words.size() < n) {
+      throw std::runtime_error("too few arguments for " + keyword);
+    }
+  };
+  if (keyword == "space") {
+    require(5);
+    if (words[1].size() != 1) {
+      throw std::runtime_error("the label of a space must be one character");
+    }
+    job.osi->add_space(words[1][0], string_to_field_type(words[2]),
+                       string_to_space_type(words[3]),
+                       std::vector<std::string>(words.begin() + 4,
+                                                words.end()));
+  } else if (keyword == "operator") {
+    require(4);
+    // the components are the text after the label, separated by commas
+    std::istringstream ss(line);
+    std::string skip, rest;
+    ss >> skip >> skip >> skip;
+    std::getline(ss, rest);
+    std::vector<std::string> components;
+    std::istringstream cs(rest);
+    for (std::string c; std::getline(cs, c, ',');) {
+      if (not split_words(c).empty()) {
+        components.push_back(c);
+      }
+    }
+    osi_scope scope(job.osi);
+    job.operators[words[1]] +=
+        make_diag_operator_expression(words[2], components);
+  } else if (keyword == "bch") {
+    require(4);
+    job.expr += bch_series(find_operator(job, words[1]),
+                           find_operator(job, words[2]), to_int(words[3]));
+  } else if (keyword == "commutator") {
+    require(3);
+    OperatorExpression result = find_operator(job, words[1]);
+    for (size_t i = 2; i < words.size(); i++) {
+      result = commutator(result, find_operator(job, words[i]));
+    }
+    job.expr += result;
+  } else if (keyword == "product") {
+    require(2);
+    OperatorExpression result = find_operator(job, words[1]);
+    for (size_t i = 2; i < words.size(); i++) {
+      result = result * find_operator(job, words[i]);
+    }
+    job.expr += result;
+  } else if (keyword == "rank") {
+    require(3);
+    job.minrank = to_int(words[1]);
+    job.maxrank = to_int(words[2]);
+  } else if (keyword == "label") {
+    require(2);
+    job.label = words[1];
+  } else if (keyword == "target") {
+    require(2);
+    job.targets.insert(job.targets.end(), words.begin() + 1, words.end());
+  } else if (keyword == "format") {
+    require(2);
+    job.format = words[1];
+  } else {
+    throw std::runtime_error("unknown statement " + keyword);
+  }
+}
+
+spec parse_spec(std::istream &in) {
+  spec job;
+  std::string line;
+  for (int n = 1; std::getline(in, line); n++) {
+    if (auto pos = line.find('#'); pos != std::string::npos) {
+      line.erase(pos);
+    }
+    try {
+      parse_statement(job, line);
+    } catch (const std::exception &e) {
+      throw std::runtime_error(fmt::format("line {}: {}", n, e.what()));
+    }
+  }
+  return job;
+}
+
+std::string equation_str(const Equation &eq, const std::string &format) {
+  if (format == "wicked") {
+    return eq.str();
+  }
+  if (format == "latex") {
+    return eq.latex();
+  }
+  return eq.compile(format);
+}
+
+/// Write a block of equations unless it is excluded by the targets of a job
+void write_block(const spec &job, const std::string &block,
+                 const std::vector<Equation> &eqs, std::ostream &out) {
+  if (not job.targets.empty() and
+      std::find(job.targets.begin(), job.targets.end(), block) ==
+          job.targets.end()) {
+    return;
+  }
+  out << "# " << block << " (" << eqs.size() << " terms)\n";
+  for (const auto &eq : eqs) {
+    out << equation_str(eq, job.format) << "\n";
+  }
+  out << "\n";
+}
+
+/// Warn about the targets that are not in a set of blocks
+void check_targets(const spec &job, const std::set<std::string> &blocks) {
+  for (const auto &target : job.targets) {
+    if (blocks.count(target) == 0) {
+      std::cerr << "wicked-gen: warning: the block " << target
+                << " has no terms" << std::endl;
+    }
+  }
+}
+
+/// Writes the equations of each group of terms as soon as they are available
+class block_writer : public EquationSink {
+public:
+  block_writer(const spec &job, std::ostream &out)
+      : EquationSink(job.label), job_(job), out_(out) {}
+
+  void equations(const std::string &block,
+                 const std::vector<Equation> &eqs) override {
+    write_block(job_, block, eqs, out_);
+    blocks_.insert(block);
+  }
+
+  /// The blocks written so far
+  const std::set<std::string> &blocks() const { return blocks_; }
+
+private:
+  const spec &job_;
+  std::ostream &out_;
+  std::set<std::string> blocks_;
+};
+
+/// Contract the expression of a job (or read it from a term stream) and write
+/// the equations
+void generate(const spec &job, const sharding &shards,
+              const std::string &input, const std::string &checkpoint,
+              bool stream, std::ostream &out) {
+  if ((job.format != "wicked") and (job.format != "latex") and
+      (job.format != "einsum") and (job.format != "ambit") and
+      (job.format != "terms")) {
+    throw std::runtime_error("unknown format " + job.format);
+  }
+  if (stream and
+      ((job.format == "terms") or not(input.empty() and checkpoint.empty()))) {
+    throw std::runtime_error("--stream cannot be used with --format terms, "
+                             "--input, or --checkpoint");
+  }
+  osi_scope scope(job.osi);
+  Expression result;
+  if (not input.empty()) {
+    std::ifstream file(input);
+    if (not file) {
+      throw std::runtime_error("cannot open the file " + input);
+    }
+    try {
+      result = read_term_stream(file);
+    } catch (const std::exception &e) {
+      throw std::runtime_error(input + ": " + e.what());
+    }
+  } else {
+    WickTheorem wt;
+    wt.set_checkpoint(checkpoint);
+    OperatorExpression expr = job.expr;
+    if (shards.count > 1) {
+      expr = shards.by_cost
+                 ? wt.shard_by_cost(expr, shards.count, job.minrank,
+                                    job.maxrank)[shards.index]
+                 : shard_by_hash(expr, shards.count)[shards.index];
+    }
+    if (stream) {
+      block_writer writer(job, out);
+      wt.contract(scalar_t(1), expr, job.minrank, job.maxrank, writer);
+      check_targets(job, writer.blocks());
+      return;
+    }
+    result = wt.contract(scalar_t(1), expr, job.minrank, job.maxrank);
+  }
+
+  if (job.format == "terms") {
+    if (shards.count > 1) {
+      out << "# shard " << shards.index << "/" << shards.count << " ("
+          << (shards.by_cost ? "cost" : "hash") << ")\n";
+    }
+    write_term_stream(result, out);
+    return;
+  }
+  const auto equations = result.to_manybody_equation(job.label);
+  std::set<std::string> blocks;
+  for (const auto &[block, eqs] : equations) {
+    write_block(job, block, eqs, out);
+    blocks.insert(block);
+  }
+  check_targets(job, blocks);
+}
+
+/// Parse the argument of --shard (I/N)
+sharding parse_shard(const std::string &arg) {
+  sharding shards;
+  const auto slash = arg.find('/');
+  if (slash == std::string::npos) {
+    throw std::runtime_error("expected --shard I/N, found " + arg);
+  }
+  shards.index = to_int(arg.substr(0, slash));
+  shards.count = to_int(arg.substr(slash + 1));
+  if ((shards.count < 1) or (shards.index < 0) or
+      (shards.index >= shards.count)) {
+    throw std::runtime_error("the shard " + arg + " is out of range");
+  }
+  return shards;
+}
+
+void print_usage() {
+  std::cout << "Usage: wicked-gen [--format FORMAT] [--output FILE] "
+               "[--threads N]\n"
+               "                  [--shard I/N] [--shard-by hash|cost] "
+               "[--input FILE]\n"
+               "                  [--checkpoint FILE] [--stream] SPEC\n"
+               "Generate many-body equations from the specification file "
+               "SPEC (- = stdin).\n"
+               "See the comments at the top of tools/wicked_gen.cc for the "
+               "syntax.\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::string spec_path, output, format, input, checkpoint, shard,
+      shard_by = "hash";
+  bool stream = false;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if ((arg == "--format") and (i + 1 < argc)) {
+      format = argv[++i];
+    } else if ((arg == "--output") and (i + 1 < argc)) {
+      output = argv[++i];
+    } else if ((arg == "--threads") and (i + 1 < argc)) {
+      set_num_threads(std::atoi(argv[++i]));
+    } else if ((arg == "--shard") and (i + 1 < argc)) {
+      shard = argv[++i];
+    } else if ((arg == "--shard-by") and (i + 1 < argc)) {
+      shard_by = argv[++i];
+    } else if ((arg == "--input") and (i + 1 < argc)) {
+      input = argv[++i];
+    } else if ((arg == "--checkpoint") and (i + 1 < argc)) {
+      checkpoint = argv[++i];
+    } else if (arg == "--stream") {
+      stream = true;
+    } else if ((arg == "--help") or (arg == "-h")) {
+      print_usage();
+      return 0;
+    } else if (spec_path.empty()) {
+      spec_path = arg;
+    } else {
+      print_usage();
+      return 1;
+    }
+  }
+  if (spec_path.empty()) {
+    print_usage();
+    return 1;
+  }
+
+  try {
+    sharding shards;
+    if (not shard.empty()) {
+      shards = parse_shard(shard);
+    }
+    if ((shard_by != "hash") and (shard_by != "cost")) {
+      throw std::runtime_error("unknown sharding method " + shard_by);
+    }
+    shards.by_cost = shard_by == "cost";
+    if ((shards.count > 1) and (not input.empty())) {
+      throw std::runtime_error("--shard and --input cannot be used together");
+    }
+    spec job;
+    if (spec_path == "-") {
+      job = parse_spec(std::cin);
+    } else {
+      std::ifstream file(spec_path);
+      if (not file) {
+        throw std::runtime_error("cannot open the file " + spec_path);
+      }
+      job = parse_spec(file);
+    }
+    if (not format.empty()) {
+      job.format = format;
+    }
+    if (output.empty()) {
+      generate(job, shards, input, checkpoint, stream, std::cout);
+    } else {
+      std::ofstream file(output);
+      if (not file) {
+        throw std::runtime_error("cannot open the file " + output);
+      }
+      generate(job, shards, input, checkpoint, stream, file);
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "wicked-gen: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,154 @@
+// wicked-merge: merge the partial results of sharded runs of wicked-gen
+//
+// Usage: wicked-merge [--output FILE] FILE...
+//
+// Each FILE is a term stream (see term_stream.h), usually written by
+// "wicked-gen --shard I/N --format terms". The streams are merged one line at
+// a time, so the memory used does not depend on their size. The coefficients
+// of the terms that appear in several streams are added and the terms that
+// cancel are removed. The result is a sorted term stream that can be merged
+// again or converted to equations with "wicked-gen --input FILE SPEC".
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "term_stream.h"
+
+namespace {
+
+/// A term stream read one line at a time
+class term_reader {
+public:
+  term_reader(const std::string &path) : path_(path), in_(path) {
+    if (not in_) {
+      throw std::runtime_error("cannot open the file " + path);
+    }
+    next();
+  }
+
+  /// Is there a current term?
+  bool valid() const { return valid_; }
+  /// The text of the current term
+  const std::string &term() const { return term_; }
+  /// The coefficient of the current term
+  scalar_t coefficient() const { return coefficient_; }
+
+  /// Read the next term and check that the stream is sorted
+  void next() {
+    std::string line, coefficient, term;
+    while (std::getline(in_, line)) {
+      line_++;
+      try {
+        if (not parse_term_line(line, coefficient, term)) {
+          continue;
+        }
+        if (valid_ and (term < term_)) {
+          throw std::runtime_error("the terms are not sorted");
+        }
+        coefficient_ = make_rational_from_str(coefficient);
+      } catch (const std::exception &e) {
+        throw std::runtime_error(path_ + ": line " + std::to_string(line_) +
+                                 ": " + e.what());
+      }
+      term_ = term;
+      valid_ = true;
+      return;
+    }
+    valid_ = false;
+  }
+
+private:
+  std::string path_;
+  std::ifstream in_;
+  int line_ = 0;
+  bool valid_ = false;
+  std::string term_;
+  scalar_t coefficient_;
+};
+
+/// Merge sorted term streams into a sorted term stream
+void merge(std::vector<std::unique_ptr<term_reader>> &readers,
+           std::ostream &out) {
+  // the readers ordered by their current term
+  auto greater = [](const term_reader *a, const term_reader *b) {
+    return a->term() > b->term();
+  };
+  std::priority_queue<term_reader *, std::vector<term_reader *>,
+                      decltype(greater)>
+      queue(greater);
+  for (auto &reader : readers) {
+    if (reader->valid()) {
+      queue.push(reader.get());
+    }
+  }
+  while (not queue.empty()) {
+    const std::string term = queue.top()->term();
+    scalar_t sum;
+    // add the coefficients of this term in all the streams
+    while ((not queue.empty()) and (queue.top()->term() == term)) {
+      term_reader *reader = queue.top();
+      queue.pop();
+      sum += reader->coefficient();
+      reader->next();
+      if (reader->valid()) {
+        queue.push(reader);
+      }
+    }
+    if (sum != scalar_t(0)) {
+      out << term_stream_coefficient(sum) << (term.empty() ? "" : " ") << term
+          << '\n';
+    }
+  }
+}
+
+void print_usage() {
+  std::cout << "Usage: wicked-merge [--output FILE] FILE...\n"
+               "Merge the term streams written by wicked-gen --shard.\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::string output;
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if ((arg == "--output") and (i + 1 < argc)) {
+      output = argv[++i];
+    } else if ((arg == "--help") or (arg == "-h")) {
+      print_usage();
+      return 0;
+    } else {
+      paths.push_back(arg);
+    }
+  }
+  if (paths.empty()) {
+    print_usage();
+    return 1;
+  }
+
+  try {
+    std::vector<std::unique_ptr<term_reader>> readers;
+    for (const auto &path : paths) {
+      readers.push_back(std::make_unique<term_reader>(path));
+    }
+    if (output.empty()) {
+      merge(readers, std::cout);
+    } else {
+      std::ofstream file(output);
+      if (not file) {
+        throw std::runtime_error("cannot open the file " + output);
+      }
+      merge(readers, file);
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "wicked-merge: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,266 @@
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "helpers/flyweight.hpp"
+
+#include "compact_term.h"
+
+namespace {
+
+// The pools compare every field of an object, including those ignored by the
+// comparison operators (e.g., the tensor symmetry), so that a materialized
+// term is identical to the one that was stored
+
+size_t hash_index(const Index &idx) {
+  size_t seed = std::hash<int>()(idx.space());
+  hash_combine(seed, std::hash<int>()(idx.pos()));
+  hash_combine(seed, idx.is_summed());
+  return seed;
+}
+
+bool same_index(const Index &a, const Index &b) {
+  return (a == b) and (a.is_summed() == b.is_summed());
+}
+
+bool same_indices(const std::vector<Index> &a, const std::vector<Index> &b) {
+  return std::equal(a.begin(), a.end(), b.begin(), b.end(), same_index);
+}
+
+struct tensor_hash {
+  size_t operator()(const Tensor &t) const {
+    size_t seed = std::hash<std::string>()(t.label());
+    hash_combine(seed, static_cast<size_t>(t.symmetry()));
+    for (const auto &idx : t.lower()) {
+      hash_combine(seed, hash_index(idx));
+    }
+    hash_combine(seed, t.lower().size());
+    for (const auto &idx : t.upper()) {
+      hash_combine(seed, hash_index(idx));
+    }
+    return seed;
+  }
+};
+
+struct tensor_equal {
+  bool operator()(const Tensor &a, const Tensor &b) const {
+    return (a.label() == b.label()) and (a.symmetry() == b.symmetry()) and
+           same_indices(a.lower(), b.lower()) and
+           same_indices(a.upper(), b.upper());
+  }
+};
+
+struct operators_hash {
+  size_t operator()(const std::vector<SQOperator> &ops) const {
+    size_t seed = ops.size();
+    for (const auto &op : ops) {
+      hash_combine(seed, static_cast<size_t>(op.type()));
+      hash_combine(seed, hash_index(op.index()));
+    }
+    return seed;
+  }
+};
+
+struct operators_equal {
+  bool operator()(const std::vector<SQOperator> &a,
+                  const std::vector<SQOperator> &b) const {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                      [](const SQOperator &x, const SQOperator &y) {
+                        return (x.type() == y.type()) and
+                               same_index(x.index(), y.index());
+                      });
+  }
+};
+
+using tensor_pool_t = flyweight_pool<Tensor, tensor_hash, tensor_equal>;
+using operators_pool_t =
+    flyweight_pool<std::vector<SQOperator>, operators_hash, operators_equal>;
+
+tensor_pool_t &tensor_pool() {
+  static tensor_pool_t pool;
+  return pool;
+}
+
+operators_pool_t &operators_pool() {
+  static operators_pool_t pool;
+  return pool;
+}
+
+/// the number of users of the pools (CompactTerm and interned_pool_user
+/// objects). A user is registered before it interns any object, and
+/// clear_interned_pools() checks this number while it holds the mutexes of
+/// the pools, so an id can never be handed out across a clear
+std::atomic<size_t> pool_users{0};
+
+void register_pool_user() {
+  pool_users.fetch_add(1, std::memory_order_relaxed);
+}
+
+void unregister_pool_user() {
+  // release: the reads of the pools by this user happen before a clear
+  pool_users.fetch_sub(1, std::memory_order_release);
+}
+
+} // namespace
+
+CompactTerm::CompactTerm(const SymbolicTerm &term)
+    : ops_(0), ntensors_(static_cast<uint16_t>(term.tensors().size())),
+      normal_ordered_(term.normal_ordered()) {
+  register_pool_user();
+  ops_ = operators_pool().intern(term.ops());
+  id_t *ids = inline_.data();
+  if (ntensors_ > max_inline_tensors) {
+    overflow_.reset(new id_t[ntensors_]);
+    ids = overflow_.get();
+  }
+  for (int i = 0; i < ntensors_; i++) {
+    ids[i] = tensor_pool().intern(term.tensors()[i]);
+  }
+}
+
+CompactTerm::CompactTerm(bool normal_ordered, id_t ops,
+                         const std::vector<id_t> &tensors)
+    : ops_(ops), ntensors_(static_cast<uint16_t>(tensors.size())),
+      normal_ordered_(normal_ordered) {
+  register_pool_user();
+  id_t *ids = inline_.data();
+  if (ntensors_ > max_inline_tensors) {
+    overflow_.reset(new id_t[ntensors_]);
+    ids = overflow_.get();
+  }
+  std::copy(tensors.begin(), tensors.end(), ids);
+}
+
+CompactTerm::CompactTerm(const CompactTerm &other)
+    : ops_(other.ops_), ntensors_(other.ntensors_),
+      normal_ordered_(other.normal_ordered_), inline_(other.inline_) {
+  register_pool_user();
+  if (other.overflow_) {
+    overflow_.reset(new id_t[ntensors_]);
+    std::copy_n(other.overflow_.get(), ntensors_, overflow_.get());
+  }
+}
+
+CompactTerm::CompactTerm(CompactTerm &&other) noexcept
+    : ops_(other.ops_), ntensors_(other.ntensors_),
+      normal_ordered_(other.normal_ordered_),
+      registered_(other.registered_), inline_(other.inline_),
+      overflow_(std::move(other.overflow_)) {
+  // take over the registration of other
+  other.registered_ = false;
+}
+
+CompactTerm::~CompactTerm() {
+  if (registered_) {
+    unregister_pool_user();
+  }
+}
+
+CompactTerm &CompactTerm::operator=(const CompactTerm &other) {
+  if (this != &other) {
+    CompactTerm tmp(other);
+    *this = std::move(tmp);
+  }
+  return *this;
+}
+
+CompactTerm &CompactTerm::operator=(CompactTerm &&other) noexcept {
+  ops_ = other.ops_;
+  ntensors_ = other.ntensors_;
+  normal_ordered_ = other.normal_ordered_;
+  inline_ = other.inline_;
+  overflow_ = std::move(other.overflow_);
+  // exchange the registrations, so that each one is released once
+  std::swap(registered_, other.registered_);
+  return *this;
+}
+
+SymbolicTerm CompactTerm::term() const {
+  const id_t *ids = tensor_ids();
+  std::vector<Tensor> tensors;
+  tensors.reserve(ntensors_);
+  for (int i = 0; i < ntensors_; i++) {
+    tensors.push_back(interned_tensor(ids[i]));
+  }
+  return SymbolicTerm(normal_ordered_, interned_operators(ops_), tensors);
+}
+
+bool CompactTerm::operator<(const CompactTerm &other) const {
+  // compare the tensors lexicographically, then the operators
+  const id_t *ids = tensor_ids();
+  const id_t *other_ids = other.tensor_ids();
+  const int n = std::min(ntensors_, other.ntensors_);
+  for (int i = 0; i < n; i++) {
+    if (ids[i] == other_ids[i])
+      continue;
+    const Tensor &t = interned_tensor(ids[i]);
+    const Tensor &other_t = interned_tensor(other_ids[i]);
+    if (t < other_t)
+      return true;
+    if (other_t < t)
+      return false;
+  }
+  if (ntensors_ != other.ntensors_) {
+    return ntensors_ < other.ntensors_;
+  }
+  if (ops_ == other.ops_) {
+    return false;
+  }
+  return interned_operators(ops_) < interned_operators(other.ops_);
+}
+
+bool CompactTerm::operator==(const CompactTerm &other) const {
+  if (ntensors_ != other.ntensors_)
+    return false;
+  const id_t *ids = tensor_ids();
+  const id_t *other_ids = other.tensor_ids();
+  for (int i = 0; i < ntensors_; i++) {
+    if ((ids[i] != other_ids[i]) and
+        not(interned_tensor(ids[i]) == interned_tensor(other_ids[i]))) {
+      return false;
+    }
+  }
+  return (ops_ == other.ops_) or
+         (interned_operators(ops_) == interned_operators(other.ops_));
+}
+
+const Tensor &interned_tensor(CompactTerm::id_t id) {
+  return tensor_pool().get(id);
+}
+
+const std::vector<SQOperator> &interned_operators(CompactTerm::id_t id) {
+  return operators_pool().get(id);
+}
+
+CompactTerm::id_t intern_tensor(const Tensor &tensor) {
+  return tensor_pool().intern(tensor);
+}
+
+CompactTerm::id_t intern_operators(const std::vector<SQOperator> &ops) {
+  return operators_pool().intern(ops);
+}
+
+std::pair<size_t, size_t> interned_pool_size() {
+  return {tensor_pool().size(), operators_pool().size()};
+}
+
+interned_pool_user::interned_pool_user() { register_pool_user(); }
+
+interned_pool_user::~interned_pool_user() { unregister_pool_user(); }
+
+void clear_interned_pools() {
+  // no object can be interned until both pools are cleared
+  std::scoped_lock lock(tensor_pool().mutex(), operators_pool().mutex());
+  const size_t users = pool_users.load(std::memory_order_acquire);
+  if (users != 0) {
+    throw std::runtime_error(
+        "\nclear_interned_pools() cannot be called while " +
+        std::to_string(users) + " terms are alive.");
+  }
+  tensor_pool().clear();
+  operators_pool().clear();
+}
@@ -0,0 +1,123 @@
+#ifndef _wicked_compact_term_h_
+#define _wicked_compact_term_h_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "sqoperator.h"
+#include "symbolic_term.h"
+#include "tensor.h"
+
+/**
+ * @brief A compact record of a SymbolicTerm
+ *
+ * Tensors and strings of operators are interned in process-wide pools, so a
+ * CompactTerm stores only their ids. Terms with up to max_inline_tensors
+ * tensors do not allocate any memory. This is the key type used by Expression
+ * to store its terms. CompactTerm objects are ordered exactly like the
+ * SymbolicTerm objects they represent.
+ *
+ * The pools only grow while CompactTerm objects are alive. Their memory is
+ * released by clear_interned_pools() once all of them are destroyed. Each
+ * CompactTerm (except a moved-from one) is registered as a user of the pools.
+ */
+class CompactTerm {
+public:
+  using id_t = uint32_t;
+
+  /// the number of tensor ids stored without allocating memory
+  static constexpr int max_inline_tensors = 6;
+
+  // ==> Constructor <==
+
+  /// Create a record of a term (interns its tensors and operators)
+  explicit CompactTerm(const SymbolicTerm &term);
+
+  /// Create a record from the ids of interned operators and tensors
+  CompactTerm(bool normal_ordered, id_t ops, const std::vector<id_t> &tensors);
+
+  CompactTerm(const CompactTerm &other);
+  CompactTerm(CompactTerm &&other) noexcept;
+  CompactTerm &operator=(const CompactTerm &other);
+  CompactTerm &operator=(CompactTerm &&other) noexcept;
+  ~CompactTerm();
+
+  // ==> Class public interface <==
+
+  /// Materialize the term represented by this record
+  SymbolicTerm term() const;
+
+  /// @return is the SQ operator product normal ordered?
+  bool normal_ordered() const { return normal_ordered_; }
+
+  /// Return the number of tensors
+  int ntensors() const { return ntensors_; }
+
+  /// Return the id of the i-th tensor
+  id_t tensor_id(int i) const { return tensor_ids()[i]; }
+
+  /// Return the id of the string of operators
+  id_t ops_id() const { return ops_; }
+
+  /// Comparison operator used for sorting (same as SymbolicTerm)
+  bool operator<(const CompactTerm &other) const;
+
+  /// Comparison operator (same as SymbolicTerm)
+  bool operator==(const CompactTerm &other) const;
+
+private:
+  // ==> Class private data <==
+
+  /// the id of the string of operators
+  id_t ops_;
+  /// the number of tensors
+  uint16_t ntensors_;
+  /// is the SQ operator product normal ordered?
+  bool normal_ordered_;
+  /// is this record registered as a user of the pools? (false if moved from)
+  bool registered_ = true;
+  /// the tensor ids (if ntensors_ <= max_inline_tensors)
+  std::array<id_t, max_inline_tensors> inline_;
+  /// the tensor ids (if ntensors_ > max_inline_tensors)
+  std::unique_ptr<id_t[]> overflow_;
+
+  // ==> Class private functions <==
+
+  const id_t *tensor_ids() const {
+    return overflow_ ? overflow_.get() : inline_.data();
+  }
+};
+
+/// Return the interned tensor with a given id
+const Tensor &interned_tensor(CompactTerm::id_t id);
+
+/// Return the interned string of operators with a given id
+const std::vector<SQOperator> &interned_operators(CompactTerm::id_t id);
+
+/// Intern a tensor and return its id
+CompactTerm::id_t intern_tensor(const Tensor &tensor);
+
+/// Intern a string of operators and return its id
+CompactTerm::id_t intern_operators(const std::vector<SQOperator> &ops);
+
+/// Return the number of distinct tensors and strings of operators interned
+std::pair<size_t, size_t> interned_pool_size();
+
+/// Registers a user of the pools for its lifetime. Hold one while using ids
+/// that are not (yet) stored in a CompactTerm
+class interned_pool_user {
+public:
+  interned_pool_user();
+  ~interned_pool_user();
+  interned_pool_user(const interned_pool_user &) = delete;
+  interned_pool_user &operator=(const interned_pool_user &) = delete;
+};
+
+/// Remove all the interned tensors and strings of operators. Throws if a
+/// user of the pools (e.g., a CompactTerm, and therefore an Expression with
+/// terms) is alive. Safe to call while other threads intern objects
+void clear_interned_pools();
+
+#endif // _wicked_compact_term_h_
@@ -1,9 +1,17 @@
 #include <algorithm>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
 
 #include "helpers/helpers.h"
 #include "helpers/orbital_space.h"
+#include "helpers/parallel.hpp"
+#include "helpers/profile.h"
 #include "helpers/stl_utils.hpp"
+#include "helpers/string_scanner.h"
+#include "helpers/trace.h"
 
 #include "equation.h"
 #include "expression.h"
@@ -11,145 +19,264 @@
 #include "tensor.h"
 #include "term.h"
 
-Expression::Expression() : Algebra<SymbolicTerm, scalar_t>() {}
+Expression::Expression() : Algebra<CompactTerm, scalar_t>() {}
+
+std::map<SymbolicTerm, scalar_t> Expression::terms() const {
+  std::map<SymbolicTerm, scalar_t> result;
+  for (const auto &[k, v] : const_terms()) {
+    result.emplace_hint(result.end(), k.term(), v);
+  }
+  return result;
+}
 
 void Expression::add(const Term &sterm) {
-  SymbolicTerm symterm = sterm.symterm();
-  auto search = terms_.find(symterm);
+  add(std::make_pair(sterm.symterm(), sterm.coefficient()));
+}
 
-  if (search != terms_.end()) {
-    /// Found, then just add the factor to the existing term
-    search->second += sterm.coefficient();
+void Expression::add(const SymbolicTerm &term, scalar_t coefficient) {
+  PROFILE_COUNT(Counter::TermsAdded, 1);
+  // don't add a zero term
+  if (coefficient == 0)
+    return;
+  CompactTerm compact_term(term);
+  auto &terms = mutable_terms();
+  auto search = terms.find(compact_term);
+  if (search != terms.end()) {
+    search->second += coefficient;
     if (search->second == 0) {
-      terms_.erase(search);
+      PROFILE_COUNT(Counter::TermsCancelled, 1);
+      terms.erase(search);
     }
   } else {
-    terms_[symterm] = sterm.coefficient();
+    terms.emplace_hint(search, std::move(compact_term), coefficient);
   }
 }
 
 void Expression::add(const std::pair<SymbolicTerm, scalar_t> &term_factor,
                      scalar_t scale) {
 
-  const SymbolicTerm &term = term_factor.first;
+  PROFILE_COUNT(Counter::TermsAdded, 1);
+  CompactTerm term(term_factor.first);
   scalar_t factor = term_factor.second;
 
-  auto search = terms_.find(term);
+  auto &terms = mutable_terms();
+  auto search = terms.find(term);
 
-  if (search != terms_.end()) {
+  if (search != terms.end()) {
     /// Found, then just add the factor to the existing term
     search->second += scale * factor;
     if (search->second == 0) {
-      terms_.erase(search);
+      PROFILE_COUNT(Counter::TermsCancelled, 1);
+      terms.erase(search);
     }
   } else {
-    terms_[term] = scale * factor;
+    terms.emplace_hint(search, std::move(term), scale * factor);
   }
 }
 
 void Expression::add(const Expression &expr, scalar_t scale) {
-  for (const auto &kv : expr.terms()) {
-    add(kv, scale);
+  PROFILE_COUNT(Counter::TermsAdded, expr.size());
+  if ((size() == 0) and (scale == 1)) {
+    // share the terms of expr (they are copied only if modified)
+    *this = expr;
+    return;
+  }
+  if (this == &expr) {
+    add(Expression(expr), scale);
+    return;
+  }
+  auto &terms = mutable_terms();
+  for (const auto &[k, v] : expr.const_terms()) {
+    auto search = terms.find(k);
+    if (search != terms.end()) {
+      search->second += scale * v;
+      if (search->second == 0) {
+        PROFILE_COUNT(Counter::TermsCancelled, 1);
+        terms.erase(search);
+      }
+    } else {
+      terms.emplace_hint(search, k, scale * v);
+    }
   }
 }
 
+Expression &Expression::operator+=(const Expression &terms) {
+  add(terms);
+  return *this;
+}
+
+Expression &Expression::operator-=(const Expression &terms) {
+  add(terms, scalar_t(-1));
+  return *this;
+}
+
 Expression &Expression::canonicalize() {
-  std::map<SymbolicTerm, scalar_t> canonical_terms;
-  for (const auto &[k, v] : terms_) {
-    SymbolicTerm term = k;
+  trace_span span("canonicalize expression");
+  span.arg("terms", std::to_string(size()));
+  // canonicalize the terms in parallel, then combine them in their original
+  // order so that the result does not depend on the number of threads
+  std::vector<const vecspace_t::value_type *> terms;
+  terms.reserve(size());
+  for (const auto &kv : const_terms()) {
+    terms.push_back(&kv);
+  }
+  std::vector<std::optional<std::pair<CompactTerm, scalar_t>>> canonical(
+      terms.size());
+  parallel_for(terms.size(), [&](size_t n) {
+    SymbolicTerm term = terms[n]->first.term();
     scalar_t factor = term.canonicalize();
-    factor *= v;
-    add_to_map(canonical_terms, term, factor);
+    canonical[n].emplace(CompactTerm(term), factor * terms[n]->second);
+  });
+
+  vecspace_t canonical_terms;
+  for (const auto &term_factor : canonical) {
+    add_to_map(canonical_terms, term_factor->first, term_factor->second);
   }
-  terms_ = canonical_terms;
+  set_terms(std::move(canonical_terms));
   return *this;
 }
 
+Expression Expression::adjoint() const {
+  trace_span span("adjoint expression");
+  span.arg("terms", std::to_string(size()));
+  std::vector<const vecspace_t::value_type *> terms;
+  terms.reserve(size());
+  for (const auto &kv : const_terms()) {
+    terms.push_back(&kv);
+  }
+  std::vector<std::optional<std::pair<CompactTerm, scalar_t>>> adjoint_terms(
+      terms.size());
+  parallel_for(terms.size(), [&](size_t n) {
+    SymbolicTerm term = terms[n]->first.term().adjoint();
+    scalar_t factor = term.canonicalize();
+    adjoint_terms[n].emplace(CompactTerm(term), factor * terms[n]->second);
+  });
+
+  vecspace_t result_terms;
+  for (const auto &term_factor : adjoint_terms) {
+    add_to_map(result_terms, term_factor->first, term_factor->second);
+  }
+  Expression result;
+  result.set_terms(std::move(result_terms));
+  return result;
+}
+
 Expression &Expression::reindex(index_map_t &idx_map) {
-  std::map<SymbolicTerm, scalar_t> reindexed_terms;
-  for (auto &kv : terms_) {
-    SymbolicTerm term = kv.first;
+  vecspace_t reindexed_terms;
+  for (const auto &[k, v] : const_terms()) {
+    SymbolicTerm term = k.term();
     term.reindex(idx_map);
-    add_to_map(reindexed_terms, term, kv.second);
+    add_to_map(reindexed_terms, CompactTerm(term), v);
   }
+  set_terms(std::move(reindexed_terms));
   return *this;
 }
 
 bool Expression::operator==(const Expression &other) {
-  return (terms_.size() == other.terms_.size()) and
-         std::equal(terms_.begin(), terms_.end(), other.terms_.begin());
+  return is_equal(other);
+}
+
+std::string expression_term_str(const CompactTerm &term, scalar_t coefficient,
+                                bool first) {
+  std::string symterm_str = term.term().str();
+  // don't show the sign of the first term unless it's negative
+  std::string factor_str = coefficient.str(not first);
+  // rational(1,1).str() returns "", so we need to handle the case of
+  // a pure scalar term with no operator
+  if ((factor_str.size() > 1) and (factor_str != "-")) {
+    factor_str += " ";
+  }
+  if (factor_str.size() + symterm_str.size() == 0) {
+    factor_str = first ? "1" : "+1";
+  }
+  return factor_str + symterm_str;
 }
 
 std::string Expression::str() const {
-  std::vector<std::string> str_vec;
-  int n = 0;
-  for (auto &kv : terms_) {
-    std::string symterm_str = kv.first.str();
-    std::string factor_str;
-    if (n == 0) { // don't show the first element sign unless it's negative
-      factor_str += kv.second.str(false);
-    } else {
-      factor_str += kv.second.str(true);
-    }
-    // rational(1,1).str() returns "", so we need to handle the case of
-    // a pure scalar term with no operator
-    if ((factor_str.size() > 1) and (factor_str != "-")) {
-      factor_str += " ";
-    }
-    if (factor_str.size() + symterm_str.size() == 0) {
-      factor_str = (n == 0) ? "1" : "+1";
+  // append the terms to one string (a vector of the terms and a join would
+  // hold two copies of the result)
+  std::string result;
+  bool first = true;
+  for (auto &kv : const_terms()) {
+    if (not first) {
+      result += '\n';
     }
-    str_vec.push_back(factor_str + symterm_str);
-    n++;
+    result += expression_term_str(kv.first, kv.second, first);
+    first = false;
   }
-  return join(str_vec, "\n");
+  return result;
 }
 
 std::string Expression::latex(const std::string &sep) const {
-  std::vector<std::string> str_vec;
-  for (auto &kv : terms_) {
-    str_vec.push_back(kv.second.latex() + ' ' + kv.first.latex());
+  std::string result;
+  bool first = true;
+  for (auto &kv : const_terms()) {
+    if (not first) {
+      result += sep;
+    }
+    result += kv.second.latex() + ' ' + kv.first.term().latex();
+    first = false;
   }
-  return join(str_vec, sep);
+  return result;
 }
 
 std::map<std::string, std::vector<Equation>>
 Expression::to_manybody_equation(const std::string &label) const {
-  std::map<std::string, std::vector<Equation>> result;
-  for (const auto &term_factor : terms_) {
+  trace_span span("to_manybody_equation");
+  span.arg("terms", std::to_string(size()));
+  std::vector<const vecspace_t::value_type *> terms;
+  terms.reserve(size());
+  for (const auto &kv : const_terms()) {
+    terms.push_back(&kv);
+  }
+
+  // build the equations in parallel
+  std::vector<std::optional<std::pair<std::string, Equation>>> equations(
+      terms.size());
+  parallel_for(terms.size(), [&](size_t n) {
+    const CompactTerm &term = terms[n]->first;
     std::vector<Index> lower;
     std::vector<Index> upper;
-    const SymbolicTerm &term = term_factor.first;
-    scalar_t factor = term_factor.second;
-    for (const auto &op : term.ops()) {
+    for (const auto &op : interned_operators(term.ops_id())) {
       if (op.type() == SQOperatorType::Creation) {
         lower.push_back(op.index());
       } else {
-        // upper indices are read in reverse order
-        upper.insert(upper.begin(), op.index());
+        upper.push_back(op.index());
       }
     }
-    SymbolicTerm lhs;
+    // upper indices are read in reverse order
+    std::reverse(upper.begin(), upper.end());
+
     Tensor lhs_tensor(label, lower, upper, SymmetryType::Antisymmetric);
-    auto signature = lhs_tensor.signature();
-    // convert the signature to a string (to bypass limitations of pybind11)
-    std::string signature_str_upper;
-    std::string signature_str_lower;
-    int pos = 0;
-    for (const auto &[u, l] : signature) {
-      signature_str_upper += std::string(u, orbital_subspaces->label(pos));
-      signature_str_lower += std::string(l, orbital_subspaces->label(pos));
-      pos += 1;
-    }
-    reverse(signature_str_lower.begin(), signature_str_lower.end());
-    auto signature_str = signature_str_upper + "|" + signature_str_lower;
-    lhs.add(lhs_tensor);
-
-    SymbolicTerm rhs;
-    for (const auto &tensor : term.tensors()) {
-      rhs.add(tensor);
-    }
-    result[signature_str].push_back(Equation(lhs, rhs, factor));
+    const auto signature = lhs_tensor.signature();
+    // convert the signature to a string (to bypass limitations of pybind11).
+    // Lower indices are listed in reverse order
+    std::string signature_str;
+    signature_str.reserve(lower.size() + upper.size() + 1);
+    for (size_t pos = 0; pos < signature.size(); pos++) {
+      signature_str.append(signature[pos].first, get_osi()->label(pos));
+    }
+    signature_str += '|';
+    for (size_t pos = signature.size(); pos-- > 0;) {
+      signature_str.append(signature[pos].second,
+                           get_osi()->label(pos));
+    }
+
+    std::vector<Tensor> rhs_tensors;
+    rhs_tensors.reserve(term.ntensors());
+    for (int i = 0; i < term.ntensors(); i++) {
+      rhs_tensors.push_back(interned_tensor(term.tensor_id(i)));
+    }
+    SymbolicTerm lhs(false, {}, {lhs_tensor});
+    SymbolicTerm rhs(false, {}, rhs_tensors);
+    equations[n].emplace(std::move(signature_str),
+                         Equation(lhs, rhs, terms[n]->second));
+  });
+
+  // collect the equations in the order of the terms
+  std::map<std::string, std::vector<Equation>> result;
+  for (auto &signature_eq : equations) {
+    result[signature_eq->first].push_back(std::move(signature_eq->second));
   }
   return result;
 }
@@ -167,10 +294,10 @@ Expression make_operator_expr(const std::string &label,
   for (const std::string &s : components) {
     auto s_vec = split(s);
 
-    std::vector<int> cre_count(orbital_subspaces->num_spaces(), 0);
-    std::vector<int> ann_count(orbital_subspaces->num_spaces(), 0);
+    std::vector<int> cre_count(get_osi()->num_spaces(), 0);
+    std::vector<int> ann_count(get_osi()->num_spaces(), 0);
     for (const auto &s : s_vec) {
-      int space = orbital_subspaces->label_to_space(s[0]);
+      int space = get_osi()->label_to_space(s[0]);
       ann_count[space] += 1;
     }
 
@@ -179,7 +306,7 @@ Expression make_operator_expr(const std::string &label,
 
     // parse "v+ o"
     for (const auto &s : s_vec) {
-      int space = orbital_subspaces->label_to_space(s[0]);
+      int space = get_osi()->label_to_space(s[0]);
       if (s.size() == 2) {
         auto idx = Index(space, cre_count[space]);
         cre.push_back(idx);
@@ -207,46 +334,105 @@ Expression make_operator_expr(const std::string &label,
   return result;
 }
 
-Expression string_to_expr(const std::string &s, SymmetryType symmetry) {
-
-  TensorSyntax syntax = TensorSyntax::Wicked;
-  Expression sum;
-
-  // if we have an empty string, do not parse it (the code below would interpret
-  // it as the term 1)
-  if (s.size() == 0)
-    return sum;
-
-  //"f^{v0}_{o0} t^{o0}_{v0}"
-  std::string factor_re;
-  std::string tensor_re;
-  std::string operator_re;
-  if (syntax == TensorSyntax::Wicked) {
-    tensor_re = "([a-zA-Z0-9]+\\^\\{[\\w,\\s]*\\}_\\{[\\w,\\s]*\\})";
-    operator_re = "a([+-]{1,1})\\(([\\w,\\d]*)\\)";
-    factor_re = "^\\s*([+-]?\\d*\\/?\\d*)\\s*";
+namespace {
+/// Read a term (e.g., "-1/2 f^{v0}_{o0} { a+(o0) a-(v0) }") from a line
+void parse_term(string_scanner &in, SymmetryType symmetry, SymbolicTerm &term,
+                scalar_t &factor) {
+  auto error = [&]() {
+    return std::runtime_error("\nCould not convert the string " +
+                              std::string(in.input()) + " to a term");
+  };
+  factor = parse_rational(in);
+  while (in.skip_space(), not in.done()) {
+    if (in.accept('{')) {
+      // the operators of a normal-ordered term are enclosed in braces
+      term.set_normal_ordered(true);
+    } else if (term.normal_ordered() and in.accept('}')) {
+      continue;
+    } else if ((in.peek() == 'a') and
+               ((in.peek_next() == '+') or (in.peek_next() == '-'))) {
+      // an operator, e.g., "a+(o0)"
+      in.get();
+      const SQOperatorType type = in.get() == '+'
+                                      ? SQOperatorType::Creation
+                                      : SQOperatorType::Annihilation;
+      if (not in.accept('(')) {
+        throw error();
+      }
+      const Index index = parse_index(in);
+      if (not in.accept(')')) {
+        throw error();
+      }
+      term.add(SQOperator(type, index));
+    } else {
+      term.add(parse_tensor(in, symmetry));
+    }
   }
+}
 
-  auto tensors = findall(s, tensor_re);
-
-  SymbolicTerm term;
-  for (const auto &t : tensors) {
-    term.add(make_tensor_from_str(t, symmetry));
+/// Add the terms of a string (one term per line) to an expression. Blank lines
+/// and lines starting with # are skipped. The errors report the line number
+/// (counted from first_line) if report_line is true
+void parse_lines(std::string_view s, SymmetryType symmetry, Expression &result,
+                 bool report_line, int first_line = 1) {
+  string_scanner lines(s);
+  for (int n = first_line; not lines.done(); n++) {
+    string_scanner line(lines.read_line());
+    line.skip_space();
+    if (line.done() or (line.peek() == '#')) {
+      continue;
+    }
+    try {
+      SymbolicTerm term;
+      scalar_t factor;
+      parse_term(line, symmetry, term, factor);
+      result.add(term, factor);
+    } catch (const std::exception &e) {
+      if (not report_line) {
+        throw;
+      }
+      throw std::runtime_error("\nline " + std::to_string(n) + ": " +
+                               e.what());
+    }
   }
+}
+} // namespace
 
-  auto operators = findall(s, operator_re);
+Expression string_to_expr(const std::string &s, SymmetryType symmetry) {
+  Expression sum;
+  parse_lines(s, symmetry, sum, s.find('\n') != std::string::npos);
+  return sum;
+}
 
-  for (size_t n = 0; n < operators.size(); n += 2) {
-    SQOperatorType type = operators[n] == "+" ? SQOperatorType::Creation
-                                              : SQOperatorType::Annihilation;
-    Index index = make_index_from_str(operators[n + 1]);
-    term.add(SQOperator(type, index));
+Expression parse_expressions(const std::vector<std::string> &strings,
+                             SymmetryType symmetry) {
+  Expression sum;
+  for (size_t n = 0; n < strings.size(); n++) {
+    try {
+      parse_lines(strings[n], symmetry, sum,
+                  strings[n].find('\n') != std::string::npos);
+    } catch (const std::exception &e) {
+      throw std::runtime_error("\nstring " + std::to_string(n) + ": " +
+                               e.what());
+    }
   }
+  return sum;
+}
 
-  auto factor_vec = findall(s, factor_re);
-  scalar_t factor = make_rational_from_str(factor_vec[0]);
-
-  sum.add(term, factor);
-
+Expression parse_expression_file(const std::string &path,
+                                 SymmetryType symmetry) {
+  std::ifstream file(path, std::ios::binary);
+  if (not file) {
+    throw std::runtime_error("\nCould not open the file " + path);
+  }
+  // read the whole file at once, then parse it in place
+  const std::string s((std::istreambuf_iterator<char>(file)),
+                      std::istreambuf_iterator<char>());
+  Expression sum;
+  try {
+    parse_lines(s, symmetry, sum, true);
+  } catch (const std::exception &e) {
+    throw std::runtime_error("\n" + path + ": " + e.what());
+  }
   return sum;
 }
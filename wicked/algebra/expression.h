@@ -4,6 +4,7 @@
 #include <map>
 #include <vector>
 
+#include "compact_term.h"
 #include "equation.h"
 #include "helpers/algebra.hpp"
 #include "index.h"
@@ -11,23 +12,28 @@
 #include "wicked-def.h"
 
 /// A class to represent an algebraic expression
-class Expression : public Algebra<SymbolicTerm, scalar_t> {
+/// The terms are stored as compact records (see CompactTerm) and are
+/// materialized as SymbolicTerm objects only when accessed
+class Expression : public Algebra<CompactTerm, scalar_t> {
 public:
   // ==> Constructor <==
   Expression();
 
   // ==> Class public interface <==
 
-  // /// Return a map term -> factor
-  // const std::map<SymbolicTerm, scalar_t> &terms() const { return terms_; }
+  /// Return a map term -> factor (materializes all the terms)
+  std::map<SymbolicTerm, scalar_t> terms() const;
+
+  /// Return a map compact term -> factor
+  const vecspace_t &compact_terms() const { return const_terms(); }
 
   /// Add a term that can optionally be scaled
   void add(const Term &term);
 
   using Algebra::add;
 
-  // /// Add a term that can optionally be scaled
-  // void add(const SymbolicTerm &term, scalar_t coefficient = 1);
+  /// Add a term that can optionally be scaled
+  void add(const SymbolicTerm &term, scalar_t coefficient = 1);
 
   /// Add a term that can optionally be scaled
   void add(const std::pair<SymbolicTerm, scalar_t> &term_factor,
@@ -39,17 +45,21 @@ public:
   /// Canonicalize this sum
   Expression &canonicalize();
 
+  /// Return the adjoint of this sum in canonical form (see
+  /// SymbolicTerm::adjoint())
+  Expression adjoint() const;
+
   /// Reindex this sum
   Expression &reindex(index_map_t &idx_map);
 
   /// Compare this expression to another one
   bool operator==(const Expression &other);
 
-  // /// Add an expression
-  // Expression &operator+=(const Expression &terms);
+  /// Add an expression
+  Expression &operator+=(const Expression &terms);
 
-  // /// Substract an expression
-  // Expression &operator-=(const Expression &terms);
+  /// Substract an expression
+  Expression &operator-=(const Expression &terms);
 
   /// Return a string representation
   std::string str() const;
@@ -67,12 +77,28 @@ public:
 /// Print to an output stream
 std::ostream &operator<<(std::ostream &os, const Expression &sum);
 
+/// Return the string representation of a term as in Expression::str() (the
+/// sign of the coefficient is omitted if it is positive and first is true)
+std::string expression_term_str(const CompactTerm &term, scalar_t coefficient,
+                                bool first = false);
+
 /// The syntax used to input a tensor expression
 enum class TensorSyntax { Wicked, TCE };
 
-///// Create a sum from a string
+/// Create a sum from a string with one term per line, e.g.,
+///   -1/2 t^{o0,o1}_{v0,v1} v^{v0,v1}_{o0,o1}
+///   +f^{v0}_{o0} a+(o0) a-(v0)
+/// Blank lines and lines starting with # are skipped
 Expression string_to_expr(const std::string &s, SymmetryType symmetry);
 
+/// Create the sum of a list of strings (each parsed as in string_to_expr)
+Expression parse_expressions(const std::vector<std::string> &strings,
+                             SymmetryType symmetry);
+
+/// Read a sum from a file with one term per line (see string_to_expr)
+Expression parse_expression_file(const std::string &path,
+                                 SymmetryType symmetry);
+
 Expression make_operator_expr(const std::string &label,
                               const std::vector<std::string> &components,
                               bool normal_ordered, SymmetryType symmetry,
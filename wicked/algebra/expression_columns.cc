@@ -0,0 +1,81 @@
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "compact_term.h"
+#include "expression.h"
+
+#include "expression_columns.h"
+
+namespace {
+/// Convert a numerator or a denominator to a 64-bit integer
+int64_t to_int64(const rational_t &n) {
+  if ((n > std::numeric_limits<int64_t>::max()) or
+      (n < std::numeric_limits<int64_t>::min())) {
+    throw std::runtime_error(
+        "\nto_columns: a coefficient does not fit in a 64-bit integer");
+  }
+  return static_cast<int64_t>(n);
+}
+} // namespace
+
+ExpressionColumns to_columns(const Expression &expr) {
+  ExpressionColumns cols;
+  const auto &terms = expr.compact_terms();
+  const size_t nterms = terms.size();
+  cols.numerator.reserve(nterms);
+  cols.denominator.reserve(nterms);
+  cols.coefficient.reserve(nterms);
+  cols.normal_ordered.reserve(nterms);
+  cols.ops_id.reserve(nterms);
+  cols.tensor_offsets.reserve(nterms + 1);
+  cols.op_offsets.reserve(nterms + 1);
+  cols.tensor_offsets.push_back(0);
+  cols.op_offsets.push_back(0);
+  cols.index_offsets.push_back(0);
+
+  // the position of the label of each interned tensor (the terms share few
+  // distinct tensors, so the labels are looked up once per tensor id)
+  std::unordered_map<CompactTerm::id_t, int32_t> tensor_label;
+  std::unordered_map<std::string, int32_t> label_pos;
+
+  for (const auto &[term, c] : terms) {
+    cols.numerator.push_back(to_int64(c.numerator()));
+    cols.denominator.push_back(to_int64(c.denominator()));
+    cols.coefficient.push_back(c.to_double());
+    cols.normal_ordered.push_back(term.normal_ordered());
+    cols.ops_id.push_back(term.ops_id());
+
+    for (int i = 0; i < term.ntensors(); i++) {
+      const CompactTerm::id_t id = term.tensor_id(i);
+      const Tensor &tensor = interned_tensor(id);
+      auto search = tensor_label.find(id);
+      if (search == tensor_label.end()) {
+        auto label = label_pos.emplace(tensor.label(), cols.labels.size());
+        if (label.second) {
+          cols.labels.push_back(tensor.label());
+        }
+        search = tensor_label.emplace(id, label.first->second).first;
+      }
+      cols.tensor_id.push_back(id);
+      cols.tensor_label.push_back(search->second);
+      cols.tensor_nupper.push_back(tensor.upper().size());
+      for (const auto &indices : {&tensor.upper(), &tensor.lower()}) {
+        for (const Index &idx : *indices) {
+          cols.index_space.push_back(idx.space());
+          cols.index_pos.push_back(idx.pos());
+        }
+      }
+      cols.index_offsets.push_back(cols.index_space.size());
+    }
+    cols.tensor_offsets.push_back(cols.tensor_id.size());
+
+    for (const SQOperator &op : interned_operators(term.ops_id())) {
+      cols.op_creation.push_back(op.type() == SQOperatorType::Creation);
+      cols.op_space.push_back(op.index().space());
+      cols.op_pos.push_back(op.index().pos());
+    }
+    cols.op_offsets.push_back(cols.op_space.size());
+  }
+  return cols;
+}
@@ -0,0 +1,77 @@
+#ifndef _wicked_expression_columns_h_
+#define _wicked_expression_columns_h_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Expression;
+
+/**
+ * @brief A columnar (structure of arrays) representation of an Expression
+ *
+ * Each column is a flat array, so it can be passed to NumPy without creating
+ * one object per term. The terms are listed in the order of the expression.
+ * Variable-length data is stored in CSR layout: the tensors of term n are
+ * the entries [tensor_offsets[n], tensor_offsets[n + 1]) of the tensor
+ * columns, and similarly for the operators of a term and the indices of a
+ * tensor.
+ */
+struct ExpressionColumns {
+  // ==> One entry per term <==
+
+  /// the numerator of the coefficient
+  std::vector<int64_t> numerator;
+  /// the denominator of the coefficient
+  std::vector<int64_t> denominator;
+  /// the coefficient as a floating point number
+  std::vector<double> coefficient;
+  /// is the string of operators normal ordered? (0 or 1)
+  std::vector<uint8_t> normal_ordered;
+  /// the id of the interned string of operators (terms with the same
+  /// operators have the same id)
+  std::vector<uint32_t> ops_id;
+  /// the offsets of the tensors of each term (one more entry than the terms)
+  std::vector<int64_t> tensor_offsets;
+  /// the offsets of the operators of each term (one more entry than the terms)
+  std::vector<int64_t> op_offsets;
+
+  // ==> One entry per tensor <==
+
+  /// the id of the interned tensor (equal tensors have the same id)
+  std::vector<uint32_t> tensor_id;
+  /// the position of the tensor label in labels
+  std::vector<int32_t> tensor_label;
+  /// the number of upper indices
+  std::vector<int32_t> tensor_nupper;
+  /// the offsets of the indices of each tensor (one more entry than the
+  /// tensors). The upper indices are listed before the lower ones
+  std::vector<int64_t> index_offsets;
+
+  // ==> One entry per tensor index <==
+
+  /// the orbital space of the index
+  std::vector<int32_t> index_space;
+  /// the position of the index within its space
+  std::vector<int32_t> index_pos;
+
+  // ==> One entry per operator <==
+
+  /// 1 for a creation operator and 0 for an annihilation operator
+  std::vector<uint8_t> op_creation;
+  /// the orbital space of the operator index
+  std::vector<int32_t> op_space;
+  /// the position of the operator index within its space
+  std::vector<int32_t> op_pos;
+
+  // ==> Other data <==
+
+  /// the tensor labels, in order of first appearance
+  std::vector<std::string> labels;
+};
+
+/// Return the columnar representation of an expression. Throws if a
+/// coefficient does not fit in a 64-bit integer
+ExpressionColumns to_columns(const Expression &expr);
+
+#endif // _wicked_expression_columns_h_
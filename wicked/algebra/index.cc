@@ -3,6 +3,7 @@
 #include "helpers/combinatorics.h"
 #include "helpers/helpers.h"
 #include "helpers/orbital_space.h"
+#include "helpers/string_scanner.h"
 #include "index.h"
 
 Index::Index() : index_(std::make_pair(-1, -1)) {}
@@ -22,15 +23,15 @@ bool Index::operator<(Index const &other) const {
 }
 
 std::string Index::str() const {
-  return orbital_subspaces->label(space()) + std::to_string(pos());
+  return get_osi()->label(space()) + std::to_string(pos());
 }
 
 std::string Index::str_age() const {
-  return orbital_subspaces->label_age(space(), is_summed_) + std::to_string(pos());
+  return get_osi()->label_age(space(), is_summed_) + std::to_string(pos());
 }
 
 std::string Index::latex() const {
-  return orbital_subspaces->index_label(space(), pos());
+  return get_osi()->index_label(space(), pos());
 }
 
 std::string Index::compile(const std::string &format) const { return str(); }
@@ -61,24 +62,53 @@ scalar_t canonicalize_indices(std::vector<Index> &indices, bool reversed) {
   return permutation_sign(perm);
 }
 
+Index parse_index(string_scanner &in) {
+  const char label = in.get();
+  in.accept('_');
+  const std::string_view digits = in.read_digits();
+  // the position must fit in an int
+  if (not string_scanner::is_alpha(label) or digits.empty() or
+      (digits.size() > 9)) {
+    throw std::runtime_error("\nCould not convert the string " +
+                             std::string(in.input()) + " to an Index object");
+  }
+  int p = 0;
+  for (char c : digits) {
+    p = 10 * p + (c - '0');
+  }
+  return Index(get_osi()->label_to_space(label), p);
+}
+
+std::vector<Index> parse_indices(string_scanner &in) {
+  std::vector<Index> res;
+  in.skip_space();
+  while (string_scanner::is_alpha(in.peek())) {
+    res.push_back(parse_index(in));
+    in.skip_space();
+    if (not in.accept(',')) {
+      break;
+    }
+    in.skip_space();
+  }
+  return res;
+}
+
 Index make_index_from_str(const std::string &s) {
-  std::smatch sm;
-  auto m = std::regex_match(s, sm, std::regex("([a-zA-Z])[_]?(\\d+)"));
-  if (not m) {
+  string_scanner in(s);
+  Index idx = parse_index(in);
+  if (not in.done()) {
     throw std::runtime_error("\nCould not convert the string " + s +
                              " to an Index object");
   }
-  std::string label = sm[1];
-  auto space = orbital_subspaces->label_to_space(label[0]);
-  size_t p = stoi(sm[2]);
-  return Index(space, p);
+  return idx;
 }
 
 std::vector<Index> make_indices_from_str(const std::string &s) {
-  std::vector<Index> res;
-  auto s_split = split_indices(s);
-  for (const auto &subs : s_split) {
-    res.push_back(make_index_from_str(subs));
+  string_scanner in(s);
+  auto res = parse_indices(in);
+  if (not in.done()) {
+    throw std::runtime_error("\nCould not convert the string " + s +
+                             " to a list of Index objects");
   }
   return res;
 }
@@ -112,7 +142,7 @@ index_map_t remap(const std::vector<Index> &idx_vec1,
 }
 
 std::vector<int> num_indices_per_space(const std::vector<Index> &indices) {
-  std::vector<int> counter(orbital_subspaces->num_spaces());
+  std::vector<int> counter(get_osi()->num_spaces());
   for (const auto &index : indices) {
     counter[index.space()] += 1;
   }
@@ -122,7 +152,7 @@ std::vector<int> num_indices_per_space(const std::vector<Index> &indices) {
 int symmetry_factor(const std::vector<Index> &indices) {
   int result = 1;
   std::vector<int> idx_per_space = num_indices_per_space(indices);
-  for (int s = 0; s < orbital_subspaces->num_spaces(); ++s) {
+  for (int s = 0; s < get_osi()->num_spaces(); ++s) {
     result *= factorial(idx_per_space[s]);
   }
   return result;
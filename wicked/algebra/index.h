@@ -7,6 +7,8 @@
 
 #include "wicked-def.h"
 
+class string_scanner;
+
 /**
  * @brief A class to represent orbital indices.
  *
@@ -40,6 +42,9 @@ public:
   /// match the current flag
   void is_summed(const bool& is_summed);
 
+  /// @return is this a summation index?
+  bool is_summed() const { return is_summed_; }
+
   /// Comparison operator
   /// @return true if other index is equal to this
   bool operator==(Index const &other) const;
@@ -86,6 +91,12 @@ using index_map_t = std::map<Index, Index>;
 Index make_index_from_str(const std::string &index);
 std::vector<Index> make_indices_from_str(const std::string &index);
 
+/// Read an index (e.g., "o0") from a scanner
+Index parse_index(string_scanner &in);
+
+/// Read a list of indices separated by commas (e.g., "o0,v1") from a scanner
+std::vector<Index> parse_indices(string_scanner &in);
+
 /// Print to an output stream
 std::ostream &operator<<(std::ostream &os, const Index &idx);
 
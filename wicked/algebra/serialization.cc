@@ -0,0 +1,308 @@
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "compact_term.h"
+#include "equation.h"
+#include "expression.h"
+#include "symbolic_term.h"
+#include "tensor.h"
+
+#include "serialization.h"
+
+namespace {
+
+// the type tags of the serialized objects
+constexpr char rational_type = 'r';
+constexpr char symbolic_term_type = 't';
+constexpr char expression_type = 'x';
+constexpr char equation_type = 'q';
+
+/// The unsigned counterpart of rational_t, used to encode integers
+#if USE_BOOST_1024_INT
+using natural_t = boost::multiprecision::uint1024_t;
+#else
+using natural_t = uint64_t;
+#endif
+
+/// The number of bits of a natural_t
+constexpr int natural_bits = std::numeric_limits<natural_t>::digits;
+
+/// Write a natural_t as a varint
+void write_natural(byte_writer &out, natural_t n) {
+  while (n >= 0x80) {
+    out.byte(static_cast<uint8_t>(static_cast<unsigned>(n & 0x7f)) | 0x80);
+    n >>= 7;
+  }
+  out.byte(static_cast<uint8_t>(static_cast<unsigned>(n)));
+}
+
+/// Read a varint into a natural_t. Throws if it does not fit
+natural_t read_natural(byte_reader &in) {
+  natural_t n = 0;
+  for (int shift = 0; shift < natural_bits; shift += 7) {
+    const uint8_t b = in.byte();
+    const unsigned group = b & 0x7f;
+    if ((natural_bits - shift < 7) and (group >> (natural_bits - shift))) {
+      in.error("integer too large");
+    }
+    n |= natural_t(group) << shift;
+    if ((b & 0x80) == 0) {
+      return n;
+    }
+  }
+  in.error("integer too large");
+}
+
+/// Map an integer to a natural number (zig-zag encoding: 0, -1, 1, -2, ...
+/// are mapped to 0, 1, 2, 3, ...)
+natural_t zigzag_encode(const rational_t &n) {
+  return n < 0 ? (natural_t(-(n + 1)) << 1) | 1 : natural_t(n) << 1;
+}
+
+rational_t zigzag_decode(const natural_t &n) {
+  const rational_t half(n >> 1);
+  return (n & 1) ? -half - 1 : half;
+}
+
+/// Indices are packed in an integer: ((pos * nspaces + space) << 1) | summed
+uint64_t index_code(const byte_writer &out, const Index &idx) {
+  const uint64_t code =
+      static_cast<uint64_t>(idx.pos()) * out.num_spaces() + idx.space();
+  return (code << 1) | idx.is_summed();
+}
+
+Index code_to_index(const byte_reader &in, uint64_t code) {
+  const bool summed = code & 1;
+  code >>= 1;
+  if (in.num_spaces() == 0) {
+    in.error("invalid index");
+  }
+  Index idx(in.map_space(code % in.num_spaces()),
+            static_cast<int>(code / in.num_spaces()));
+  idx.is_summed(summed);
+  return idx;
+}
+
+void write_indices(byte_writer &out, const std::vector<Index> &indices) {
+  out.varint(indices.size());
+  for (const auto &idx : indices) {
+    out.varint(index_code(out, idx));
+  }
+}
+
+std::vector<Index> read_indices(byte_reader &in) {
+  std::vector<Index> indices(in.count());
+  for (auto &idx : indices) {
+    idx = code_to_index(in, in.varint());
+  }
+  return indices;
+}
+
+void write_tensor(byte_writer &out, const Tensor &tensor) {
+  out.label(tensor.label());
+  out.byte(static_cast<uint8_t>(tensor.symmetry()));
+  write_indices(out, tensor.lower());
+  write_indices(out, tensor.upper());
+}
+
+Tensor read_tensor(byte_reader &in) {
+  const std::string &label = in.label();
+  const uint8_t symmetry = in.byte();
+  if (symmetry > static_cast<uint8_t>(SymmetryType::Nonsymmetric)) {
+    in.error("invalid tensor symmetry");
+  }
+  auto lower = read_indices(in);
+  auto upper = read_indices(in);
+  return Tensor(label, lower, upper, static_cast<SymmetryType>(symmetry));
+}
+
+/// Operators are packed like indices, with the type in the lowest bit
+void write_operators(byte_writer &out, const std::vector<SQOperator> &ops) {
+  out.varint(ops.size());
+  for (const auto &op : ops) {
+    out.varint((index_code(out, op.index()) << 1) | op.is_creation());
+  }
+}
+
+std::vector<SQOperator> read_operators(byte_reader &in) {
+  const size_t n = in.count();
+  std::vector<SQOperator> ops;
+  ops.reserve(n);
+  for (size_t k = 0; k < n; k++) {
+    const uint64_t code = in.varint();
+    const auto type =
+        (code & 1) ? SQOperatorType::Creation : SQOperatorType::Annihilation;
+    ops.emplace_back(type, code_to_index(in, code >> 1));
+  }
+  return ops;
+}
+
+void write_symbolic_term(byte_writer &out, const SymbolicTerm &term) {
+  out.byte(term.normal_ordered());
+  out.varint(term.tensors().size());
+  for (const auto &tensor : term.tensors()) {
+    write_tensor(out, tensor);
+  }
+  write_operators(out, term.ops());
+}
+
+SymbolicTerm read_symbolic_term(byte_reader &in) {
+  const bool normal_ordered = in.byte();
+  std::vector<Tensor> tensors(in.count());
+  for (auto &tensor : tensors) {
+    tensor = read_tensor(in);
+  }
+  return SymbolicTerm(normal_ordered, read_operators(in), tensors);
+}
+
+} // namespace
+
+void write_rational(byte_writer &out, const scalar_t &r) {
+  write_natural(out, zigzag_encode(r.numerator()));
+  write_natural(out, natural_t(r.denominator()));
+}
+
+scalar_t read_rational(byte_reader &in) {
+  const rational_t n = zigzag_decode(read_natural(in));
+  const natural_t d = read_natural(in);
+  if ((d == 0) or (d > natural_t(std::numeric_limits<rational_t>::max()))) {
+    in.error("invalid rational number");
+  }
+  return scalar_t(n, rational_t(d));
+}
+
+std::string to_bytes(const scalar_t &r) {
+  byte_writer out(rational_type);
+  write_rational(out, r);
+  return out.str();
+}
+
+std::string to_bytes(const SymbolicTerm &term) {
+  byte_writer out(symbolic_term_type);
+  write_symbolic_term(out, term);
+  return out.str();
+}
+
+std::string to_bytes(const Expression &expr) {
+  // the tensors and the strings of operators are stored once in two tables.
+  // The terms refer to them by their position and are written in order, so
+  // they can be appended to the map of terms without searching it
+  std::unordered_map<CompactTerm::id_t, size_t> tensor_pos, ops_pos;
+  std::vector<CompactTerm::id_t> tensor_ids, ops_ids;
+  for (const auto &[term, c] : expr.compact_terms()) {
+    for (int i = 0; i < term.ntensors(); i++) {
+      if (tensor_pos.try_emplace(term.tensor_id(i), tensor_ids.size())
+              .second) {
+        tensor_ids.push_back(term.tensor_id(i));
+      }
+    }
+    if (ops_pos.try_emplace(term.ops_id(), ops_ids.size()).second) {
+      ops_ids.push_back(term.ops_id());
+    }
+  }
+
+  byte_writer out(expression_type);
+  out.varint(tensor_ids.size());
+  for (auto id : tensor_ids) {
+    write_tensor(out, interned_tensor(id));
+  }
+  out.varint(ops_ids.size());
+  for (auto id : ops_ids) {
+    write_operators(out, interned_operators(id));
+  }
+  out.varint(expr.size());
+  for (const auto &[term, c] : expr.compact_terms()) {
+    out.byte(term.normal_ordered());
+    out.varint(term.ntensors());
+    for (int i = 0; i < term.ntensors(); i++) {
+      out.varint(tensor_pos[term.tensor_id(i)]);
+    }
+    out.varint(ops_pos[term.ops_id()]);
+    write_rational(out, c);
+  }
+  return out.str();
+}
+
+std::string to_bytes(const Equation &eq) {
+  byte_writer out(equation_type);
+  write_symbolic_term(out, eq.lhs());
+  write_symbolic_term(out, eq.rhs());
+  write_rational(out, eq.rhs_factor());
+  return out.str();
+}
+
+scalar_t rational_from_bytes(const std::string &bytes) {
+  byte_reader in(bytes, rational_type);
+  const scalar_t r = read_rational(in);
+  in.finish();
+  return r;
+}
+
+SymbolicTerm symbolic_term_from_bytes(const std::string &bytes) {
+  byte_reader in(bytes, symbolic_term_type);
+  SymbolicTerm term = read_symbolic_term(in);
+  in.finish();
+  return term;
+}
+
+Expression expression_from_bytes(const std::string &bytes) {
+  byte_reader in(bytes, expression_type);
+  // the ids are not stored in a CompactTerm until the terms are read
+  interned_pool_user pool_user;
+  std::vector<CompactTerm::id_t> tensor_ids(in.count());
+  for (auto &id : tensor_ids) {
+    id = intern_tensor(read_tensor(in));
+  }
+  std::vector<CompactTerm::id_t> ops_ids(in.count());
+  for (auto &id : ops_ids) {
+    id = intern_operators(read_operators(in));
+  }
+
+  Expression result;
+  auto &terms = static_cast<Algebra<CompactTerm, scalar_t> &>(result).terms();
+  const size_t nterms = in.count();
+  std::vector<CompactTerm::id_t> ids;
+  for (size_t n = 0; n < nterms; n++) {
+    const bool normal_ordered = in.byte();
+    ids.resize(in.count());
+    for (auto &id : ids) {
+      const uint64_t pos = in.varint();
+      if (pos >= tensor_ids.size()) {
+        in.error("invalid tensor");
+      }
+      id = tensor_ids[pos];
+    }
+    const uint64_t pos = in.varint();
+    if (pos >= ops_ids.size()) {
+      in.error("invalid string of operators");
+    }
+    const scalar_t c = read_rational(in);
+    if (c == 0) {
+      in.error("invalid coefficient");
+    }
+    // the terms were written in order, so this is an append (unless the
+    // spaces are defined in another order)
+    const size_t size = terms.size();
+    terms.emplace_hint(terms.end(),
+                       CompactTerm(normal_ordered, ops_ids[pos], ids), c);
+    if (terms.size() == size) {
+      in.error("duplicate term");
+    }
+  }
+  in.finish();
+  // the terms are not canonical if the spaces are defined in another order
+  if (not in.spaces_in_order()) {
+    result.canonicalize();
+  }
+  return result;
+}
+
+Equation equation_from_bytes(const std::string &bytes) {
+  byte_reader in(bytes, equation_type);
+  SymbolicTerm lhs = read_symbolic_term(in);
+  SymbolicTerm rhs = read_symbolic_term(in);
+  const scalar_t factor = read_rational(in);
+  in.finish();
+  return Equation(lhs, rhs, factor);
+}
@@ -0,0 +1,48 @@
+#ifndef _wicked_serialization_h_
+#define _wicked_serialization_h_
+
+#include <string>
+
+#include "helpers/byte_stream.h"
+#include "wicked-def.h"
+
+class SymbolicTerm;
+class Expression;
+class Equation;
+
+// Serialization of algebraic objects in a compact binary format (see
+// helpers/byte_stream.h). The orbital spaces used by an object must be
+// defined (with the same labels) in the process that reads it.
+
+/// Return the binary representation of a rational number
+std::string to_bytes(const scalar_t &r);
+
+/// Return the binary representation of a term
+std::string to_bytes(const SymbolicTerm &term);
+
+/// Return the binary representation of an expression
+std::string to_bytes(const Expression &expr);
+
+/// Return the binary representation of an equation
+std::string to_bytes(const Equation &eq);
+
+/// Create a rational number from its binary representation
+scalar_t rational_from_bytes(const std::string &bytes);
+
+/// Create a term from its binary representation
+SymbolicTerm symbolic_term_from_bytes(const std::string &bytes);
+
+/// Create an expression from its binary representation
+Expression expression_from_bytes(const std::string &bytes);
+
+/// Create an equation from its binary representation
+Equation equation_from_bytes(const std::string &bytes);
+
+/// Write a rational number (the numerator and the denominator are varints,
+/// the sign is stored in the lowest bit of the numerator)
+void write_rational(byte_writer &out, const scalar_t &r);
+
+/// Read a rational number
+scalar_t read_rational(byte_reader &in);
+
+#endif // _wicked_serialization_h_
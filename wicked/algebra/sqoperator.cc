@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "sqoperator.h"
 #include "helpers/combinatorics.h"
 #include "helpers/helpers.h"
@@ -12,7 +14,7 @@ SQOperator::~SQOperator() {}
 SQOperatorType SQOperator::type() const { return operator_.first; }
 
 FieldType SQOperator::field_type() const {
-  return orbital_subspaces->field_type(space());
+  return get_osi()->field_type(space());
 }
 
 Index SQOperator::index_mut() { return operator_.second; }
@@ -25,7 +27,7 @@ bool SQOperator::is_creation() const {
 }
 
 std::string SQOperator::op_symbol() const {
-  return orbital_subspaces->op_symbol(space());
+  return get_osi()->op_symbol(space());
 }
 
 void SQOperator::reindex(index_map_t &idx_map) {
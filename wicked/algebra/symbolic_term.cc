@@ -1,5 +1,9 @@
 #include <algorithm>
+#include <bitset>
+#include <functional>
+#include <string_view>
 
+#include "helpers/arena.hpp"
 #include "helpers/combinatorics.h"
 #include "helpers/helpers.h"
 #include "helpers/orbital_space.h"
@@ -45,6 +49,21 @@ int SymbolicTerm::nops() const { return operators_.size(); }
 //   return result;
 // }
 
+SymbolicTerm SymbolicTerm::adjoint() const {
+  SymbolicTerm result;
+  result.normal_ordered_ = normal_ordered_;
+  for (const auto &t : tensors_) {
+    result.tensors_.emplace_back(t.label(), t.upper(), t.lower(), t.symmetry());
+  }
+  for (auto it = operators_.rbegin(); it != operators_.rend(); ++it) {
+    const SQOperatorType type = (it->type() == SQOperatorType::Creation)
+                                    ? SQOperatorType::Annihilation
+                                    : SQOperatorType::Creation;
+    result.operators_.emplace_back(type, it->index());
+  }
+  return result;
+}
+
 void SymbolicTerm::reindex(index_map_t &idx_map) {
   for (auto &t : tensors_) {
     t.reindex(idx_map);
@@ -54,194 +73,451 @@ void SymbolicTerm::reindex(index_map_t &idx_map) {
   }
 }
 
-#define NEW_CANONICALIZATION 1
-scalar_t SymbolicTerm::canonicalize() {
-  scalar_t factor(1);
-
-//
-// 1. Sort the tensors according to a score function
-//
-#if NEW_CANONICALIZATION
-  using score_t =
-      std::tuple<std::string, int, std::vector<int>, std::vector<int>,
-                 std::vector<std::pair<std::string, std::vector<int>>>,
-                 std::vector<std::pair<std::string, std::vector<int>>>, Tensor>;
-#else
-  using score_t =
-      std::tuple<std::string, int, std::vector<int>, std::vector<int>, Tensor>;
-#endif
-
-  std::vector<score_t> scores;
+namespace {
+/// The maximum number of tensors in a term that can be canonicalized
+constexpr size_t max_tensors = 64;
+
+/// A dense numbering of the indices of a term. The index (s,p) is assigned
+/// the number offset[s] + p.
+class index_table {
+public:
+  index_table(const std::vector<Tensor> &tensors,
+              const std::vector<SQOperator> &ops)
+      : offset_(get_osi()->num_spaces() + 1, 0) {
+    for (const auto &tensor : tensors) {
+      for (const auto &idx : tensor.lower())
+        include(idx);
+      for (const auto &idx : tensor.upper())
+        include(idx);
+    }
+    for (const auto &op : ops) {
+      include(op.index());
+    }
+    // convert the number of indices in each space to offsets
+    std::partial_sum(offset_.begin(), offset_.end(), offset_.begin());
+  }
 
-  WPRINT(std::cout << "\n Canonicalizing: " << str() << std::endl;);
+  /// the number assigned to an index
+  int id(const Index &idx) const { return offset_[idx.space()] + idx.pos(); }
 
-  for (const auto &tensor : tensors_) {
-    // a) label
-    const std::string &label = tensor.label();
-
-    // b) rank
-    int rank = tensor.rank();
-
-    // c) number of indices per space
-    std::vector<int> num_low = num_indices_per_space(tensor.lower());
-    std::vector<int> num_upp = num_indices_per_space(tensor.upper());
-
-    // d) connectivity of lower indices
-    auto lower_conn = tensor_connectivity(tensor, false);
-
-    // d) connectivity of upper indices
-    auto upper_conn = tensor_connectivity(tensor, true);
-
-    // e) store the score
-#if NEW_CANONICALIZATION
-    scores.push_back(std::make_tuple(label, rank, num_low, num_upp, lower_conn,
-                                     upper_conn, tensor));
-    WPRINT(
-        std::cout << "\nScore = " << label << " " << rank << " ";
-        PRINT_ELEMENTS(num_low); std::cout << " "; PRINT_ELEMENTS(num_upp);
-        std::cout << " "; for (const auto &str_vec
-                               : lower_conn) {
-          std::cout << str_vec.first << " ";
-          PRINT_ELEMENTS(str_vec.second);
-        } for (const auto &str_vec
-               : upper_conn) {
-          std::cout << " " << str_vec.first << " ";
-          PRINT_ELEMENTS(str_vec.second);
-        });
-
-#else
-    scores.push_back(std::make_tuple(label, rank, num_low, num_upp, tensor));
-#endif
-  }
-
-  // sort and rearrange tensors
-  std::sort(scores.begin(), scores.end());
-  tensors_.clear();
-  for (const auto &score : scores) {
-#if NEW_CANONICALIZATION
-    tensors_.push_back(std::get<6>(score));
-#else
-    tensors_.push_back(std::get<4>(score));
-#endif
-  }
-
-  // 2. Relabel indices of tensors and operators
-  // vector to keep track of how many indices in each space
-  std::vector<int> sqop_index_count(orbital_subspaces->num_spaces(), 0);
-  // vector to keep track of how many indices in each space
-  std::vector<int> tens_index_count(orbital_subspaces->num_spaces(), 0);
-  index_map_t index_map;
-  std::map<Index, bool> is_operator_index;
-
-  // a. Assign indices to free operators
-  for (const auto &sqop : operators_) {
-    tens_index_count[sqop.index().space()] += 1;
-    is_operator_index[sqop.index()] = true;
+  /// the total number of indices
+  size_t size() const { return offset_.back(); }
+
+private:
+  void include(const Index &idx) {
+    int &size = offset_[idx.space() + 1];
+    size = std::max(size, idx.pos() + 1);
   }
 
-  // b. Assign indices to tensors operators
-  for (const auto &tensor : tensors_) {
-    // lower indices
+  arena_vector<int> offset_;
+};
+
+/// The location of an index in the tensor network of a term. Bit p of lower
+/// (upper) is set if the index is a lower (upper) index of the p-th tensor.
+struct index_slots {
+  std::bitset<max_tensors> lower;
+  std::bitset<max_tensors> upper;
+  /// bit 0 (1) is set if the index belongs to a creation (annihilation) op
+  int ops = 0;
+};
+
+/// Locate all the indices of a term given an ordering of its tensors
+arena_vector<index_slots> make_slots(const std::vector<Tensor> &tensors,
+                                     const arena_vector<int> &order,
+                                     const std::vector<SQOperator> &ops,
+                                     const index_table &table) {
+  arena_vector<index_slots> slots(table.size());
+  for (size_t p = 0; p < order.size(); p++) {
+    const auto &tensor = tensors[order[p]];
     for (const auto &l : tensor.lower()) {
-      if (is_operator_index.count(l) == 0) {
-        // this index is not shared with an operator
-        if (index_map.count(l) == 0) {
-          int s = l.space();
-          index_map[l] = Index(s, tens_index_count[s]);
-          tens_index_count[s] += 1;
-        }
-      } else {
-        // this index is shared with an operator
-        if (index_map.count(l) == 0) {
-          int s = l.space();
-          index_map[l] = Index(s, sqop_index_count[s]);
-          sqop_index_count[s] += 1;
-        }
-      }
+      slots[table.id(l)].lower[p] = true;
     }
-    // upper indices
     for (const auto &u : tensor.upper()) {
-      if (is_operator_index.count(u) == 0) {
-        if (index_map.count(u) == 0) {
-          int s = u.space();
-          index_map[u] = Index(s, tens_index_count[s]);
-          tens_index_count[s] += 1;
-        }
-      } else {
-        if (index_map.count(u) == 0) {
-          int s = u.space();
-          index_map[u] = Index(s, sqop_index_count[s]);
-          sqop_index_count[s] += 1;
-        }
-      }
+      slots[table.id(u)].upper[p] = true;
     }
   }
-  // reindex the tensor
-  reindex(index_map);
+  for (const auto &op : ops) {
+    slots[table.id(op.index())].ops |= op.is_creation() ? 1 : 2;
+  }
+  return slots;
+}
 
-  // 3. Sort tensor indices according to canonical form
-  for (auto &tensor : tensors_) {
-    factor *= tensor.canonicalize();
+/// Order two indices by their location in the tensor network. Indices that
+/// belong to operators come last, and among the others the one that appears
+/// first in the sequence of tensors (lower before upper indices) comes first.
+/// Indices that compare equal can be exchanged without changing the term.
+bool slots_less(const index_slots &a, const index_slots &b, size_t ntensors) {
+  if (a.ops != b.ops) {
+    return a.ops < b.ops;
+  }
+  for (size_t p = 0; p < ntensors; p++) {
+    if (a.lower[p] != b.lower[p]) {
+      return a.lower[p];
+    }
+    if (a.upper[p] != b.upper[p]) {
+      return a.upper[p];
+    }
   }
+  return false;
+}
 
-  // 4. Sort operators according to canonical form
-  factor *= canonicalize_sqops(operators_, false);
+/// The number of indices that a group of indices (upper or lower) of a tensor
+/// shares with each of the other tensors. Each entry stores the label of the
+/// other tensor and the number of shared indices in each space.
+using connectivity_t =
+    arena_vector<std::pair<std::string_view, arena_vector<int>>>;
+
+/// An invariant score used to sort tensors. Tensors with different scores are
+/// not equivalent.
+using score_t = std::tuple<std::string_view, int, arena_vector<int>,
+                           arena_vector<int>, connectivity_t, connectivity_t>;
+
+/// Count the number of indices in each space (stored in the thread arena)
+arena_vector<int>
+arena_num_indices_per_space(const std::vector<Index> &indices) {
+  arena_vector<int> counter(get_osi()->num_spaces(), 0);
+  for (const auto &index : indices) {
+    counter[index.space()] += 1;
+  }
+  return counter;
+}
 
-  simplify();
+/// Find how the lower (upper) indices of tensor p connect to the upper (lower)
+/// indices of all the other tensors
+connectivity_t tensor_connectivity(const std::vector<Tensor> &tensors,
+                                   const index_table &table,
+                                   const arena_vector<index_slots> &slots,
+                                   size_t p, bool upper) {
+  const size_t ntensors = tensors.size();
+  const int nspaces = get_osi()->num_spaces();
+  connectivity_t result;
+  result.reserve(ntensors - 1);
+  for (size_t q = 0; q < ntensors; q++) {
+    if (q != p) {
+      result.emplace_back(tensors[q].label(), arena_vector<int>(nspaces, 0));
+    }
+  }
+  const auto &indices = upper ? tensors[p].upper() : tensors[p].lower();
+  for (const auto &index : indices) {
+    const auto &s = slots[table.id(index)];
+    const auto &other = upper ? s.lower : s.upper;
+    for (size_t q = 0; q < ntensors; q++) {
+      if (other[q] and (q != p)) {
+        result[q < p ? q : q - 1].second[index.space()] += 1;
+      }
+    }
+  }
+  std::sort(result.begin(), result.end());
+  return result;
+}
 
-  WPRINT(std::cout << "\n  " << str();)
+/// Replace each element of a vector with its rank among the sorted elements
+template <class T> arena_vector<int> ranks(const arena_vector<T> &v) {
+  arena_vector<const T *> sorted;
+  sorted.reserve(v.size());
+  for (const auto &e : v) {
+    sorted.push_back(&e);
+  }
+  auto less = [](const T *a, const T *b) { return *a < *b; };
+  std::sort(sorted.begin(), sorted.end(), less);
+  arena_vector<int> result;
+  result.reserve(v.size());
+  for (const auto &e : v) {
+    result.push_back(std::lower_bound(sorted.begin(), sorted.end(), &e, less) -
+                     sorted.begin());
+  }
+  return result;
+}
 
-  return factor;
+/// Count the number of distinct classes
+size_t num_classes(const arena_vector<int> &classes) {
+  arena_vector<int> sorted(classes.begin(), classes.end());
+  std::sort(sorted.begin(), sorted.end());
+  return std::unique(sorted.begin(), sorted.end()) - sorted.begin();
 }
 
-scalar_t SymbolicTerm::simplify() {
-  WPRINT(cout << "\nSymbolic term simplification " << endl;);
-  scalar_t factor = 1;
-  // Canonicalize each space separately
-  for (int s = 0; s < orbital_subspaces->num_spaces(); s++) {
-    WPRINT(cout << "\nSpace " << orbital_subspaces->label(s) << endl;);
-
-    std::vector<std::vector<Index>> equivalent_classes;
-    std::vector<std::pair<std::bitset<64>, std::bitset<64>>> ul_bit_masks;
-    for (const auto &tensor : tensors_) {
-      std::bitset<64> upper_bits, lower_bits;
-      {
-        std::vector<Index> equivalent;
-        for (const auto &u : tensor.upper()) {
-          if (u.space() == s) {
-            equivalent.push_back(u);
-            upper_bits[u.pos()] = true;
+/// Refine a partition of the tensors into classes until no class can be
+/// split. The key of a tensor is its class followed by a code for each of its
+/// indices that records the classes of the tensors (and the operators) the
+/// index connects to. Classes are numbered in sorted order, and the relative
+/// order of the existing classes is preserved
+void refine_classes(const std::vector<Tensor> &tensors,
+                    const index_table &table,
+                    const arena_vector<index_slots> &slots,
+                    arena_vector<int> &classes) {
+  const size_t ntensors = tensors.size();
+  const int nspaces = get_osi()->num_spaces();
+  using key_t = arena_vector<arena_vector<int>>;
+  const int ncodes = 2 * static_cast<int>(ntensors);
+  size_t nclasses = num_classes(classes);
+  while (nclasses < ntensors) {
+    arena_vector<key_t> keys(ntensors);
+    for (size_t p = 0; p < ntensors; p++) {
+      keys[p].push_back(arena_vector<int>(1, classes[p]));
+      for (int g = 0; g < 2; g++) {
+        const auto &indices = g ? tensors[p].upper() : tensors[p].lower();
+        for (const auto &index : indices) {
+          const auto &s = slots[table.id(index)];
+          arena_vector<int> code(1, g * nspaces + index.space());
+          for (size_t q = 0; q < ntensors; q++) {
+            if (q == p)
+              continue;
+            if (s.lower[q])
+              code.push_back(2 * classes[q]);
+            if (s.upper[q])
+              code.push_back(2 * classes[q] + 1);
           }
+          if (s.ops)
+            code.push_back(ncodes + s.ops);
+          std::sort(code.begin() + 1, code.end());
+          keys[p].push_back(std::move(code));
         }
-        if (equivalent.size() > 0)
-          equivalent_classes.push_back(equivalent);
       }
-      {
-        std::vector<Index> equivalent;
-        for (const auto &l : tensor.lower()) {
-          if (l.space() == s) {
-            equivalent.push_back(l);
-            lower_bits[l.pos()] = true;
-          }
+      std::sort(keys[p].begin() + 1, keys[p].end());
+    }
+    classes = ranks(keys);
+    const size_t new_nclasses = num_classes(classes);
+    if (new_nclasses == nclasses)
+      break;
+    nclasses = new_nclasses;
+  }
+}
+
+/// Partition the tensors into classes of equivalent tensors. Tensors are first
+/// sorted by their score and the classes are then refined (see
+/// refine_classes). Returns the class of each tensor
+arena_vector<int> tensor_classes(const std::vector<Tensor> &tensors,
+                                 const index_table &table,
+                                 const arena_vector<index_slots> &slots) {
+  const size_t ntensors = tensors.size();
+  arena_vector<score_t> scores;
+  scores.reserve(ntensors);
+  for (size_t p = 0; p < ntensors; p++) {
+    const auto &tensor = tensors[p];
+    scores.emplace_back(tensor.label(), tensor.rank(),
+                        arena_num_indices_per_space(tensor.lower()),
+                        arena_num_indices_per_space(tensor.upper()),
+                        tensor_connectivity(tensors, table, slots, p, false),
+                        tensor_connectivity(tensors, table, slots, p, true));
+  }
+  arena_vector<int> classes = ranks(scores);
+  refine_classes(tensors, table, slots, classes);
+  return classes;
+}
+
+/// Return true if the tensor p is in the orbit of one of the tensors in
+/// explored under the group generated by the automorphisms (permutations of
+/// the ntensors tensors) that fix all the tensors in path
+bool in_explored_orbit(int p, size_t ntensors,
+                       const arena_vector<int> &explored,
+                       const arena_vector<int> &path,
+                       const arena_vector<arena_vector<int>> &automorphisms) {
+  arena_vector<bool> reached(ntensors, false);
+  arena_vector<int> stack(explored.begin(), explored.end());
+  for (int q : explored) {
+    reached[q] = true;
+  }
+  while (not stack.empty()) {
+    const int q = stack.back();
+    stack.pop_back();
+    for (const auto &gamma : automorphisms) {
+      const bool fixes_path = std::all_of(
+          path.begin(), path.end(), [&](int r) { return gamma[r] == r; });
+      if (fixes_path and not reached[gamma[q]]) {
+        reached[gamma[q]] = true;
+        stack.push_back(gamma[q]);
+      }
+    }
+  }
+  return reached[p];
+}
+
+/// Assign new labels to the indices of a term given an ordering of its
+/// tensors. The new position of the index with number n is stored in
+/// new_pos[n]. Indices are labeled in order of appearance in the tensors
+/// (lower before upper indices), and indices shared with operators are
+/// numbered first, followed by the indices found only in tensors.
+void label_indices(const std::vector<Tensor> &tensors,
+                   const arena_vector<int> &order,
+                   const std::vector<SQOperator> &ops, const index_table &table,
+                   arena_vector<int> &new_pos) {
+  const size_t ntensors = tensors.size();
+  const int nspaces = get_osi()->num_spaces();
+  const auto slots = make_slots(tensors, order, ops, table);
+
+  arena_vector<int> sqop_index_count(nspaces, 0);
+  arena_vector<int> tens_index_count(nspaces, 0);
+  for (const auto &sqop : ops) {
+    tens_index_count[sqop.index().space()] += 1;
+  }
+  std::fill(new_pos.begin(), new_pos.end(), -1);
+
+  arena_vector<Index> group;
+  auto label_group = [&]() {
+    // groups are short, so use an insertion sort
+    for (size_t i = 1; i < group.size(); i++) {
+      for (size_t j = i; (j > 0) and slots_less(slots[table.id(group[j])],
+                                                slots[table.id(group[j - 1])],
+                                                ntensors);
+           j--) {
+        std::swap(group[j], group[j - 1]);
+      }
+    }
+    for (const auto &idx : group) {
+      const int n = table.id(idx);
+      if (new_pos[n] < 0) {
+        auto &count = slots[n].ops ? sqop_index_count : tens_index_count;
+        new_pos[n] = count[idx.space()]++;
+      }
+    }
+    group.clear();
+  };
+  for (int p : order) {
+    for (const auto *indices : {&tensors[p].lower(), &tensors[p].upper()}) {
+      for (const auto &idx : *indices) {
+        if (new_pos[table.id(idx)] < 0) {
+          group.push_back(idx);
         }
-        if (equivalent.size() > 0)
-          equivalent_classes.push_back(equivalent);
       }
-      ul_bit_masks.push_back(std::make_pair(upper_bits, lower_bits));
+      label_group();
+    }
+  }
+  // indices found only in operators
+  for (const auto &sqop : ops) {
+    if (new_pos[table.id(sqop.index())] < 0) {
+      group.push_back(sqop.index());
+    }
+  }
+  label_group();
+}
+} // namespace
+
+scalar_t SymbolicTerm::canonicalize() {
+  // all the temporaries used by the canonicalization are released in one step
+  // at the end of this scope
+  arena_scope scope;
+
+  WPRINT(std::cout << "\n Canonicalizing: " << str() << std::endl;);
+
+  const size_t ntensors = tensors_.size();
+  if (ntensors > max_tensors) {
+    throw std::runtime_error("SymbolicTerm::canonicalize cannot canonicalize "
+                             "a term with more than " +
+                             std::to_string(max_tensors) + " tensors");
+  }
+
+  // 1. Partition the tensors into classes of equivalent tensors
+  const index_table table(tensors_, operators_);
+  arena_vector<int> order(ntensors);
+  std::iota(order.begin(), order.end(), 0);
+  const auto slots = make_slots(tensors_, order, operators_, table);
+  const auto classes = tensor_classes(tensors_, table, slots);
+
+  // 2. For an ordering of the tensors relabel the indices, sort the indices
+  // of the tensors and the operators, and build the term
+  arena_vector<int> new_pos(table.size());
+  auto make_term = [&](SymbolicTerm &term) {
+    label_indices(tensors_, order, operators_, table, new_pos);
+    term.normal_ordered_ = normal_ordered_;
+    term.operators_ = operators_;
+    term.tensors_.clear();
+    term.tensors_.reserve(ntensors);
+    for (int p : order) {
+      term.tensors_.push_back(tensors_[p]);
+    }
+    auto relabel = [&](Index &idx) {
+      idx = Index(idx.space(), new_pos[table.id(idx)]);
+    };
+    scalar_t factor(1);
+    for (auto &tensor : term.tensors_) {
+      std::for_each(tensor.lower_mut().begin(), tensor.lower_mut().end(),
+                    relabel);
+      std::for_each(tensor.upper_mut().begin(), tensor.upper_mut().end(),
+                    relabel);
+      factor *= tensor.canonicalize();
     }
-    WPRINT(
-        for (const auto &v
-             : equivalent_classes) {
-          PRINT_ELEMENTS(v);
-          cout << endl;
-        } for (const auto &[ub, lb]
-               : ul_bit_masks) {
-          cout << ub << endl;
-          cout << lb << endl;
-        });
-  }
-
-  return factor;
+    for (auto &op : term.operators_) {
+      op = SQOperator(op.type(), Index(op.index().space(),
+                                       new_pos[table.id(op.index())]));
+    }
+    factor *= canonicalize_sqops(term.operators_, false);
+    WPRINT(std::cout << "\n  candidate: " << term.str() << std::endl;);
+    return factor;
+  };
+
+  // 3. Order the equivalent tensors by individualization and refinement:
+  // one tensor of the first class with more than one tensor is given a class
+  // of its own and the classes are refined, until every tensor is in its own
+  // class. Each branch gives an ordering, and the term that compares lowest
+  // is kept. Two orderings that give the same term define an automorphism
+  // (a permutation of the tensors that leaves the term unchanged), and the
+  // branches that an automorphism maps onto explored ones are skipped
+  SymbolicTerm best, term;
+  scalar_t best_factor;
+  arena_vector<int> best_order;
+  arena_vector<arena_vector<int>> automorphisms;
+  arena_vector<int> path;
+  std::function<void(arena_vector<int> &)> search =
+      [&](arena_vector<int> &cls) {
+        refine_classes(tensors_, table, slots, cls);
+        if (num_classes(cls) == ntensors) {
+          // the classes are 0, 1, ..., ntensors - 1
+          for (size_t p = 0; p < ntensors; p++) {
+            order[cls[p]] = p;
+          }
+          scalar_t factor = make_term(term);
+          if (best_order.empty() or (term < best)) {
+            std::swap(term, best);
+            best_factor = factor;
+            best_order = order;
+          } else if (term == best) {
+            arena_vector<int> gamma(ntensors);
+            for (size_t p = 0; p < ntensors; p++) {
+              gamma[best_order[p]] = order[p];
+            }
+            automorphisms.push_back(std::move(gamma));
+          }
+          return;
+        }
+        // the tensors of the first class with more than one tensor
+        arena_vector<int> count(ntensors, 0);
+        for (int c : cls) {
+          count[c] += 1;
+        }
+        const int target = std::find_if(count.begin(), count.end(),
+                                        [](int n) { return n > 1; }) -
+                           count.begin();
+        arena_vector<int> members;
+        for (size_t p = 0; p < ntensors; p++) {
+          if (cls[p] == target) {
+            members.push_back(p);
+          }
+        }
+        arena_vector<int> explored;
+        for (int p : members) {
+          if (in_explored_orbit(p, ntensors, explored, path, automorphisms)) {
+            continue;
+          }
+          explored.push_back(p);
+          // the classes are ranks, so target + 1 is not in use
+          arena_vector<int> next(cls);
+          for (int q : members) {
+            if (q != p) {
+              next[q] = target + 1;
+            }
+          }
+          path.push_back(p);
+          search(next);
+          path.pop_back();
+        }
+      };
+  arena_vector<int> initial(classes);
+  search(initial);
+  *this = std::move(best);
+
+  WPRINT(std::cout << "\n  " << str();)
+
+  return best_factor;
 }
 
 bool SymbolicTerm::operator<(const SymbolicTerm &other) const {
@@ -337,33 +613,3 @@ std::ostream &operator<<(std::ostream &os,
   os << term_factor.second << ' ' << term_factor.second;
   return os;
 }
-
-std::vector<std::pair<std::string, std::vector<int>>>
-SymbolicTerm::tensor_connectivity(const Tensor &t, bool upper) const {
-  std::vector<std::pair<std::string, std::vector<int>>> result;
-  auto indices = upper ? t.upper() : t.lower();
-  sort(indices.begin(), indices.end());
-  for (const auto &tensor : tensors_) {
-    if (not(t == tensor)) {
-
-      std::vector<Index> indices2 = upper ? tensor.lower() : tensor.upper();
-      sort(indices2.begin(), indices2.end());
-
-      std::vector<Index> indices3 = tensor.upper();
-      sort(indices3.begin(), indices3.end());
-
-      std::vector<Index> common_lower_indices;
-      set_intersection(indices.begin(), indices.end(), indices2.begin(),
-                       indices2.end(), back_inserter(common_lower_indices));
-
-      std::vector<Index> common_upper_indices;
-      set_intersection(indices.begin(), indices.end(), indices3.begin(),
-                       indices3.end(), back_inserter(common_upper_indices));
-
-      result.push_back(std::make_pair(
-          tensor.label(), num_indices_per_space(common_lower_indices)));
-    }
-  }
-  std::sort(result.begin(), result.end());
-  return result;
-}
@@ -56,6 +56,11 @@ public:
   /// Return the tensors
   const std::vector<Tensor> &tensors() const { return tensors_; }
 
+  /// Return the adjoint of this term (assuming real tensors): the upper and
+  /// lower indices of each tensor are swapped and the string of operators is
+  /// reversed and conjugated. The result is not canonicalized
+  SymbolicTerm adjoint() const;
+
   /// Apply a re-indexing map to this symbolic term
   void reindex(index_map_t &idx_map);
 
@@ -65,8 +70,6 @@ public:
   /// Canonicalize this term and return the overall phase factor
   // bool is_connected();
 
-  scalar_t simplify();
-
   /// Comparison operator used for sorting
   bool operator<(const SymbolicTerm &term) const;
 
@@ -90,13 +93,6 @@ protected:
   bool normal_ordered_ = false;
   std::vector<SQOperator> operators_;
   std::vector<Tensor> tensors_;
-
-  // ==> Class private functions <==
-
-  // Used in the canonicalization routine to find how the indices of a tensor
-  // connect to all the other tensors
-  std::vector<std::pair<std::string, std::vector<int>>>
-  tensor_connectivity(const Tensor &t, bool upper) const;
 };
 
 // Helper functions
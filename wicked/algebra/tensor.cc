@@ -1,19 +1,36 @@
 #include <algorithm>
 #include <iostream>
-#include <regex>
+#include <stdexcept>
 
 #include "helpers/helpers.h"
 #include "helpers/orbital_space.h"
+#include "helpers/string_scanner.h"
 
 #include "tensor.h"
 #include "wicked-def.h"
 
+namespace {
+/// Sort a vector of indices in place and return the sign of the permutation.
+/// Uses an insertion sort, which is faster than a general sort for the short
+/// vectors found in tensors and does not allocate memory.
+int sort_indices(std::vector<Index> &indices) {
+  int sign = 1;
+  for (size_t i = 1; i < indices.size(); i++) {
+    for (size_t j = i; (j > 0) and (indices[j] < indices[j - 1]); j--) {
+      std::swap(indices[j], indices[j - 1]);
+      sign = -sign;
+    }
+  }
+  return sign;
+}
+} // namespace
+
 Tensor::Tensor(const std::string &label, const std::vector<Index> &lower,
                const std::vector<Index> &upper, SymmetryType symmetry)
     : label_(label), lower_(lower), upper_(upper), symmetry_(symmetry) {}
 
 std::vector<std::pair<int, int>> Tensor::signature() const {
-  std::vector<std::pair<int, int>> result(orbital_subspaces->num_spaces(),
+  std::vector<std::pair<int, int>> result(get_osi()->num_spaces(),
                                           std::pair(0, 0));
   for (const Index &idx : upper_) {
     result[idx.space()].first += 1;
@@ -79,14 +96,9 @@ scalar_t Tensor::canonicalize() {
     throw std::runtime_error(
         "Tensor::canonicalize cannot canonicalize a nonsymmetric tensor");
   }
-  scalar_t sign = 1;
-  auto upper_indices = this->upper();
-  sign *= canonicalize_indices(upper_indices, false);
-  auto lower_indices = this->lower();
-  sign *= canonicalize_indices(lower_indices, false);
-  this->set_upper(upper_indices);
-  this->set_lower(lower_indices);
-  return (symmetry_ == SymmetryType::Antisymmetric) ? sign : scalar_t(1);
+  const int sign = sort_indices(upper_) * sort_indices(lower_);
+  return (symmetry_ == SymmetryType::Antisymmetric) ? scalar_t(sign)
+                                                    : scalar_t(1);
 }
 
 std::string Tensor::str() const {
@@ -134,8 +146,8 @@ std::string Tensor::str_age() const {
     // int n_act = std::count_if(indices.begin(),
     //               indices.end(),
     //               [](Index i) { return i.space() == static_cast<int>(SpaceType::General); });
-    for (int i = 0; i < n_occ; i++) label.push_back(orbital_subspaces->indices(static_cast<int>(SpaceType::Occupied))[i].c_str()[0]);
-    for (int i = 0; i < n_vir; i++) label.push_back(orbital_subspaces->indices(static_cast<int>(SpaceType::Unoccupied))[i].c_str()[0]);
+    for (int i = 0; i < n_occ; i++) label.push_back(get_osi()->indices(static_cast<int>(SpaceType::Occupied))[i].c_str()[0]);
+    for (int i = 0; i < n_vir; i++) label.push_back(get_osi()->indices(static_cast<int>(SpaceType::Unoccupied))[i].c_str()[0]);
   }
   
   for (const auto& idx : indices) indices_str.push_back(idx.str_age());
@@ -155,13 +167,13 @@ std::string Tensor::latex() const {
 
   // read the label. Here we try to separate the name (e.g., lambda) from the
   // subscript (eg. 1). For greek letters we omit the subscript.
-  std::smatch sm;
-  auto m = std::regex_match(label_, sm, std::regex("([a-zA-Z]+)[_]?(\\d+)?"));
-  if (not m) {
+  string_scanner in(label_);
+  std::string symbol(in.read_while(string_scanner::is_alpha));
+  in.accept('_');
+  std::string raw_subscript(in.read_digits());
+  if (symbol.empty() or not in.done()) {
     throw std::runtime_error("\nCould not parse tensor label " + label_);
   }
-  std::string symbol = sm[1];
-  std::string raw_subscript = sm[2];
   std::vector<std::string> greek{"alpha",  "beta", "gamma", "delta", "epsilon",
                                  "zeta",   "eta",  "theta", "iota",  "kappa",
                                  "lambda", "mu",   "nu",    "xi",    "omicron",
@@ -211,19 +223,34 @@ Tensor make_tensor(const std::string &label,
   return Tensor(label, lower_indices, upper_indices, symmetry);
 }
 
+Tensor parse_tensor(string_scanner &in, SymmetryType symmetry) {
+  auto error = [&]() {
+    return std::runtime_error("\nCould not convert the string " +
+                              std::string(in.input()) + " to a Tensor object");
+  };
+  const std::string_view label = in.read_while(string_scanner::is_alnum);
+  if (label.empty() or not in.accept('^') or not in.accept('{')) {
+    throw error();
+  }
+  auto upper = parse_indices(in);
+  if (not in.accept('}') or not in.accept('_') or not in.accept('{')) {
+    throw error();
+  }
+  auto lower = parse_indices(in);
+  if (not in.accept('}')) {
+    throw error();
+  }
+  return Tensor(std::string(label), lower, upper, symmetry);
+}
+
 Tensor make_tensor_from_str(const std::string &s, SymmetryType symmetry) {
-  std::smatch sm;
-  auto const tensor_re =
-      std::regex("([a-zA-Z0-9]+)\\^\\{([\\w,\\s]*)\\}_\\{([\\w,\\s]*)\\}");
-  auto m = std::regex_match(s, sm, tensor_re);
-  if (not m) {
+  string_scanner in(s);
+  Tensor tensor = parse_tensor(in, symmetry);
+  if (not in.done()) {
     throw std::runtime_error("\nCould not convert the string " + s +
                              " to a Tensor object");
   }
-  std::string label = sm[1];
-  auto upper = make_indices_from_str(sm[2]);
-  auto lower = make_indices_from_str(sm[3]);
-  return Tensor(label, lower, upper, symmetry);
+  return tensor;
 }
 
 // std::string Tensor::compile() {
@@ -100,9 +100,12 @@ Tensor make_tensor(const std::string &label,
                    SymmetryType symmetry);
 
 /// Helper function to make a Tensor object from a string
-/// Accepts inputs of the form "t_{o0}^{v_0}"
+/// Accepts inputs of the form "t^{v0}_{o0}"
 Tensor make_tensor_from_str(const std::string &index, SymmetryType symmetry);
 
+/// Read a tensor (e.g., "t^{v0}_{o0}") from a scanner
+Tensor parse_tensor(string_scanner &in, SymmetryType symmetry);
+
 /// Print to an output stream
 std::ostream &operator<<(std::ostream &os, const Tensor &tensor);
 
@@ -0,0 +1,122 @@
+#include <stdexcept>
+
+#include "serialization.h"
+
+#include "term_sink.h"
+
+void TermSink::add_expression(const Expression &expr) {
+  for (const auto &[term, c] : expr.compact_terms()) {
+    add(term, c);
+  }
+  flush();
+}
+
+EquationSink::EquationSink(const std::string &label) : label_(label) {}
+
+void EquationSink::add(const CompactTerm &term, scalar_t coefficient) {
+  group_.add(term, coefficient);
+}
+
+void EquationSink::flush() {
+  for (const auto &[block, eqs] : group_.to_manybody_equation(label_)) {
+    equations(block, eqs);
+  }
+  group_ = Expression();
+}
+
+output_file::output_file(const std::string &path)
+    : path_(path), buffer_(buffer_size),
+      file_(std::make_unique<std::ofstream>()), out_(file_.get()) {
+  // the buffer must be set before the file is opened
+  file_->rdbuf()->pubsetbuf(buffer_.data(), buffer_.size());
+  file_->open(path, std::ios::binary);
+  if (not *file_) {
+    throw std::runtime_error("cannot open the file " + path);
+  }
+}
+
+output_file::output_file(std::ostream &out) : out_(&out) {}
+
+void output_file::flush() {
+  out_->flush();
+  if (not *out_) {
+    throw std::runtime_error(
+        path_.empty() ? std::string("cannot write the output")
+                      : "cannot write the file " + path_);
+  }
+}
+
+void TextWriter::add(const CompactTerm &term, scalar_t coefficient) {
+  out_.stream() << expression_term_str(term, coefficient) << '\n';
+}
+
+void LatexWriter::add(const CompactTerm &term, scalar_t coefficient) {
+  out_.stream() << coefficient.latex() << ' ' << term.term().latex()
+                << " \\\\\n";
+}
+
+void EinsumWriter::flush() {
+  EquationSink::flush();
+  out_.flush();
+}
+
+void EinsumWriter::equations(const std::string &block,
+                             const std::vector<Equation> &eqs) {
+  auto &out = out_.stream();
+  out << "# " << block << " (" << eqs.size() << " terms)\n";
+  for (const auto &eq : eqs) {
+    out << eq.compile("einsum") << '\n';
+  }
+}
+
+void BinaryWriter::add(const CompactTerm &term, scalar_t coefficient) {
+  group_.add(term, coefficient);
+}
+
+void BinaryWriter::flush() {
+  if (group_.size() > 0) {
+    const std::string bytes = to_bytes(group_);
+    auto &out = out_.stream();
+    size_t n = bytes.size();
+    for (; n >= 0x80; n >>= 7) {
+      out.put(static_cast<char>((n & 0x7f) | 0x80));
+    }
+    out.put(static_cast<char>(n));
+    out << bytes;
+    group_ = Expression();
+  }
+  out_.flush();
+}
+
+Expression read_binary_stream(std::istream &in) {
+  Expression result;
+  std::string bytes;
+  for (int c; (c = in.get()) != std::char_traits<char>::eof();) {
+    // the size of the record
+    size_t n = 0;
+    for (int shift = 0;; shift += 7) {
+      if ((c == std::char_traits<char>::eof()) or (shift > 63)) {
+        throw std::runtime_error("invalid binary stream");
+      }
+      n |= static_cast<size_t>(c & 0x7f) << shift;
+      if ((c & 0x80) == 0) {
+        break;
+      }
+      c = in.get();
+    }
+    bytes.resize(n);
+    if (not in.read(&bytes[0], n)) {
+      throw std::runtime_error("the binary stream is truncated");
+    }
+    result += expression_from_bytes(bytes);
+  }
+  return result;
+}
+
+Expression read_binary_stream(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  if (not in) {
+    throw std::runtime_error("cannot open the file " + path);
+  }
+  return read_binary_stream(in);
+}
@@ -0,0 +1,152 @@
+#ifndef _wicked_term_sink_h_
+#define _wicked_term_sink_h_
+
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "expression.h"
+
+/**
+ * @brief A receiver of the terms of an expression
+ *
+ * A sink is used to stream the result of a contraction (see
+ * WickTheorem::contract) instead of storing it. The terms are received in
+ * groups: the terms received before a call to flush() are never combined with
+ * those received after it, so a sink may process each group and discard it.
+ * Each term is received once, with its final coefficient.
+ */
+class TermSink {
+public:
+  virtual ~TermSink() = default;
+
+  /// Receive a term and its coefficient
+  virtual void add(const CompactTerm &term, scalar_t coefficient) = 0;
+
+  /// Called at the end of a group of terms
+  virtual void flush() {}
+
+  /// Send all the terms of an expression (as one group)
+  void add_expression(const Expression &expr);
+};
+
+/// A sink that converts each group of terms into many-body equations (see
+/// Expression::to_manybody_equation) and passes them to equations()
+class EquationSink : public TermSink {
+public:
+  /// label is the label of the tensor on the left-hand side
+  explicit EquationSink(const std::string &label);
+
+  void add(const CompactTerm &term, scalar_t coefficient) override;
+
+  void flush() override;
+
+  /// Receive the equations of a block (e.g., "oo|vv") of a group. A block
+  /// may be received once for each group
+  virtual void equations(const std::string &block,
+                         const std::vector<Equation> &eqs) = 0;
+
+private:
+  /// The label of the tensor on the left-hand side
+  std::string label_;
+  /// The terms of the current group
+  Expression group_;
+};
+
+/// An output stream that is either a file (written through a large buffer) or
+/// a stream owned by the caller
+class output_file {
+public:
+  /// Open the file path (throws if it cannot be opened)
+  explicit output_file(const std::string &path);
+
+  /// Write to a stream owned by the caller
+  explicit output_file(std::ostream &out);
+
+  /// Return the output stream
+  std::ostream &stream() { return *out_; }
+
+  /// Flush the stream and throw if a write failed
+  void flush();
+
+private:
+  /// The size of the buffer used to write files (bytes)
+  static constexpr size_t buffer_size = 1 << 20;
+
+  std::string path_;
+  std::vector<char> buffer_;
+  std::unique_ptr<std::ofstream> file_;
+  std::ostream *out_;
+};
+
+/// Writes the terms as text, one per line ("COEFFICIENT TERM", the format of
+/// Expression::str() with all the coefficients signed)
+class TextWriter : public TermSink {
+public:
+  explicit TextWriter(const std::string &path) : out_(path) {}
+  explicit TextWriter(std::ostream &out) : out_(out) {}
+
+  void add(const CompactTerm &term, scalar_t coefficient) override;
+  void flush() override { out_.flush(); }
+
+private:
+  output_file out_;
+};
+
+/// Writes the terms in LaTeX format, one per line (the format of
+/// Expression::latex())
+class LatexWriter : public TermSink {
+public:
+  explicit LatexWriter(const std::string &path) : out_(path) {}
+  explicit LatexWriter(std::ostream &out) : out_(out) {}
+
+  void add(const CompactTerm &term, scalar_t coefficient) override;
+  void flush() override { out_.flush(); }
+
+private:
+  output_file out_;
+};
+
+/// Writes the many-body equations as NumPy einsum code (see
+/// Equation::compile). Each block is preceded by a comment
+class EinsumWriter : public EquationSink {
+public:
+  EinsumWriter(const std::string &path, const std::string &label)
+      : EquationSink(label), out_(path) {}
+  EinsumWriter(std::ostream &out, const std::string &label)
+      : EquationSink(label), out_(out) {}
+
+  void flush() override;
+  void equations(const std::string &block,
+                 const std::vector<Equation> &eqs) override;
+
+private:
+  output_file out_;
+};
+
+/// Writes the terms in the binary format of to_bytes(Expression). Each group
+/// is written as a record (its size as a varint followed by the serialized
+/// expression). The file is read with read_binary_stream()
+class BinaryWriter : public TermSink {
+public:
+  explicit BinaryWriter(const std::string &path) : out_(path) {}
+  explicit BinaryWriter(std::ostream &out) : out_(out) {}
+
+  void add(const CompactTerm &term, scalar_t coefficient) override;
+  void flush() override;
+
+private:
+  output_file out_;
+  /// The terms of the current group
+  Expression group_;
+};
+
+/// Read the sum of the records written by a BinaryWriter
+Expression read_binary_stream(std::istream &in);
+
+/// Read the sum of the records written by a BinaryWriter to the file path
+Expression read_binary_stream(const std::string &path);
+
+#endif // _wicked_term_sink_h_
@@ -19,8 +19,11 @@ void export_Expression(py::module &m);
 void export_Equation(py::module &m);
 void export_Operator(py::module &m);
 void export_OperatorExpression(py::module &m);
+void export_TermSink(py::module &m);
 void export_WickTheorem(py::module &m);
 void export_rational(py::module &m);
+void export_parallel(py::module &m);
+void export_profile(py::module &m);
 
 PYBIND11_MODULE(_wicked, m) {
   m.doc() = "Wicked python interface";
@@ -36,5 +39,8 @@ PYBIND11_MODULE(_wicked, m) {
   export_Equation(m);
   export_Operator(m);
   export_OperatorExpression(m);
+  export_TermSink(m);
   export_WickTheorem(m);
+  export_parallel(m);
+  export_profile(m);
 }
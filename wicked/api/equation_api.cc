@@ -3,6 +3,7 @@
 
 #include "../wicked/algebra/equation.h"
 #include "../wicked/algebra/expression.h" // for rhs_expression
+#include "../wicked/algebra/serialization.h"
 
 namespace py = pybind11;
 using namespace pybind11::literals;
@@ -18,5 +19,16 @@ void export_Equation(py::module &m) {
       .def("__str__", &Equation::str)
       .def("age", &Equation::str_age)
       .def("latex", &Equation::latex)
-      .def("compile", &Equation::compile);
+      .def("compile", &Equation::compile)
+      .def(
+          "to_bytes",
+          [](const Equation &x) { return py::bytes(to_bytes(x)); },
+          "Return a compact binary representation")
+      .def_static(
+          "from_bytes",
+          [](const py::bytes &b) { return equation_from_bytes(b); },
+          "b"_a, "Create an object from its binary representation")
+      .def(py::pickle(
+          [](const Equation &x) { return py::bytes(to_bytes(x)); },
+          [](const py::bytes &b) { return equation_from_bytes(b); }));
 }
\ No newline at end of file
@@ -1,11 +1,54 @@
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include "../wicked/algebra/compact_term.h"
 #include "../wicked/algebra/expression.h"
+#include "../wicked/algebra/expression_columns.h"
+#include "../wicked/algebra/serialization.h"
 
 namespace py = pybind11;
 using namespace pybind11::literals;
 
+namespace {
+/// Return a NumPy array that takes ownership of the data of a vector (the
+/// data is not copied)
+template <class T> py::array_t<T> to_array(std::vector<T> &&v) {
+  auto *data = new std::vector<T>(std::move(v));
+  py::capsule owner(
+      data, [](void *p) { delete static_cast<std::vector<T> *>(p); });
+  return py::array_t<T>(data->size(), data->data(), owner);
+}
+
+/// Return the columns of an expression as a dictionary of NumPy arrays
+py::dict columns_to_dict(const Expression &expr) {
+  ExpressionColumns cols;
+  {
+    py::gil_scoped_release release;
+    cols = to_columns(expr);
+  }
+  py::dict d;
+  d["numerator"] = to_array(std::move(cols.numerator));
+  d["denominator"] = to_array(std::move(cols.denominator));
+  d["coefficient"] = to_array(std::move(cols.coefficient));
+  d["normal_ordered"] = to_array(std::move(cols.normal_ordered));
+  d["ops_id"] = to_array(std::move(cols.ops_id));
+  d["tensor_offsets"] = to_array(std::move(cols.tensor_offsets));
+  d["op_offsets"] = to_array(std::move(cols.op_offsets));
+  d["tensor_id"] = to_array(std::move(cols.tensor_id));
+  d["tensor_label"] = to_array(std::move(cols.tensor_label));
+  d["tensor_nupper"] = to_array(std::move(cols.tensor_nupper));
+  d["index_offsets"] = to_array(std::move(cols.index_offsets));
+  d["index_space"] = to_array(std::move(cols.index_space));
+  d["index_pos"] = to_array(std::move(cols.index_pos));
+  d["op_creation"] = to_array(std::move(cols.op_creation));
+  d["op_space"] = to_array(std::move(cols.op_space));
+  d["op_pos"] = to_array(std::move(cols.op_pos));
+  d["labels"] = cols.labels;
+  return d;
+}
+} // namespace
+
 /// Export the Indexclass
 void export_Expression(py::module &m) {
   py::class_<Expression, std::shared_ptr<Expression>>(m, "Expression")
@@ -26,15 +69,75 @@ void export_Expression(py::module &m) {
              lhs += rhs;
              return lhs;
            })
+      .def("__sub__",
+           [](Expression lhs, const Expression &rhs) {
+             lhs -= rhs;
+             return lhs;
+           })
+      .def(
+          "__iadd__",
+          [](Expression &lhs, const Expression &rhs) -> Expression & {
+            return lhs += rhs;
+          },
+          py::is_operator())
+      .def(
+          "__isub__",
+          [](Expression &lhs, const Expression &rhs) -> Expression & {
+            return lhs -= rhs;
+          },
+          py::is_operator())
+      .def(
+          "__imul__",
+          [](Expression &lhs, scalar_t factor) -> Expression & {
+            lhs *= factor;
+            return lhs;
+          },
+          py::is_operator())
+      .def("__copy__", [](const Expression &x) { return Expression(x); })
+      .def("__deepcopy__",
+           [](const Expression &x, py::dict) { return Expression(x); })
       .def("latex", &Expression::latex, "sep"_a = " \\\\ \n")
-      .def("to_manybody_equation", &Expression::to_manybody_equation)
-      .def("to_manybody_equations", &Expression::to_manybody_equation)
-      .def("canonicalize", &Expression::canonicalize);
+      .def(
+          "to_bytes",
+          [](const Expression &x) { return py::bytes(to_bytes(x)); },
+          "Return a compact binary representation")
+      .def_static(
+          "from_bytes",
+          [](const py::bytes &b) { return expression_from_bytes(b); },
+          "b"_a, "Create an object from its binary representation")
+      .def(py::pickle(
+          [](const Expression &x) { return py::bytes(to_bytes(x)); },
+          [](const py::bytes &b) { return expression_from_bytes(b); }))
+      .def("to_columns", &columns_to_dict,
+           "Return the terms as a dictionary of NumPy arrays (see "
+           "ExpressionColumns)")
+      .def("to_manybody_equation", &Expression::to_manybody_equation,
+           py::call_guard<py::gil_scoped_release>())
+      .def("to_manybody_equations", &Expression::to_manybody_equation,
+           py::call_guard<py::gil_scoped_release>())
+      .def("canonicalize", &Expression::canonicalize,
+           py::call_guard<py::gil_scoped_release>())
+      .def("adjoint", &Expression::adjoint,
+           py::call_guard<py::gil_scoped_release>(),
+           "Return the adjoint of this expression (assuming real tensors)");
 
   m.def("operator_expr", &make_operator_expr, "label"_a, "components"_a,
         "normal_ordered"_a, "symmetry"_a = SymmetryType::Antisymmetric,
         "coefficient"_a = scalar_t(1));
 
   m.def("expression", &string_to_expr, "s"_a,
-        "symmetry"_a = SymmetryType::Antisymmetric);
+        "symmetry"_a = SymmetryType::Antisymmetric,
+        "Create an Expression from a string with one term per line");
+  m.def("parse_expressions", &parse_expressions, "strings"_a,
+        "symmetry"_a = SymmetryType::Antisymmetric,
+        py::call_guard<py::gil_scoped_release>(),
+        "Create the sum of a list of strings (see expression())");
+  m.def("parse_expression_file", &parse_expression_file, "path"_a,
+        "symmetry"_a = SymmetryType::Antisymmetric,
+        py::call_guard<py::gil_scoped_release>(),
+        "Read an Expression from a file with one term per line");
+  m.def("clear_pools", &clear_interned_pools,
+        "Release the memory of the tensors and operators shared by the terms "
+        "of all expressions. The pools only grow while expressions are "
+        "alive, so this can only be called once all of them are deleted");
 }
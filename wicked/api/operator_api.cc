@@ -41,6 +41,35 @@ void export_OperatorExpression(py::module &m) {
              rhs -= lhs;
              return rhs;
            })
+      .def(
+          "__iadd__",
+          [](OperatorExpression &lhs,
+             const OperatorExpression &rhs) -> OperatorExpression & {
+            lhs += rhs;
+            return lhs;
+          },
+          py::is_operator())
+      .def(
+          "__isub__",
+          [](OperatorExpression &lhs,
+             const OperatorExpression &rhs) -> OperatorExpression & {
+            lhs -= rhs;
+            return lhs;
+          },
+          py::is_operator())
+      .def(
+          "__imul__",
+          [](OperatorExpression &lhs, scalar_t factor) -> OperatorExpression & {
+            lhs *= factor;
+            return lhs;
+          },
+          py::is_operator())
+      .def("__copy__",
+           [](const OperatorExpression &x) { return OperatorExpression(x); })
+      .def("__deepcopy__",
+           [](const OperatorExpression &x, py::dict) {
+             return OperatorExpression(x);
+           })
       .def("__eq__",
            [](const OperatorExpression &rhs, const OperatorExpression &lhs) {
              return rhs.is_equal(lhs);
@@ -51,9 +80,33 @@ void export_OperatorExpression(py::module &m) {
            [](const OperatorExpression &lhs, const OperatorExpression &rhs) {
              return lhs * rhs;
            })
-      .def("canonicalize", &OperatorExpression::canonicalize);
+      .def("canonicalize", &OperatorExpression::canonicalize)
+      .def(
+          "to_bytes",
+          [](const OperatorExpression &x) { return py::bytes(to_bytes(x)); },
+          "Return a compact binary representation")
+      .def_static(
+          "from_bytes",
+          [](const py::bytes &b) { return operator_expression_from_bytes(b); },
+          "b"_a, "Create an object from its binary representation")
+      .def(py::pickle(
+          [](const OperatorExpression &x) { return py::bytes(to_bytes(x)); },
+          [](const py::bytes &b) {
+            return operator_expression_from_bytes(b);
+          }));
   m.def("op", &make_diag_operator_expression,
         "Create a OperatorExpression object");
+  m.def("gen_op", &make_operator_expression, "label"_a, "rank"_a,
+        "cre_spaces"_a, "ann_spaces"_a, "diagonal"_a = true,
+        "excitation_classes"_a = std::vector<int>(),
+        "Create an operator with all the components of a given rank in the "
+        "spaces cre_spaces (creation) and ann_spaces (annihilation)");
+
+  m.def("expand_composite_spaces",
+        py::overload_cast<const OperatorExpression &>(&expand_composite_spaces),
+        "expr"_a,
+        "Replace the operators with composite spaces by their components in "
+        "the elementary spaces");
 
   m.def(
       "commutator",
@@ -77,4 +130,8 @@ void export_OperatorExpression(py::module &m) {
         "Creates the Baker-Campbell-Hausdorff "
         "expansion of exp(-B) A exp(B) truncated at "
         "a given order n");
+
+  m.def("shard_by_hash", &shard_by_hash, "expr"_a, "nshards"_a,
+        "Split an OperatorExpression into nshards OperatorExpression objects "
+        "by a hash of the products (the same in all processes)");
 }
@@ -12,15 +12,35 @@ void export_OrbitalSpaceInfo(py::module &m) {
       m, "OrbitalSpaceInfo")
       .def(py::init<>())
       .def("reset_space", &OrbitalSpaceInfo::reset)
-      .def("add_space", &OrbitalSpaceInfo::add_space)
+      .def(
+          "add_space",
+          [](OrbitalSpaceInfo &osi, char label,
+             const std::string &field_type_str,
+             const std::string &space_type_str,
+             const std::vector<std::string> &indices,
+             const std::vector<char> &elementary_spaces) {
+            osi.add_space(label, string_to_field_type(field_type_str),
+                          string_to_space_type(space_type_str), indices,
+                          elementary_spaces);
+          },
+          "label"_a, "field_type"_a, "space_type"_a, "indices"_a,
+          "elementary_spaces"_a = std::vector<char>())
+      .def("add_composite_space", &OrbitalSpaceInfo::add_composite_space,
+           "label"_a, "elementary_spaces"_a)
       .def("num_spaces", &OrbitalSpaceInfo::num_spaces)
+      .def("num_composite_spaces", &OrbitalSpaceInfo::num_composite_spaces)
       .def("label", &OrbitalSpaceInfo::label)
       .def("__str__", &OrbitalSpaceInfo::str);
 
-  m.def("osi", []() { return orbital_subspaces; });
+  m.def("osi", []() { return get_osi(); },
+        "Return the orbital spaces used by the calling thread");
+
+  m.def("set_osi", &set_osi, "osi"_a,
+        "Set the orbital spaces used by the calling thread (None = use the "
+        "default spaces shared by all threads)");
 
   m.def(
-      "reset_space", []() { orbital_subspaces->reset(); },
+      "reset_space", []() { get_osi()->reset(); },
       "Reset the orbital space");
 
   m.def(
@@ -31,8 +51,8 @@ void export_OrbitalSpaceInfo(py::module &m) {
          const std::vector<char> &elementary_spaces) {
         FieldType field_type = string_to_field_type(field_type_str);
         SpaceType space_type = string_to_space_type(space_type_str);
-        orbital_subspaces->add_space(label, field_type, space_type, indices,
-                                     elementary_spaces);
+        get_osi()->add_space(label, field_type, space_type, indices,
+                             elementary_spaces);
       },
       "label"_a, "field_type"_a, "space_type"_a, "indices"_a,
       "elementary_spaces"_a = std::vector<char>(),
@@ -40,5 +60,15 @@ void export_OrbitalSpaceInfo(py::module &m) {
       "[fermion,boson]. `space_type` can be any of "
       "[occupied,unoccupied,general]");
 
-  m.def("num_spaces", []() { return orbital_subspaces->num_spaces(); });
+  m.def(
+      "add_composite_space",
+      [](char label, const std::vector<char> &elementary_spaces) {
+        get_osi()->add_composite_space(label, elementary_spaces);
+      },
+      "label"_a, "elementary_spaces"_a,
+      "Add a composite space, the union of elementary spaces. Operators with "
+      "components in a composite space are expanded into the elementary "
+      "spaces when they are contracted");
+
+  m.def("num_spaces", []() { return get_osi()->num_spaces(); });
 }
\ No newline at end of file
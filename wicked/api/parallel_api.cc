@@ -0,0 +1,14 @@
+#include <pybind11/pybind11.h>
+
+#include "helpers/parallel.hpp"
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+void export_parallel(py::module &m) {
+  m.def("set_num_threads", &set_num_threads, "n"_a,
+        "Set the maximum number of threads used to process expressions (0 = "
+        "one per core)");
+  m.def("num_threads", &num_threads,
+        "Return the maximum number of threads used to process expressions");
+}
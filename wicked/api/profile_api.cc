@@ -0,0 +1,48 @@
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "helpers/profile.h"
+#include "helpers/trace.h"
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+void export_profile(py::module &m) {
+  py::class_<profile_data> profile_class(m, "Profile");
+  for (int i = 0; i < num_counters; i++) {
+    profile_class.def_property_readonly(
+        counter_name(static_cast<Counter>(i)),
+        [i](const profile_data &p) { return p.counters[i]; });
+  }
+  profile_class
+      .def_readonly("product_time", &profile_data::product_time,
+                    "A map product of operators -> (calls, time in seconds)")
+      .def(
+          "counters",
+          [](const profile_data &p) {
+            std::map<std::string, uint64_t> result;
+            for (int i = 0; i < num_counters; i++) {
+              result[counter_name(static_cast<Counter>(i))] = p.counters[i];
+            }
+            return result;
+          },
+          "Return a map counter name -> value")
+      .def("__repr__", &profile_data::str)
+      .def("__str__", &profile_data::str);
+
+  m.def("enable_profile", &enable_profile, "val"_a,
+        "Turn on/off the collection of performance counters");
+  m.def("profile_enabled", &profile_enabled,
+        "Return True if performance counters are collected");
+  m.def("profile", &profile,
+        "Return the performance counters summed over all threads");
+  m.def("reset_profile", &reset_profile,
+        "Reset the performance counters of all threads");
+
+  m.def("start_trace", &start_trace, "path"_a,
+        "Start recording a trace of the contractions. The trace is written to "
+        "path in the Chrome trace event format when stop_trace() is called");
+  m.def("stop_trace", &stop_trace,
+        "Stop recording and write the trace to the file passed to "
+        "start_trace()");
+}
@@ -1,5 +1,6 @@
 #include <pybind11/pybind11.h>
 
+#include "algebra/serialization.h"
 #include "diagrams/operator.h"
 #include "diagrams/operator_expression.h"
 #include "helpers/rational.h"
@@ -34,6 +35,17 @@ void export_rational(py::module &m) {
       .def("__truediv__",
            [](const rational &lhs, const rational &rhs) { return lhs / rhs; })
       .def("__repr__", &rational::repr)
+      .def(
+          "to_bytes",
+          [](const rational &x) { return py::bytes(to_bytes(x)); },
+          "Return a compact binary representation")
+      .def_static(
+          "from_bytes",
+          [](const py::bytes &b) { return rational_from_bytes(b); },
+          "b"_a, "Create an object from its binary representation")
+      .def(py::pickle(
+          [](const rational &x) { return py::bytes(to_bytes(x)); },
+          [](const py::bytes &b) { return rational_from_bytes(b); }))
       .def("str", &rational::str);
 
   m.def("make_rational", &make_rational_from_str);
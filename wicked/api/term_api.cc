@@ -1,6 +1,7 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include "../wicked/algebra/serialization.h"
 #include "../wicked/algebra/term.h"
 
 namespace py = pybind11;
@@ -20,8 +21,18 @@ void export_SymbolicTerm(py::module &m) {
       .def("add", py::overload_cast<const Tensor &>(&SymbolicTerm::add))
       .def("set", py::overload_cast<const std::vector<SQOperator> &>(
                       &SymbolicTerm::set))
-      .def("set_normal_ordered", &SymbolicTerm::set_normal_ordered);
-  ;
+      .def("set_normal_ordered", &SymbolicTerm::set_normal_ordered)
+      .def(
+          "to_bytes",
+          [](const SymbolicTerm &x) { return py::bytes(to_bytes(x)); },
+          "Return a compact binary representation")
+      .def_static(
+          "from_bytes",
+          [](const py::bytes &b) { return symbolic_term_from_bytes(b); },
+          "b"_a, "Create an object from its binary representation")
+      .def(py::pickle(
+          [](const SymbolicTerm &x) { return py::bytes(to_bytes(x)); },
+          [](const py::bytes &b) { return symbolic_term_from_bytes(b); }));
 
   py::class_<Term, std::shared_ptr<Term>>(m, "Term")
       .def(py::init<>())
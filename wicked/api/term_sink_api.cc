@@ -0,0 +1,119 @@
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "../wicked/algebra/expression.h"
+#include "../wicked/algebra/term_sink.h"
+
+namespace py = pybind11;
+using namespace pybind11::literals;
+
+namespace {
+/// A TermSink implemented in Python. add() receives a SymbolicTerm
+class PyTermSink : public TermSink {
+public:
+  using TermSink::TermSink;
+
+  void add(const CompactTerm &term, scalar_t coefficient) override {
+    py::gil_scoped_acquire gil;
+    py::function add = py::get_override(this, "add");
+    if (not add) {
+      throw std::runtime_error("TermSink.add() is not implemented");
+    }
+    add(term.term(), coefficient);
+  }
+
+  void flush() override { PYBIND11_OVERRIDE(void, TermSink, flush, ); }
+};
+
+/// An EquationSink implemented in Python. add() (which receives a
+/// SymbolicTerm) and flush() may be overridden
+class PyEquationSink : public EquationSink {
+public:
+  using EquationSink::EquationSink;
+
+  void add(const CompactTerm &term, scalar_t coefficient) override {
+    {
+      py::gil_scoped_acquire gil;
+      py::function add =
+          py::get_override(static_cast<const EquationSink *>(this), "add");
+      if (add) {
+        add(term.term(), coefficient);
+        return;
+      }
+    }
+    EquationSink::add(term, coefficient);
+  }
+
+  void flush() override { PYBIND11_OVERRIDE(void, EquationSink, flush, ); }
+
+  void equations(const std::string &block,
+                 const std::vector<Equation> &eqs) override {
+    PYBIND11_OVERRIDE_PURE(void, EquationSink, equations, block, eqs);
+  }
+};
+} // namespace
+
+/// Export the TermSink class and the writers
+void export_TermSink(py::module &m) {
+  py::class_<TermSink, PyTermSink>(m, "TermSink",
+                                   "A receiver of the terms of a contraction. "
+                                   "Subclasses implement add(term, "
+                                   "coefficient) and optionally flush()")
+      .def(py::init<>())
+      .def(
+          "add",
+          [](TermSink &sink, const SymbolicTerm &term, scalar_t coefficient) {
+            // a Python sink has no base implementation to call (dispatching
+            // to the virtual add() would call the Python add() again)
+            if (dynamic_cast<PyTermSink *>(&sink) != nullptr) {
+              PyErr_SetString(PyExc_NotImplementedError,
+                              "TermSink.add() is not implemented");
+              throw py::error_already_set();
+            }
+            sink.add(CompactTerm(term), coefficient);
+          },
+          "term"_a, "coefficient"_a, "Receive a term and its coefficient")
+      .def("flush", &TermSink::flush, "Called at the end of a group of terms")
+      .def("add_expression", &TermSink::add_expression, "expr"_a,
+           "Send all the terms of an expression (as one group)");
+
+  py::class_<EquationSink, TermSink, PyEquationSink>(
+      m, "EquationSink",
+      "A sink that converts each group of terms into many-body equations. "
+      "Subclasses implement equations(block, eqs)")
+      .def(py::init<const std::string &>(), "label"_a)
+      // call the implementations of EquationSink (not the overrides), so
+      // that subclasses can call super().add() and super().flush()
+      .def(
+          "add",
+          [](EquationSink &sink, const SymbolicTerm &term,
+             scalar_t coefficient) {
+            sink.EquationSink::add(CompactTerm(term), coefficient);
+          },
+          "term"_a, "coefficient"_a, "Receive a term and its coefficient")
+      .def(
+          "flush", [](EquationSink &sink) { sink.EquationSink::flush(); },
+          "Convert the terms received into equations")
+      .def("equations", &EquationSink::equations, "block"_a, "eqs"_a);
+
+  py::class_<TextWriter, TermSink>(m, "TextWriter",
+                                   "Write the terms to a text file")
+      .def(py::init<const std::string &>(), "path"_a);
+
+  py::class_<LatexWriter, TermSink>(m, "LatexWriter",
+                                    "Write the terms to a LaTeX file")
+      .def(py::init<const std::string &>(), "path"_a);
+
+  py::class_<EinsumWriter, EquationSink>(
+      m, "EinsumWriter", "Write the many-body equations as einsum code")
+      .def(py::init<const std::string &, const std::string &>(), "path"_a,
+           "label"_a);
+
+  py::class_<BinaryWriter, TermSink>(m, "BinaryWriter",
+                                     "Write the terms to a binary file")
+      .def(py::init<const std::string &>(), "path"_a);
+
+  m.def("read_binary_stream",
+        py::overload_cast<const std::string &>(&read_binary_stream), "path"_a,
+        "Read the sum of the terms written by a BinaryWriter");
+}
@@ -1,14 +1,37 @@
+#include <chrono>
+#include <future>
+
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include "../wicked/algebra/term_sink.h"
 #include "../wicked/diagrams/contraction.h"
 #include "../wicked/diagrams/operator.h"
 #include "../wicked/diagrams/operator_expression.h"
 #include "../wicked/diagrams/wick_theorem.h"
+#include "../wicked/helpers/thread_pool.hpp"
 
 namespace py = pybind11;
 using namespace pybind11::literals;
 
+namespace {
+/// The result of a contraction running on the thread pool
+using expression_future = std::shared_future<Expression>;
+
+/// Run wt->contract(args...) on the thread pool. The arguments are copied, so
+/// the caller may modify them while the contraction is running.
+template <class Ops>
+expression_future contract_async(std::shared_ptr<WickTheorem> wt,
+                                 scalar_t factor, const Ops &ops,
+                                 int minrank, int maxrank) {
+  return default_thread_pool()
+      .submit([wt, factor, ops, minrank, maxrank]() {
+        return wt->contract(factor, ops, minrank, maxrank);
+      })
+      .share();
+}
+} // namespace
+
 void export_WickTheorem(py::module &m) {
   py::enum_<PrintLevel>(m, "PrintLevel")
       .value("none", PrintLevel::None)
@@ -17,23 +40,142 @@ void export_WickTheorem(py::module &m) {
       .value("detailed", PrintLevel::Detailed)
       .value("all", PrintLevel::All);
 
+  py::class_<expression_future>(m, "ExpressionFuture")
+      .def("done",
+           [](const expression_future &f) {
+             return f.wait_for(std::chrono::seconds(0)) ==
+                    std::future_status::ready;
+           },
+           "Return True if the result is available")
+      .def("wait",
+           [](const expression_future &f, double timeout) {
+             if (timeout < 0) {
+               f.wait();
+               return true;
+             }
+             return f.wait_for(std::chrono::duration<double>(timeout)) ==
+                    std::future_status::ready;
+           },
+           "timeout"_a = -1.0, py::call_guard<py::gil_scoped_release>(),
+           "Wait for the result (at most timeout seconds if timeout >= 0). "
+           "Return True if the result is available")
+      .def("result", &expression_future::get,
+           py::call_guard<py::gil_scoped_release>(),
+           "Wait for the result and return it (rethrows any exception raised "
+           "by the contraction)");
+
+  py::class_<ContractionEstimate>(m, "ContractionEstimate")
+      .def_readonly("product", &ContractionEstimate::product)
+      .def_readonly("elementary_contractions",
+                    &ContractionEstimate::elementary_contractions)
+      .def_readonly("contractions", &ContractionEstimate::contractions)
+      .def_readonly("terms", &ContractionEstimate::terms,
+                    "An upper bound to the number of terms")
+      .def_readonly("operator_permutations",
+                    &ContractionEstimate::operator_permutations)
+      .def_readonly("graphs", &ContractionEstimate::graphs,
+                    "An upper bound to the number of graphs compared")
+      .def_readonly("bytes", &ContractionEstimate::bytes,
+                    "An upper bound to the peak memory used (bytes)")
+      .def("__repr__", &ContractionEstimate::str)
+      .def("__str__", &ContractionEstimate::str);
+
   py::class_<WickTheorem, std::shared_ptr<WickTheorem>>(m, "WickTheorem")
-      .def(py::init<>())
+      .def(py::init<std::shared_ptr<OrbitalSpaceInfo>>(),
+           "osi"_a = std::shared_ptr<OrbitalSpaceInfo>())
       .def("contract",
            py::overload_cast<scalar_t, const OperatorProduct &, int, int>(
-               &WickTheorem::contract))
+               &WickTheorem::contract),
+           py::call_guard<py::gil_scoped_release>())
       .def("contract",
            py::overload_cast<scalar_t, const OperatorExpression &, int, int>(
-               &WickTheorem::contract))
+               &WickTheorem::contract),
+           py::call_guard<py::gil_scoped_release>())
       .def(
           "contract",
           [](WickTheorem &wt, const OperatorExpression &expr, const int minrank,
              const int maxrank) {
             return wt.contract(scalar_t(1), expr, minrank, maxrank);
           },
+          "expr"_a, "minrank"_a, "maxrank"_a,
+          py::call_guard<py::gil_scoped_release>())
+      .def("contract",
+           py::overload_cast<scalar_t, const std::vector<OperatorExpression> &,
+                             int, int>(&WickTheorem::contract),
+           "factor"_a, "factors"_a, "minrank"_a, "maxrank"_a,
+           py::call_guard<py::gil_scoped_release>(),
+           "Contract the product of a list of operator expressions without "
+           "expanding it first")
+      .def(
+          "contract",
+          [](WickTheorem &wt, const std::vector<OperatorExpression> &factors,
+             const int minrank, const int maxrank) {
+            return wt.contract(scalar_t(1), factors, minrank, maxrank);
+          },
+          "factors"_a, "minrank"_a, "maxrank"_a,
+          py::call_guard<py::gil_scoped_release>())
+      .def("contract",
+           py::overload_cast<scalar_t, const OperatorExpression &, int, int,
+                             TermSink &>(&WickTheorem::contract),
+           "factor"_a, "expr"_a, "minrank"_a, "maxrank"_a, "sink"_a,
+           py::call_guard<py::gil_scoped_release>(),
+           "Contract an operator expression and pass the terms to a sink "
+           "instead of returning them")
+      .def(
+          "contract",
+          [](WickTheorem &wt, const OperatorExpression &expr, const int minrank,
+             const int maxrank, TermSink &sink) {
+            wt.contract(scalar_t(1), expr, minrank, maxrank, sink);
+          },
+          "expr"_a, "minrank"_a, "maxrank"_a, "sink"_a,
+          py::call_guard<py::gil_scoped_release>())
+      .def("contract_async", &contract_async<OperatorProduct>, "factor"_a,
+           "ops"_a, "minrank"_a, "maxrank"_a,
+           "Contract a product of operators on the thread pool and return an "
+           "ExpressionFuture")
+      .def("contract_async", &contract_async<OperatorExpression>, "factor"_a,
+           "expr"_a, "minrank"_a, "maxrank"_a,
+           "Contract an operator expression on the thread pool and return an "
+           "ExpressionFuture")
+      .def(
+          "contract_async",
+          [](std::shared_ptr<WickTheorem> wt, const OperatorExpression &expr,
+             int minrank, int maxrank) {
+            return contract_async(wt, scalar_t(1), expr, minrank, maxrank);
+          },
           "expr"_a, "minrank"_a, "maxrank"_a)
+      .def("estimate",
+           py::overload_cast<const OperatorProduct &, const int, const int>(
+               &WickTheorem::estimate),
+           "ops"_a, "minrank"_a, "maxrank"_a,
+           py::call_guard<py::gil_scoped_release>(),
+           "Predict the cost of contracting a product of operators")
+      .def("estimate",
+           py::overload_cast<const OperatorExpression &, const int,
+                             const int>(&WickTheorem::estimate),
+           "expr"_a, "minrank"_a, "maxrank"_a,
+           py::call_guard<py::gil_scoped_release>(),
+           "Predict the cost of contracting each product of operators in an "
+           "expression (a list in the order of expr.terms())")
+      .def("shard_by_cost", &WickTheorem::shard_by_cost, "expr"_a,
+           "nshards"_a, "minrank"_a, "maxrank"_a,
+           py::call_guard<py::gil_scoped_release>(),
+           "Split an OperatorExpression into nshards OperatorExpression "
+           "objects with a similar estimated number of contractions")
       .def("set_print", &WickTheorem::set_print)
       .def("set_max_cumulant", &WickTheorem::set_max_cumulant)
+      .def("use_adjoint_symmetry", &WickTheorem::use_adjoint_symmetry, "val"_a,
+           "Contract only one product of each pair of adjoint products and "
+           "obtain the other from the adjoint of its terms (assumes real "
+           "tensors)")
       .def("do_canonicalize_graph", &WickTheorem::do_canonicalize_graph)
-      .def("timers", &WickTheorem::timers);
+      .def("timers", &WickTheorem::timers)
+      .def("memory", &WickTheorem::memory)
+      .def("set_memory_limit", &WickTheorem::set_memory_limit, "bytes"_a)
+      .def("set_checkpoint", &WickTheorem::set_checkpoint, "path"_a,
+           "interval"_a = 60.0, "resume"_a = true,
+           "Save the progress of the contraction of an OperatorExpression to "
+           "a file at most every interval seconds (an empty path turns off "
+           "checkpointing). If resume is True, a contraction restarts from "
+           "an existing file");
 }
\ No newline at end of file
@@ -1,3 +1,5 @@
+#include <functional>
+
 #include "helpers/combinatorics.h"
 #include "helpers/helpers.h"
 #include "helpers/orbital_space.h"
@@ -13,30 +15,45 @@ Operator::Operator(const std::string &label, const std::vector<int> &cre,
 Operator::Operator(const std::string &label, const GraphMatrix &graph_matrix)
     : label_(label), graph_matrix_(graph_matrix) {}
 
+Operator::Operator(const std::string &label, const GraphMatrix &graph_matrix,
+                   const GraphMatrix &composite)
+    : label_(label), graph_matrix_(graph_matrix), composite_(composite) {}
+
 const std::string &Operator::label() const { return label_; }
 
 GraphMatrix Operator::graph_matrix() const { return graph_matrix_; }
 
 scalar_t Operator::factor() const {
   scalar_t result = 1;
-  for (int s = 0; s < orbital_subspaces->num_spaces(); ++s) {
+  for (int s = 0; s < get_osi()->num_spaces(); ++s) {
     result /= static_cast<scalar_t>(factorial(cre(s)));
   }
-  for (int s = 0; s < orbital_subspaces->num_spaces(); ++s) {
+  for (int s = 0; s < get_osi()->num_spaces(); ++s) {
     result /= static_cast<scalar_t>(factorial(ann(s)));
   }
+  for (int s = 0; s < get_osi()->num_composite_spaces(); ++s) {
+    result /= static_cast<scalar_t>(factorial(composite_.cre(s)));
+    result /= static_cast<scalar_t>(factorial(composite_.ann(s)));
+  }
   return result;
 }
 
 Operator Operator::adjoint() const {
-  return Operator(label(), graph_matrix().adjoint());
+  GraphMatrix composite;
+  for (int s = 0; s < get_osi()->num_composite_spaces(); ++s) {
+    composite.set_cre(s, composite_.ann(s));
+    composite.set_ann(s, composite_.cre(s));
+  }
+  return Operator(label(), graph_matrix().adjoint(), composite);
 }
 
 int Operator::cre(int space) const { return graph_matrix_.cre(space); }
 
 int Operator::ann(int space) const { return graph_matrix_.ann(space); }
 
-int Operator::num_ops() const { return graph_matrix_.num_ops(); }
+int Operator::num_ops() const {
+  return graph_matrix_.num_ops() + composite_.num_ops();
+}
 
 bool Operator::operator<(Operator const &other) const {
   // Compare the labels
@@ -45,15 +62,19 @@ bool Operator::operator<(Operator const &other) const {
   if (label_ > other.label_)
     return false;
   // Compare the graph matrices
-  return graph_matrix_ < other.graph_matrix_;
+  if (graph_matrix_ != other.graph_matrix_)
+    return graph_matrix_ < other.graph_matrix_;
+  return composite_ < other.composite_;
 }
 
 bool Operator::operator==(Operator const &other) const {
-  return ((label_ == other.label_) and (graph_matrix_ == other.graph_matrix_));
+  return ((label_ == other.label_) and
+          (graph_matrix_ == other.graph_matrix_) and
+          (composite_ == other.composite_));
 }
 
 bool Operator::operator!=(Operator const &other) const {
-  return ((label_ != other.label_) or (graph_matrix_ != other.graph_matrix_));
+  return not(*this == other);
 }
 
 std::string Operator::str() const {
@@ -63,16 +84,28 @@ std::string Operator::str() const {
   }
   s.push_back(label_);
   s.push_back("{");
-  for (int i = 0; i < orbital_subspaces->num_spaces(); ++i) {
+  for (int i = 0; i < get_osi()->num_spaces(); ++i) {
     for (int j = 0; j < cre(i); j++) {
-      std::string op_s(1, orbital_subspaces->label(i));
+      std::string op_s(1, get_osi()->label(i));
       s.push_back(op_s + "+");
     }
   }
+  // the operators in composite spaces are listed after (creation) and before
+  // (annihilation) those in elementary spaces
+  for (int i = 0; i < get_osi()->num_composite_spaces(); ++i) {
+    for (int j = 0; j < composite_.cre(i); j++) {
+      s.push_back(std::string(1, get_osi()->composite_label(i)) + "+");
+    }
+  }
+  for (int i = get_osi()->num_composite_spaces() - 1; i >= 0; --i) {
+    for (int j = 0; j < composite_.ann(i); j++) {
+      s.push_back(std::string(1, get_osi()->composite_label(i)));
+    }
+  }
 
-  for (int i = orbital_subspaces->num_spaces() - 1; i >= 0; --i) {
+  for (int i = get_osi()->num_spaces() - 1; i >= 0; --i) {
     for (int j = 0; j < ann(i); j++)
-      s.push_back(std::string(1, orbital_subspaces->label(i)));
+      s.push_back(std::string(1, get_osi()->label(i)));
   }
 
   s.push_back("}");
@@ -85,10 +118,31 @@ std::ostream &operator<<(std::ostream &os, const Operator &op) {
   return os;
 }
 
+namespace {
+/// Return the number of operators that may belong to each elementary space
+/// (an operator in a composite space counts in each of its elements)
+GraphMatrix elementary_reach(const Operator &op) {
+  GraphMatrix result = op.graph_matrix();
+  if (op.is_composite()) {
+    const auto &composite = op.composite_graph_matrix();
+    for (int c = 0; c < get_osi()->num_composite_spaces(); c++) {
+      for (int s : get_osi()->composite_elements(c)) {
+        result.set_cre(s, result.cre(s) + composite.cre(c));
+        result.set_ann(s, result.ann(s) + composite.ann(c));
+      }
+    }
+  }
+  return result;
+}
+} // namespace
+
 bool do_operators_commute(const Operator &a, const Operator &b) {
+  const GraphMatrix a_reach = elementary_reach(a);
+  const GraphMatrix b_reach = elementary_reach(b);
   int noncommuting = 0;
-  for (int s = 0; s < orbital_subspaces->num_spaces(); s++) {
-    noncommuting += a.ann(s) * b.cre(s) + a.cre(s) * b.ann(s);
+  for (int s = 0; s < get_osi()->num_spaces(); s++) {
+    noncommuting += a_reach.ann(s) * b_reach.cre(s) +
+                    a_reach.cre(s) * b_reach.ann(s);
   }
   return noncommuting == 0;
 }
@@ -105,14 +159,14 @@ Operator make_diag_operator(const std::string &label,
                             const std::vector<char> &cre_labels,
                             const std::vector<char> &ann_labels) {
   // count the number of creation and annihilation operators in each space
-  std::vector<int> cre(orbital_subspaces->num_spaces());
-  std::vector<int> ann(orbital_subspaces->num_spaces());
+  std::vector<int> cre(get_osi()->num_spaces());
+  std::vector<int> ann(get_osi()->num_spaces());
   for (const auto &l : cre_labels) {
-    int space = orbital_subspaces->label_to_space(l);
+    int space = get_osi()->label_to_space(l);
     cre[space] += 1;
   }
   for (const auto &l : ann_labels) {
-    int space = orbital_subspaces->label_to_space(l);
+    int space = get_osi()->label_to_space(l);
     ann[space] += 1;
   }
 
@@ -126,3 +180,67 @@ int sum_num_ops(const std::vector<Operator> &ops) {
   }
   return r;
 }
+
+std::vector<std::vector<int>> space_multisets(const std::vector<int> &spaces,
+                                              int n) {
+  std::vector<std::vector<int>> result;
+  std::vector<int> counts(get_osi()->num_spaces());
+  // distribute the operators over the spaces, from the first one to the last
+  std::function<void(size_t, int)> distribute = [&](size_t k, int left) {
+    if (k + 1 == spaces.size()) {
+      counts[spaces[k]] = left;
+      result.push_back(counts);
+      return;
+    }
+    for (int m = left; m >= 0; m--) {
+      counts[spaces[k]] = m;
+      distribute(k + 1, left - m);
+    }
+    counts[spaces[k]] = 0;
+  };
+  if (not spaces.empty()) {
+    distribute(0, n);
+  } else if (n == 0) {
+    result.push_back(counts);
+  }
+  return result;
+}
+
+std::vector<Operator> expand_composite_spaces(const Operator &op) {
+  if (not op.is_composite()) {
+    return {op};
+  }
+  // distribute the creation and annihilation operators of each composite space
+  // among its elements
+  std::vector<GraphMatrix> blocks{op.graph_matrix()};
+  const auto &composite = op.composite_graph_matrix();
+  for (int c = 0; c < get_osi()->num_composite_spaces(); c++) {
+    const auto &elements = get_osi()->composite_elements(c);
+    for (bool creation : {true, false}) {
+      const int n = creation ? composite.cre(c) : composite.ann(c);
+      if (n == 0) {
+        continue;
+      }
+      std::vector<GraphMatrix> expanded;
+      for (const auto &block : blocks) {
+        for (const auto &counts : space_multisets(elements, n)) {
+          GraphMatrix gm = block;
+          for (int s : elements) {
+            if (creation) {
+              gm.set_cre(s, gm.cre(s) + counts[s]);
+            } else {
+              gm.set_ann(s, gm.ann(s) + counts[s]);
+            }
+          }
+          expanded.push_back(gm);
+        }
+      }
+      blocks = std::move(expanded);
+    }
+  }
+  std::vector<Operator> result;
+  for (const auto &block : blocks) {
+    result.emplace_back(op.label(), block);
+  }
+  return result;
+}
@@ -20,12 +20,24 @@ public:
 
   Operator(const std::string &label, const GraphMatrix &graph_matrix);
 
+  /// Constructor for an operator with components in composite spaces
+  /// @param composite: the number of creation/annihilation operators in each
+  /// composite space
+  Operator(const std::string &label, const GraphMatrix &graph_matrix,
+           const GraphMatrix &composite);
+
   /// Return the label of the operator
   const std::string &label() const;
 
   /// The graph matrix object
   GraphMatrix graph_matrix() const;
 
+  /// The number of creation/annihilation operators in each composite space
+  const GraphMatrix &composite_graph_matrix() const { return composite_; }
+
+  /// Does this operator have components in composite spaces?
+  bool is_composite() const { return composite_.num_ops() > 0; }
+
   /// One over the number of permutations of equivalent operators
   scalar_t factor() const;
 
@@ -38,7 +50,7 @@ public:
   int ann(int space) const;
 
   /// Return the number of creation + annilation operators represented by this
-  /// graph_matrix
+  /// graph_matrix (including those in composite spaces)
   int num_ops() const;
 
   /// Comparison operator used for sorting
@@ -59,6 +71,9 @@ private:
 
   /// The number of creation/annihilation operators in each space
   GraphMatrix graph_matrix_;
+
+  /// The number of creation/annihilation operators in each composite space
+  GraphMatrix composite_;
 };
 
 /// Check if two operators commute
@@ -76,4 +91,13 @@ Operator make_diag_operator(const std::string &label,
 /// Return the particle rank of a vector of operators
 int sum_num_ops(const std::vector<Operator> &ops);
 
+/// Return the number of operators in each space for all the ways of
+/// distributing n operators among spaces (a list of distinct space indices)
+std::vector<std::vector<int>> space_multisets(const std::vector<int> &spaces,
+                                              int n);
+
+/// Return the components of an operator in the elementary spaces (an operator
+/// with no components in composite spaces is returned as is)
+std::vector<Operator> expand_composite_spaces(const Operator &op);
+
 #endif // _wicked_diag_operator_h_
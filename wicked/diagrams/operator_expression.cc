@@ -1,5 +1,11 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "algebra/serialization.h"
+#include "helpers/byte_stream.h"
 #include "helpers/helpers.h"
 #include "helpers/orbital_space.h"
+#include "helpers/string_scanner.h"
 
 #include "operator.h"
 #include "operator_expression.h"
@@ -22,17 +28,17 @@ void OperatorExpression::add2(const OperatorExpression &expr, scalar_t factor) {
 
 void OperatorExpression::canonicalize() {
   opexpr_t canonical;
-  for (auto [prod, scalar] : terms_) {
+  for (auto [prod, scalar] : const_terms()) {
     auto newprod = prod;
     const auto sign = newprod.canonicalize();
     add_to_map(canonical, newprod, sign * scalar);
   }
-  terms_ = canonical;
+  set_terms(std::move(canonical));
 }
 
 std::string OperatorExpression::str() const {
   std::vector<std::string> str_vec;
-  for (auto &vec_dop_factor : terms_) {
+  for (auto &vec_dop_factor : const_terms()) {
     std::string s;
     s += vec_dop_factor.second.str(true);
     for (auto &dop : vec_dop_factor.first) {
@@ -71,19 +77,83 @@ make_diag_operator_expression(const std::string &label,
                               const std::vector<std::string> &components) {
   OperatorExpression result;
   for (const std::string &s : components) {
-    auto s_vec = findall(s, "([a-zA-Z][+^]?)");
-    std::vector<int> cre(orbital_subspaces->num_spaces());
-    std::vector<int> ann(orbital_subspaces->num_spaces());
-
-    for (auto const &el : s_vec) {
-      int space = orbital_subspaces->label_to_space(el[0]);
-      if (el.size() > 1) {
-        cre[space] += 1;
+    GraphMatrix elementary;
+    GraphMatrix composite;
+
+    // read the space labels (e.g., "v+ o"). A label followed by + or ^ is a
+    // creation operator; any other character is a separator. Operators in
+    // composite spaces are kept as such and expanded only when contracted
+    string_scanner in(s);
+    while (not in.done()) {
+      const char c = in.get();
+      if (not string_scanner::is_alpha(c)) {
+        continue;
+      }
+      const bool is_composite = get_osi()->is_composite_space(c);
+      GraphMatrix &gm = is_composite ? composite : elementary;
+      const int space = is_composite ? get_osi()->label_to_composite_space(c)
+                                     : get_osi()->label_to_space(c);
+      if (in.accept('+') or in.accept('^')) {
+        gm.set_cre(space, gm.cre(space) + 1);
       } else {
-        ann[space] += 1;
+        gm.set_ann(space, gm.ann(space) + 1);
+      }
+    }
+    result.add({Operator(label, elementary, composite)});
+  }
+  return result;
+}
+
+namespace {
+/// Return the sorted list of the spaces with labels in a string
+std::vector<int> spaces_from_labels(const std::string &labels) {
+  std::vector<int> spaces;
+  for (char l : labels) {
+    spaces.push_back(get_osi()->label_to_space(l));
+  }
+  std::sort(spaces.begin(), spaces.end());
+  spaces.erase(std::unique(spaces.begin(), spaces.end()), spaces.end());
+  return spaces;
+}
+} // namespace
+
+int excitation_class(const std::vector<int> &cre, const std::vector<int> &ann) {
+  int result = 0;
+  for (int s = 0; s < get_osi()->num_spaces(); s++) {
+    const SpaceType type = get_osi()->space_type(s);
+    if (type == SpaceType::Occupied) {
+      result += ann[s] - cre[s];
+    } else if (type == SpaceType::Unoccupied) {
+      result += cre[s] - ann[s];
+    }
+  }
+  return result;
+}
+
+OperatorExpression
+make_operator_expression(const std::string &label, int rank,
+                         const std::string &cre_spaces,
+                         const std::string &ann_spaces, bool diagonal,
+                         const std::vector<int> &excitation_classes) {
+  if (rank < 0) {
+    throw std::runtime_error("\nmake_operator_expression: negative rank " +
+                             std::to_string(rank));
+  }
+  const auto cre = space_multisets(spaces_from_labels(cre_spaces), rank);
+  const auto ann = space_multisets(spaces_from_labels(ann_spaces), rank);
+  OperatorExpression result;
+  for (const auto &c : cre) {
+    for (const auto &a : ann) {
+      if ((not diagonal) and (c == a)) {
+        continue;
       }
+      if ((not excitation_classes.empty()) and
+          (std::find(excitation_classes.begin(), excitation_classes.end(),
+                     excitation_class(c, a)) == excitation_classes.end())) {
+        continue;
+      }
+      result.add({Operator(label, c, a)});
     }
-    result.add({Operator(label, cre, ann)});
   }
   return result;
 }
@@ -120,3 +190,105 @@ OperatorExpression bch_series(const OperatorExpression &A,
 
   return result;
 }
+
+std::vector<OperatorExpression> shard_by_hash(const OperatorExpression &expr,
+                                              int nshards) {
+  if (nshards < 1) {
+    throw std::runtime_error("shard_by_hash() - the number of shards must be "
+                             "positive");
+  }
+  std::vector<OperatorExpression> shards(nshards);
+  for (const auto &[prod, factor] : expr.terms()) {
+    std::string s;
+    for (const auto &op : prod) {
+      s += op.str() + ' ';
+    }
+    shards[hash_string(s) % nshards].add(prod, factor);
+  }
+  return shards;
+}
+
+OperatorExpression expand_composite_spaces(const OperatorExpression &expr) {
+  OperatorExpression result;
+  for (const auto &[prod, factor] : expr.terms()) {
+    std::vector<std::vector<Operator>> products{{}};
+    for (const auto &op : prod) {
+      const auto blocks = expand_composite_spaces(op);
+      std::vector<std::vector<Operator>> expanded;
+      for (const auto &ops : products) {
+        for (const auto &block : blocks) {
+          expanded.push_back(ops);
+          expanded.back().push_back(block);
+        }
+      }
+      products = std::move(expanded);
+    }
+    for (const auto &ops : products) {
+      result.add(OperatorProduct(ops), factor);
+    }
+  }
+  return result;
+}
+
+namespace {
+// the type tag of a serialized OperatorExpression
+constexpr char operator_expression_type = 'o';
+} // namespace
+
+std::string to_bytes(const OperatorExpression &expr) {
+  // each operator is stored as its label followed by the number of creation
+  // and annihilation operators in each space
+  for (const auto &[prod, factor] : expr.terms()) {
+    for (const auto &op : prod) {
+      if (op.is_composite()) {
+        throw std::runtime_error(
+            "\nto_bytes: cannot serialize the operator " + op.str() +
+            " with composite spaces. Expand the composite spaces first.");
+      }
+    }
+  }
+  byte_writer out(operator_expression_type);
+  out.varint(expr.size());
+  for (const auto &[prod, factor] : expr.terms()) {
+    write_rational(out, factor);
+    out.varint(prod.size());
+    for (const auto &op : prod) {
+      out.label(op.label());
+      for (int s = 0; s < out.num_spaces(); s++) {
+        out.varint(op.cre(s));
+        out.varint(op.ann(s));
+      }
+    }
+  }
+  return out.str();
+}
+
+OperatorExpression operator_expression_from_bytes(const std::string &bytes) {
+  byte_reader in(bytes, operator_expression_type);
+  const int nspaces = get_osi()->num_spaces();
+  OperatorExpression result;
+  const size_t nterms = in.count();
+  for (size_t n = 0; n < nterms; n++) {
+    const scalar_t factor = read_rational(in);
+    std::vector<Operator> ops;
+    const size_t nops = in.count();
+    for (size_t k = 0; k < nops; k++) {
+      const std::string label = in.label();
+      std::vector<int> cre(nspaces, 0), ann(nspaces, 0);
+      for (int s = 0; s < in.num_spaces(); s++) {
+        const int ncre = static_cast<int>(in.varint());
+        const int nann = static_cast<int>(in.varint());
+        // spaces that are not used need not be defined
+        if (ncre + nann > 0) {
+          const int space = in.map_space(s);
+          cre[space] = ncre;
+          ann[space] = nann;
+        }
+      }
+      ops.emplace_back(label, cre, ann);
+    }
+    result.add(OperatorProduct(ops), factor);
+  }
+  in.finish();
+  return result;
+}
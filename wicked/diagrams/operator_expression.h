@@ -26,7 +26,7 @@ public:
 
   OperatorExpression adjoint() const {
     OperatorExpression expr;
-    for (const auto &[e, c] : terms_) {
+    for (const auto &[e, c] : const_terms()) {
       expr.add(e.adjoint(), c);
     }
     return expr;
@@ -64,6 +64,27 @@ OperatorExpression
 make_diag_operator_expression(const std::string &label,
                               const std::vector<std::string> &components);
 
+/// Create an operator with all the components of a given rank that have
+/// creation operators in the spaces cre_spaces and annihilation operators in
+/// the spaces ann_spaces. E.g., make_operator_expression("v", 2, "ov", "ov")
+/// creates the two-body operator with all the components in the spaces o and v
+/// @param diagonal include the components with the same number of creation and
+/// annihilation operators in each space (e.g., "o+ o" and "o+ v+ v o")
+/// @param excitation_classes if not empty, include only the components whose
+/// excitation class is listed (see excitation_class())
+OperatorExpression
+make_operator_expression(const std::string &label, int rank,
+                         const std::string &cre_spaces,
+                         const std::string &ann_spaces, bool diagonal = true,
+                         const std::vector<int> &excitation_classes = {});
+
+/// Return the excitation class of an operator component: the number of
+/// quasi-particles (holes in occupied spaces and particles in unoccupied
+/// spaces) that it creates minus the number that it destroys. Operators in
+/// general spaces do not contribute. E.g., "v+ o" is 2, "o+ o" is 0, "a+ o"
+/// is 1, and "o+ v" is -2
+int excitation_class(const std::vector<int> &cre, const std::vector<int> &ann);
+
 /// Creates a new object with the commutator [A,B]
 OperatorExpression commutator(const OperatorExpression &A,
                               const OperatorExpression &B);
@@ -76,4 +97,21 @@ OperatorExpression commutator(const OperatorExpression &A,
 OperatorExpression bch_series(const OperatorExpression &A,
                               const OperatorExpression &B, int n);
 
+/// Split a sum of operators into nshards sums. Each product is assigned to a
+/// shard by a hash of its string representation, so independent processes
+/// that build the same sum agree on the assignment
+std::vector<OperatorExpression> shard_by_hash(const OperatorExpression &expr,
+                                              int nshards);
+
+/// Replace every operator with composite spaces by the sum of its components
+/// in elementary spaces (see expand_composite_spaces(const Operator &))
+OperatorExpression expand_composite_spaces(const OperatorExpression &expr);
+
+/// Return the binary representation of a sum of operators (see
+/// algebra/serialization.h). Throws if an operator has composite spaces
+std::string to_bytes(const OperatorExpression &expr);
+
+/// Create a sum of operators from its binary representation
+OperatorExpression operator_expression_from_bytes(const std::string &bytes);
+
 #endif // _wicked_diag_operator_set_h_
@@ -1,10 +1,21 @@
+#include <algorithm>
+#include <cstdio>
 #include <iostream>
+#include <set>
+
+#include "fmt/format.h"
 
 #include "contraction.h"
+#include "graph_matrix.h"
+#include "helpers/helpers.h"
+#include "helpers/profile.h"
 #include "helpers/timer.hpp"
+#include "helpers/trace.h"
 #include "operator.h"
 #include "operator_expression.h"
 
+#include "../algebra/term_sink.h"
+
 #include "wick_theorem.h"
 
 #define PRINT(detail, code)                                                    \
@@ -14,7 +25,8 @@
 
 using namespace std;
 
-WickTheorem::WickTheorem() {}
+WickTheorem::WickTheorem(std::shared_ptr<OrbitalSpaceInfo> osi)
+    : osi_(std::move(osi)) {}
 
 void WickTheorem::set_print(PrintLevel print) { print_ = print; }
 
@@ -24,15 +36,73 @@ void WickTheorem::do_canonicalize_graph(bool val) {
   do_canonicalize_graph_ = val;
 }
 
-const std::map<std::string, double> &WickTheorem::timers() const {
+void WickTheorem::use_adjoint_symmetry(bool val) {
+  use_adjoint_symmetry_ = val;
+}
+
+std::map<std::string, double> WickTheorem::timers() const {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
   return timers_;
 }
 
+std::map<std::string, size_t> WickTheorem::memory() const {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  return memory_;
+}
+
+void WickTheorem::set_memory_limit(size_t bytes) { memory_limit_ = bytes; }
+
+std::map<std::string, size_t> WickTheorem::contraction_data::memory() const {
+  return {{"elementary contractions", elementary_contractions_bytes},
+          {"composite contractions", contractions_bytes},
+          {"graph canonicalization", graph_bytes},
+          {"result", result_bytes},
+          {"peak", elementary_contractions_bytes + contractions_bytes +
+                       graph_bytes + result_bytes}};
+}
+
+void WickTheorem::check_memory_limit(const contraction_data &data) const {
+  const size_t limit = memory_limit_.load(std::memory_order_relaxed);
+  if (limit == 0) {
+    return;
+  }
+  const auto memory = data.memory();
+  if (memory.at("peak") <= limit) {
+    return;
+  }
+  std::string msg = "\nWickTheorem::contract() - the estimated memory use (" +
+                    std::to_string(memory.at("peak")) +
+                    " bytes) exceeds the limit (" +
+                    std::to_string(limit) + " bytes)";
+  for (const auto &[name, bytes] : memory) {
+    if (name != "peak") {
+      msg += "\n  " + name + ": " + std::to_string(bytes) + " bytes";
+    }
+  }
+  throw std::runtime_error(msg);
+}
+
 Expression WickTheorem::contract(scalar_t factor, const OperatorProduct &ops,
                                  const int minrank, const int maxrank) {
-  ncontractions_ = 0;
-  contractions_.clear();
-  elementary_contractions_.clear();
+  osi_scope scope(osi_);
+  for (const auto &op : ops) {
+    if (op.is_composite()) {
+      return contract_composite_product(factor, ops, minrank, maxrank);
+    }
+  }
+  contraction_data data;
+
+  trace_span span("contract");
+  if (span.active()) {
+    std::vector<std::string> labels, signatures;
+    for (const auto &op : ops) {
+      labels.push_back(op.label());
+      signatures.push_back(signature(op.graph_matrix()));
+    }
+    span.arg("operators", join(labels, " "));
+    span.arg("graph matrices", join(signatures, " "));
+    span.arg("rank", std::to_string(minrank) + "-" + std::to_string(maxrank));
+  }
 
   PRINT(
       PrintLevel::Summary, std::cout << "\nContracting the operators: ";
@@ -42,27 +112,233 @@ Expression WickTheorem::contract(scalar_t factor, const OperatorProduct &ops,
 
   // Step 1. Generate elementary contractions
   timer t1;
-  elementary_contractions_ = generate_elementary_contractions(ops);
-  timers_["step 1"] += t1.get();
+  trace_span span1("elementary contractions");
+  data.elementary_contractions = generate_elementary_contractions(ops);
+  data.elementary_contractions_bytes =
+      data.elementary_contractions.capacity() * sizeof(ElementaryContraction);
+  for (const auto &contr : data.elementary_contractions) {
+    data.elementary_contractions_bytes += contr.size() * sizeof(GraphMatrix);
+  }
+  check_memory_limit(data);
+  span1.arg("count", std::to_string(data.elementary_contractions.size()));
+  span1.end();
+  data.timers["step 1"] += t1.get();
+  PROFILE_COUNT(Counter::ElementaryContractions,
+                data.elementary_contractions.size());
 
   // Step 2. Generate allowed composite contractions
   timer t2;
-  generate_composite_contractions(ops, minrank, maxrank);
-  timers_["step 2"] += t2.get();
+  trace_span span2("composite contractions");
+  generate_composite_contractions(ops, minrank, maxrank, data);
+  span2.arg("count", std::to_string(data.ncontractions));
+  span2.end();
+  data.timers["step 2"] += t2.get();
+  PROFILE_COUNT(Counter::CompositeContractions, data.ncontractions);
 
   // Step 3. Process contractions
   timer t3;
-  Expression result = process_contractions(factor, ops, minrank, maxrank);
-  timers_["step 3"] += t3.get();
+  trace_span span3("process contractions");
+  Expression result =
+      process_contractions(factor, ops, minrank, maxrank, data);
+  span3.arg("terms", std::to_string(result.size()));
+  span3.end();
+  data.timers["step 3"] += t3.get();
+
+  if (profile_enabled()) {
+    // t1 was started before step 1, so it measures the whole contraction
+    std::string product;
+    for (const auto &op : ops) {
+      product += (product.empty() ? "" : " ") + op.str();
+    }
+    count_product_time(product, t1.get());
+  }
+
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  for (const auto &[name, time] : data.timers) {
+    timers_[name] += time;
+  }
+  for (const auto &[name, bytes] : data.memory()) {
+    memory_[name] = std::max(memory_[name], bytes);
+  }
   return result;
 }
 
 Expression WickTheorem::contract(scalar_t factor,
                                  const OperatorExpression &expr,
                                  const int minrank, const int maxrank) {
+  osi_scope scope(osi_);
+  trace_span span("contract expression");
+  span.arg("products", std::to_string(expr.size()));
   Expression result;
-  for (const auto &[ops, f] : expr.terms()) {
-    result += contract(factor * f, ops, minrank, maxrank);
+
+  // restore the progress saved by a previous run
+  const bool checkpoint = not checkpoint_path_.empty();
+  std::string key;
+  std::vector<std::string> completed;
+  std::set<std::string> skip;
+  if (checkpoint) {
+    // hash everything that determines the result: the arguments, the
+    // settings, and the orbital spaces
+    const std::string args =
+        fmt::format("{} {} {} {} {} {}", factor.str(), minrank, maxrank,
+                    maxcumulant_, do_canonicalize_graph_,
+                    use_adjoint_symmetry_);
+    key = fmt::format("{:016x}", hash_string(args + "\n" + get_osi()->str() +
+                                             "\n" + expr.str()));
+    if (load_checkpoint(key, completed, result)) {
+      skip.insert(completed.begin(), completed.end());
+    }
+  }
+
+  auto product_str = [](const OperatorProduct &ops) {
+    std::string product;
+    for (const auto &op : ops) {
+      product += (product.empty() ? "" : " ") + op.str();
+    }
+    return product;
+  };
+
+  // the products already contracted as the adjoint of another one
+  std::set<const OperatorProduct *> contracted_adjoints;
+
+  timer checkpoint_timer;
+  try {
+    for (const auto &[ops, f] : expr.terms()) {
+      if (contracted_adjoints.count(&ops)) {
+        continue;
+      }
+      std::string product;
+      if (checkpoint) {
+        product = product_str(ops);
+        if (skip.count(product)) {
+          continue;
+        }
+      }
+      scalar_t sign;
+      const auto *adjoint =
+          use_adjoint_symmetry_ ? find_adjoint(expr, ops, sign) : nullptr;
+      if (adjoint and checkpoint and skip.count(product_str(adjoint->first))) {
+        adjoint = nullptr;
+      }
+      Expression product_result =
+          adjoint ? contract_with_adjoint(factor * f, ops,
+                                          factor * sign * adjoint->second,
+                                          minrank, maxrank)
+                  : contract(factor * f, ops, minrank, maxrank);
+      trace_span merge_span("merge");
+      result += product_result;
+      merge_span.end();
+      if (adjoint) {
+        contracted_adjoints.insert(&adjoint->first);
+        if (checkpoint) {
+          completed.push_back(product_str(adjoint->first));
+        }
+      }
+      if (checkpoint) {
+        completed.push_back(product);
+        if (checkpoint_timer.get() >= checkpoint_interval_) {
+          save_checkpoint(key, completed, result);
+          checkpoint_timer.reset();
+        }
+      }
+    }
+  } catch (...) {
+    // save the progress made so far, but report the original error
+    if (checkpoint) {
+      try {
+        save_checkpoint(key, completed, result);
+      } catch (...) {
+      }
+    }
+    throw;
+  }
+  if (checkpoint) {
+    std::remove(checkpoint_path_.c_str());
+  }
+  return result;
+}
+
+void WickTheorem::contract(scalar_t factor, const OperatorExpression &expr,
+                           const int minrank, const int maxrank,
+                           TermSink &sink) {
+  osi_scope scope(osi_);
+  trace_span span("contract expression");
+  span.arg("products", std::to_string(expr.size()));
+
+  // A term has one tensor for each operator of the product it comes from, so
+  // only the terms of products with the same operators (in any order) can be
+  // combined. Group the products by the sorted labels of their operators
+  std::map<std::vector<std::string>,
+           std::vector<const std::pair<const OperatorProduct, scalar_t> *>>
+      groups;
+  for (const auto &term : expr.terms()) {
+    std::vector<std::string> labels;
+    for (const auto &op : term.first) {
+      labels.push_back(op.label());
+    }
+    std::sort(labels.begin(), labels.end());
+    groups[labels].push_back(&term);
+  }
+
+  // the products already contracted as the adjoint of another one (an
+  // adjoint product has the same labels, so it is in the same group)
+  std::set<const OperatorProduct *> contracted_adjoints;
+
+  for (const auto &[labels, products] : groups) {
+    Expression result;
+    for (const auto *product : products) {
+      if (contracted_adjoints.count(&product->first)) {
+        continue;
+      }
+      scalar_t sign;
+      const auto *adjoint = use_adjoint_symmetry_
+                                ? find_adjoint(expr, product->first, sign)
+                                : nullptr;
+      if (adjoint) {
+        result += contract_with_adjoint(
+            factor * product->second, product->first,
+            factor * sign * adjoint->second, minrank, maxrank);
+        contracted_adjoints.insert(&adjoint->first);
+      } else {
+        result += contract(factor * product->second, product->first, minrank,
+                           maxrank);
+      }
+    }
+    trace_span sink_span("sink");
+    sink_span.arg("terms", std::to_string(result.size()));
+    for (const auto &[term, c] : result.compact_terms()) {
+      sink.add(term, c);
+    }
+    sink.flush();
   }
+}
+
+const std::pair<const OperatorProduct, scalar_t> *
+WickTheorem::find_adjoint(const OperatorExpression &expr,
+                          const OperatorProduct &ops, scalar_t &sign) {
+  OperatorProduct adjoint = ops.adjoint();
+  sign = scalar_t(1);
+  auto search = expr.terms().find(adjoint);
+  if (search == expr.terms().end()) {
+    // the products of expr may be canonicalized
+    sign = adjoint.canonicalize();
+    search = expr.terms().find(adjoint);
+  }
+  if ((search == expr.terms().end()) or (search->first == ops)) {
+    return nullptr;
+  }
+  return &(*search);
+}
+
+Expression WickTheorem::contract_with_adjoint(scalar_t factor,
+                                              const OperatorProduct &ops,
+                                              scalar_t adjoint_factor,
+                                              const int minrank,
+                                              const int maxrank) {
+  const Expression contraction = contract(scalar_t(1), ops, minrank, maxrank);
+  trace_span span("adjoint");
+  Expression result;
+  result.add(contraction, factor);
+  result.add(contraction.adjoint(), adjoint_factor);
   return result;
 }
@@ -1,6 +1,11 @@
 #ifndef _wicked_diag_theorem_h_
 #define _wicked_diag_theorem_h_
 
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -13,17 +18,56 @@ class OperatorExpression;
 class GraphMatrix;
 class ElementaryContraction;
 class CompositeContraction;
+class TermSink;
 
 #include "../algebra/expression.h"
+#include "helpers/arena.hpp"
+#include "helpers/orbital_space.h"
 
 enum class PrintLevel { None, Basic, Summary, Detailed, All };
 
+/// The predicted cost of contracting a product of operators
+struct ContractionEstimate {
+  /// The product of operators (e.g., "v t2")
+  std::string product;
+
+  /// The number of elementary contractions
+  uint64_t elementary_contractions = 0;
+
+  /// The number of composite contractions with the requested rank
+  uint64_t contractions = 0;
+
+  /// An upper bound to the number of terms (each contraction produces at
+  /// most one term before terms are merged)
+  uint64_t terms = 0;
+
+  /// The number of operator permutations examined to canonicalize the graphs
+  uint64_t operator_permutations = 0;
+
+  /// An upper bound to the number of graphs compared to canonicalize the
+  /// contractions
+  uint64_t graphs = 0;
+
+  /// The estimated peak memory used by contract() (bytes). This is an upper
+  /// bound to the "peak" entry of WickTheorem::memory()
+  size_t bytes = 0;
+
+  /// Return a string representation
+  std::string str() const;
+};
+
 /// A class to contract a product of operators
+///
+/// contract() keeps all its intermediates in per-call storage, so a
+/// WickTheorem object may be used by several threads at once. The settings
+/// (print level, maximum cumulant, graph canonicalization) should not be
+/// changed while a contraction is running.
 class WickTheorem {
 
 public:
-  /// Constructor
-  WickTheorem();
+  /// Constructor. If osi is not null, all contractions use these orbital
+  /// spaces, otherwise they use those of the calling thread
+  WickTheorem(std::shared_ptr<OrbitalSpaceInfo> osi = nullptr);
 
   /// Contract a product of operators
   Expression contract(scalar_t factor, const OperatorProduct &ops,
@@ -33,29 +77,136 @@ public:
   Expression contract(scalar_t factor, const OperatorExpression &expr,
                       const int minrank, const int maxrank);
 
+  /// Contract the product factors[0] factors[1] ... of sums of operators. The
+  /// products of components are enumerated one factor at a time: a prefix is
+  /// built once for all the products that start with it, and it is dropped
+  /// together with all its extensions when none of them can have contractions
+  /// with a rank in [minrank, maxrank]. The remaining products are
+  /// canonicalized, so those equal up to the order of commuting operators are
+  /// contracted once. The result is that of contracting the expanded product
+  Expression contract(scalar_t factor,
+                      const std::vector<OperatorExpression> &factors,
+                      const int minrank, const int maxrank);
+
+  /// Contract a product of sums of operators and pass the terms of the result
+  /// to a sink instead of returning them. The products made of the same
+  /// operators are contracted together, and the terms of each such group are
+  /// sent to the sink before the next group is contracted, so the memory used
+  /// is that of the largest group. Checkpointing is not used
+  void contract(scalar_t factor, const OperatorExpression &expr,
+                const int minrank, const int maxrank, TermSink &sink);
+
+  /// Predict the cost of contracting a product of operators without
+  /// contracting it. The composite contractions are counted by dynamic
+  /// programming over the free graph matrices, not enumerated
+  ContractionEstimate estimate(const OperatorProduct &ops, const int minrank,
+                               const int maxrank);
+
+  /// Predict the cost of contracting each product of a sum of operators
+  std::vector<ContractionEstimate> estimate(const OperatorExpression &expr,
+                                            const int minrank,
+                                            const int maxrank);
+
+  /// Split a sum of operators into nshards sums with a similar estimated
+  /// number of contractions. The assignment depends only on expr, so
+  /// independent processes that build the same sum agree on it
+  std::vector<OperatorExpression> shard_by_cost(const OperatorExpression &expr,
+                                                int nshards, const int minrank,
+                                                const int maxrank);
+
   /// Set the amount of printing
   void set_print(PrintLevel print);
 
   /// Turn on/off graph canonicalization
   void do_canonicalize_graph(bool val);
 
+  /// Turn on/off the reuse of adjoint products. When on, contract() contracts
+  /// only one product of each pair of products of an OperatorExpression that
+  /// are the adjoint of each other (e.g., V T and T^+ V in [V, T - T^+]), and
+  /// obtains the terms of the other from the adjoint of the result (see
+  /// Expression::adjoint()). This assumes that all tensors are real
+  void use_adjoint_symmetry(bool val);
+
   /// Set the maximum cumulant level
   void set_max_cumulant(int val);
 
-  const std::map<std::string, double> &timers() const;
+  /// Return the time spent in each step (accumulated over all calls). The
+  /// time spent canonicalizing and evaluating each contraction is included
+  /// only when profiling is enabled
+  std::map<std::string, double> timers() const;
+
+  /// Return the estimated memory (bytes) used by the largest instance of each
+  /// structure over all calls to contract(). The entry "peak" is the largest
+  /// estimated total for a single call
+  std::map<std::string, size_t> memory() const;
+
+  /// Set a soft limit on the memory used by a call to contract() (bytes, 0 =
+  /// no limit). A call whose estimated memory use exceeds the limit throws a
+  /// std::runtime_error that reports the memory used by each structure
+  void set_memory_limit(size_t bytes);
+
+  /// Save the progress of contract(OperatorExpression) to the file path (an
+  /// empty path turns off checkpointing). The list of completed products and
+  /// the partial result are saved at most every interval seconds, and when
+  /// the contraction throws an exception. If resume is true and the file
+  /// exists, contract() restores the partial result and skips the completed
+  /// products. The file is removed when the contraction completes. Only one
+  /// contraction at a time should use a given file
+  void set_checkpoint(const std::string &path, double interval = 60.0,
+                      bool resume = true);
 
 private:
-  /// A vector of elementary contractions
-  std::vector<ElementaryContraction> elementary_contractions_;
+  /// The intermediates of a call to contract()
+  struct contraction_data {
+    /// A vector of elementary contractions
+    std::vector<ElementaryContraction> elementary_contractions;
 
-  /// The allowed contractions stored as a vector of indices of elementary
-  /// contractions
-  std::vector<std::vector<int>> contractions_;
+    /// The allowed contractions stored as a vector of indices of elementary
+    /// contractions
+    std::vector<std::vector<int>> contractions;
+
+    /// The time spent in each step
+    std::map<std::string, double> timers;
+
+    /// The number of contractions found
+    int ncontractions = 0;
+
+    /// The estimated memory used by the elementary contractions (bytes)
+    size_t elementary_contractions_bytes = 0;
+
+    /// The estimated memory used by the composite contractions (bytes)
+    size_t contractions_bytes = 0;
+
+    /// The largest estimated memory used to canonicalize a graph (bytes)
+    size_t graph_bytes = 0;
+
+    /// The estimated memory used by the result (bytes)
+    size_t result_bytes = 0;
+
+    /// Return the estimated memory used by each structure and their total
+    std::map<std::string, size_t> memory() const;
+  };
+
+  /// The estimated memory used by a term of an Expression (a node of a
+  /// std::map)
+  static constexpr size_t expression_term_bytes =
+      sizeof(std::pair<const CompactTerm, scalar_t>) + 4 * sizeof(void *);
 
+  /// The orbital spaces used by this object (if null, use those of the
+  /// calling thread)
+  std::shared_ptr<OrbitalSpaceInfo> osi_;
+
+  /// The time spent in each step accumulated over all calls
   std::map<std::string, double> timers_;
 
-  /// The number of contractions found
-  int ncontractions_ = 0;
+  /// The largest estimated memory used by each structure over all calls
+  std::map<std::string, size_t> memory_;
+
+  /// Guards timers_ and memory_
+  mutable std::mutex stats_mutex_;
+
+  /// The soft memory limit (bytes, 0 = no limit)
+  std::atomic<size_t> memory_limit_{0};
 
   /// The largest allowed cumulant
   int maxcumulant_ = 100;
@@ -63,9 +214,69 @@ private:
   /// Turn on/off graph canonicalization
   bool do_canonicalize_graph_ = true;
 
+  /// Reuse the contractions of adjoint products?
+  bool use_adjoint_symmetry_ = false;
+
   /// The default print level
   PrintLevel print_ = PrintLevel::None;
 
+  /// The checkpoint file (empty = no checkpointing)
+  std::string checkpoint_path_;
+
+  /// The minimum time between two checkpoints (s)
+  double checkpoint_interval_ = 60.0;
+
+  /// Resume from an existing checkpoint file?
+  bool checkpoint_resume_ = true;
+
+  /// Return the term of expr whose product is the adjoint of ops up to the
+  /// order of the operators that commute, and set sign to the sign of the
+  /// reordering. Return nullptr if there is no such product or if ops is its
+  /// own adjoint
+  static const std::pair<const OperatorProduct, scalar_t> *
+  find_adjoint(const OperatorExpression &expr, const OperatorProduct &ops,
+               scalar_t &sign);
+
+  /// Contract a product of operators once and return factor times the result
+  /// plus adjoint_factor times its adjoint
+  Expression contract_with_adjoint(scalar_t factor, const OperatorProduct &ops,
+                                   scalar_t adjoint_factor, const int minrank,
+                                   const int maxrank);
+
+  //
+  // Contraction of operators with composite spaces implemented in
+  // wick_theorem_composite_spaces.cc
+  //
+
+  /// Return the products of operators in elementary spaces that make up a
+  /// product with composite spaces. The operators are expanded one at a time,
+  /// and a partial product is dropped as soon as it cannot have contractions
+  /// with at most maxrank uncontracted operators
+  static std::vector<OperatorProduct>
+  expand_composite_product(const OperatorProduct &ops, const int maxrank);
+
+  /// Contract a product of operators with composite spaces
+  Expression contract_composite_product(scalar_t factor,
+                                        const OperatorProduct &ops,
+                                        const int minrank, const int maxrank);
+
+  //
+  // Checkpointing of contract(OperatorExpression) implemented in
+  // wick_theorem_checkpoint.cc
+  //
+
+  /// Read the checkpoint file. Return false if there is no file to resume
+  /// from, otherwise store the completed products and the partial result.
+  /// The key identifies the contraction that wrote the file
+  bool load_checkpoint(const std::string &key,
+                       std::vector<std::string> &products,
+                       Expression &result) const;
+
+  /// Write the checkpoint file (atomically)
+  void save_checkpoint(const std::string &key,
+                       const std::vector<std::string> &products,
+                       const Expression &result) const;
+
   //
   // Functions for step 1. of the Wick's theorem algorithm
   // implemented in wich_theorem_elementary_contractions.cc
@@ -98,7 +309,8 @@ private:
   /// Generates all composite contractions for a given contraction
   /// pattern stored in ops
   void generate_composite_contractions(const OperatorProduct &ops,
-                                       const int minrank, const int maxrank);
+                                       const int minrank, const int maxrank,
+                                       contraction_data &data);
 
   /// Backtracking algorithm used to generate all contractions product of
   /// elementary contractions
@@ -106,13 +318,14 @@ private:
       std::vector<int> a, int k,
       const std::vector<ElementaryContraction> &el_contr_vec,
       std::vector<GraphMatrix> &free_graph_matrix_vec, const int minrank,
-      const int maxrank);
+      const int maxrank, contraction_data &data);
 
   /// Process a contraction (store it) found by the backtracking algorithm
   void
   process_contraction(const std::vector<int> &a, int k,
                       const std::vector<GraphMatrix> &free_graph_matrix_vec,
-                      const int minrank, const int maxrank);
+                      const int minrank, const int maxrank,
+                      contraction_data &data);
 
   /// Return a vector of indices of elementary contractions that can be added to
   /// the current backtracking solution. All candidates generated here lead to
@@ -141,7 +354,8 @@ private:
 
   /// Process the contractions generated in step 2.
   Expression process_contractions(scalar_t factor, const OperatorProduct &ops,
-                                  const int minrank, const int maxrank);
+                                  const int minrank, const int maxrank,
+                                  contraction_data &data);
 
   /// Apply the contraction to this set of operators and produce a term
   std::pair<SymbolicTerm, scalar_t>
@@ -151,13 +365,13 @@ private:
 
   /// Return the tensors and operators correspoding to a product of operators
   std::tuple<std::vector<Tensor>, std::vector<SQOperator>,
-             std::map<std::tuple<int, int, bool, int>, int>>
+             arena_map<std::tuple<int, int, bool, int>, int>>
   contraction_tensors_sqops(const OperatorProduct &ops);
 
-  std::vector<int>
+  arena_vector<int>
   elements_vec_to_pos(const ElementaryContraction &elements_vec,
-                      std::vector<GraphMatrix> &ops_offset,
-                      std::map<std::tuple<int, int, bool, int>, int> &op_map,
+                      arena_vector<GraphMatrix> &ops_offset,
+                      arena_map<std::tuple<int, int, bool, int>, int> &op_map,
                       bool creation);
 
   /// Return the combinatorial factor corresponding to a contraction pattern
@@ -167,7 +381,11 @@ private:
   // Create a canonical contraction graph
   std::tuple<OperatorProduct, CompositeContraction, scalar_t>
   canonicalize_contraction_graph(const OperatorProduct &ops,
-                                 const CompositeContraction &contractions);
+                                 const CompositeContraction &contractions,
+                                 contraction_data &data);
+
+  /// Throw if the memory used by a call exceeds the soft limit
+  void check_memory_limit(const contraction_data &data) const;
 };
 
 #endif // _wicked_diag_theorem_h_
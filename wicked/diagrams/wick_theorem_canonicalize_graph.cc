@@ -4,9 +4,11 @@
 
 #include "fmt/format.h"
 
+#include "helpers/arena.hpp"
 #include "helpers/combinatorics.h"
 #include "helpers/helpers.h"
 #include "helpers/orbital_space.h"
+#include "helpers/profile.h"
 #include "helpers/stl_utils.hpp"
 
 #include "contraction.h"
@@ -28,9 +30,9 @@
 void print_key(std::tuple<int, int, bool, int> key, int n);
 void print_contraction(const OperatorProduct &ops,
                        const std::vector<Tensor> &tensors,
-                       const std::vector<std::vector<bool>> &bit_map_vec,
+                       const arena_vector<arena_vector<bool>> &bit_map_vec,
                        const std::vector<SQOperator> &sqops,
-                       const std::vector<int> sign_order);
+                       const arena_vector<int> &sign_order);
 
 void print_contraction_graph(const OperatorProduct &ops,
                              const CompositeContraction &contractions,
@@ -45,8 +47,8 @@ std::string contraction_signature(const OperatorProduct &ops,
 using namespace std;
 
 std::pair<bool, scalar_t>
-is_ops_permutation_valid(const OperatorProduct &ops, std::vector<int> ops_perm,
-                         const std::vector<std::vector<bool>> &permutable) {
+is_ops_permutation_valid(const OperatorProduct &ops, arena_vector<int> ops_perm,
+                         const arena_vector<arena_vector<bool>> &permutable) {
   // ok, so we are given a permutation of some operators and a matrix that tells
   // us which operators/contractions commute. Let's find out if this permutation
   // is consistent with the allowed permutations.
@@ -85,7 +87,7 @@ bool do_contractions_commute(int i, int j, const OperatorProduct &ops,
   // loop over all elementary contractions
   for (const auto &el_contr : contractions) {
     // loop over all orbital spaces
-    for (int s = 0; s < orbital_subspaces->num_spaces(); ++s) {
+    for (int s = 0; s < get_osi()->num_spaces(); ++s) {
       // check if this is a single contraction
       if (el_contr.num_ops() == 2) {
         if (el_contr[i].cre(s) * el_contr[j].ann(s) > 0) {
@@ -101,8 +103,8 @@ bool do_contractions_commute(int i, int j, const OperatorProduct &ops,
 }
 
 bool graph_less(const std::pair<int, int> &l, const std::pair<int, int> &r,
-                const std::vector<std::vector<int>> &ops_perms,
-                std::vector<std::vector<int>> &con_perms,
+                const arena_vector<arena_vector<int>> &ops_perms,
+                const arena_vector<arena_vector<int>> &con_perms,
                 const OperatorProduct &ops,
                 const CompositeContraction &contractions) {
   // here we are given the indices of the permutations of the operators and we
@@ -148,7 +150,8 @@ bool graph_less(const std::pair<int, int> &l, const std::pair<int, int> &r,
 
 std::tuple<OperatorProduct, CompositeContraction, scalar_t>
 WickTheorem::canonicalize_contraction_graph(
-    const OperatorProduct &ops, const CompositeContraction &contractions) {
+    const OperatorProduct &ops, const CompositeContraction &contractions,
+    contraction_data &data) {
 
   PRINT(PrintLevel::Detailed,
         cout << "  Graph of the contraction to canonicalize:" << endl;
@@ -157,12 +160,16 @@ WickTheorem::canonicalize_contraction_graph(
         print_contraction_graph(ops, contractions, input_ops_perm,
                                 input_contr_perm););
 
+  // all the temporaries used to find the canonical graph are released in one
+  // step at the end of this scope
+  arena_scope scope;
+
   const int nops = ops.size();
 
   // create a matrix that tells us if we can permute the position of two
   // operators
-  std::vector<std::vector<bool>> commutable(nops,
-                                            std::vector<bool>(nops, false));
+  arena_vector<arena_vector<bool>> commutable(nops,
+                                              arena_vector<bool>(nops, false));
   for (int i = 0; i < nops; i++) {
     for (int j = 0; j < nops; j++) {
       // check if commuting operators i and j changes the contraction
@@ -184,13 +191,15 @@ WickTheorem::canonicalize_contraction_graph(
 
   // 1. Generate all possible permutation of operators
   // these vectors store the allowed permutations
-  std::vector<std::vector<int>> ops_perms;
-  std::vector<scalar_t> ops_perms_sign;
+  arena_vector<arena_vector<int>> ops_perms;
+  arena_vector<scalar_t> ops_perms_sign;
   {
     // Loop over all permutations of operators
-    std::vector<int> ops_perm(ops.size());
+    arena_vector<int> ops_perm(ops.size());
     std::iota(ops_perm.begin(), ops_perm.end(), 0);
+    uint64_t nperms = 0;
     do {
+      nperms++;
       if (const auto [is_valid, sign] =
               is_ops_permutation_valid(ops, ops_perm, commutable);
           is_valid) {
@@ -204,15 +213,16 @@ WickTheorem::canonicalize_contraction_graph(
               PRINT_ELEMENTS(ops_perm); cout << " (not allowed)" << endl;);
       }
     } while (std::next_permutation(ops_perm.begin(), ops_perm.end()));
+    PROFILE_COUNT(Counter::OperatorPermutations, nperms);
   }
   PRINT(PrintLevel::Detailed, cout << "\n  Found " << ops_perms.size()
                                    << " valid operator permutations\n"
                                    << endl;);
 
-  std::vector<std::vector<int>> con_perms;
+  arena_vector<arena_vector<int>> con_perms;
   {
     // Loop over all permutations of contractions
-    std::vector<int> con_perm(contractions.size());
+    arena_vector<int> con_perm(contractions.size());
     std::iota(con_perm.begin(), con_perm.end(), 0);
     do {
       PRINT(PrintLevel::Detailed, cout << "  Contraction permutation: ";
@@ -225,9 +235,10 @@ WickTheorem::canonicalize_contraction_graph(
                                    << endl;);
 
   // store all the possible graphs
-  std::vector<std::pair<int, int>> graphs;
-  for (const auto &[o, ops_perm] : enumerate(ops_perms)) {
-    for (const auto &[c, con_perm] : enumerate(con_perms)) {
+  arena_vector<std::pair<int, int>> graphs;
+  graphs.reserve(ops_perms.size() * con_perms.size());
+  for (int o = 0, maxo = ops_perms.size(); o < maxo; o++) {
+    for (int c = 0, maxc = con_perms.size(); c < maxc; c++) {
       graphs.push_back(std::pair(o, c));
     }
   }
@@ -235,6 +246,15 @@ WickTheorem::canonicalize_contraction_graph(
   PRINT(PrintLevel::Detailed,
         cout << "  Found " << graphs.size() << " valid graphs" << endl;);
 
+  const size_t bytes =
+      graphs.capacity() * sizeof(std::pair<int, int>) +
+      ops_perms.size() * (sizeof(arena_vector<int>) + nops * sizeof(int)) +
+      ops_perms_sign.size() * sizeof(scalar_t) +
+      con_perms.size() * (sizeof(arena_vector<int>) +
+                          contractions.size() * sizeof(int));
+  data.graph_bytes = std::max(data.graph_bytes, bytes);
+  check_memory_limit(data);
+
   // sort all the graphs
   std::sort(graphs.begin(), graphs.end(),
             [&](const std::pair<int, int> &l, const std::pair<int, int> &r) {
@@ -271,9 +291,12 @@ WickTheorem::canonicalize_contraction_graph(
         cout << "    Contraction permutation: ";
         PRINT_ELEMENTS(con_perms[canonical_contr_perm_idx]); cout << endl;
         cout << "    Graph of the canonical contraction:" << endl;
-        print_contraction_graph(ops, contractions,
-                                ops_perms[canonical_ops_perm_idx],
-                                con_perms[canonical_contr_perm_idx]);
+        print_contraction_graph(
+            ops, contractions,
+            std::vector<int>(ops_perms[canonical_ops_perm_idx].begin(),
+                             ops_perms[canonical_ops_perm_idx].end()),
+            std::vector<int>(con_perms[canonical_contr_perm_idx].begin(),
+                             con_perms[canonical_contr_perm_idx].end()));
         cout << endl;);
 
   return std::make_tuple(canonical_ops, canonical_contr, canonical_sign);
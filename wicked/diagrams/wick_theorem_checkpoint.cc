@@ -0,0 +1,115 @@
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+#include "wick_theorem.h"
+
+// The checkpoint file is a text file with the format
+//
+//   wicked checkpoint 1
+//   key KEY
+//   products N
+//   PRODUCT          (N lines, one for each completed product)
+//   terms M
+//   COEFFICIENT TERM (M lines, the terms of the partial result)
+//
+// KEY is a hash of the arguments of contract(), the settings of WickTheorem
+// that affect the result (e.g., the maximum cumulant), and the orbital spaces,
+// so a file written by another contraction is not used by mistake.
+
+namespace {
+const std::string checkpoint_header = "wicked checkpoint 1";
+
+/// Read a line of the form "keyword value" and return value
+std::string read_field(std::istream &in, const std::string &keyword) {
+  std::string line;
+  if (not std::getline(in, line) or
+      (line.compare(0, keyword.size() + 1, keyword + " ") != 0)) {
+    throw std::runtime_error("expected the field " + keyword);
+  }
+  return line.substr(keyword.size() + 1);
+}
+} // namespace
+
+void WickTheorem::set_checkpoint(const std::string &path, double interval,
+                                 bool resume) {
+  checkpoint_path_ = path;
+  checkpoint_interval_ = interval;
+  checkpoint_resume_ = resume;
+}
+
+bool WickTheorem::load_checkpoint(const std::string &key,
+                                  std::vector<std::string> &products,
+                                  Expression &result) const {
+  if (not checkpoint_resume_) {
+    return false;
+  }
+  std::ifstream in(checkpoint_path_);
+  if (not in) {
+    return false;
+  }
+  try {
+    std::string line;
+    if (not std::getline(in, line) or (line != checkpoint_header)) {
+      throw std::runtime_error("this is not a checkpoint file");
+    }
+    if (read_field(in, "key") != key) {
+      throw std::runtime_error("the file was written by another contraction");
+    }
+    const int nproducts = std::stoi(read_field(in, "products"));
+    for (int n = 0; n < nproducts; n++) {
+      if (not std::getline(in, line)) {
+        throw std::runtime_error("the file is truncated");
+      }
+      products.push_back(line);
+    }
+    const int nterms = std::stoi(read_field(in, "terms"));
+    for (int n = 0; n < nterms; n++) {
+      if (not std::getline(in, line)) {
+        throw std::runtime_error("the file is truncated");
+      }
+      result.add(string_to_expr(line, SymmetryType::Antisymmetric));
+    }
+  } catch (const std::exception &e) {
+    throw std::runtime_error("\nWickTheorem::contract() - cannot resume from "
+                             "the checkpoint file " +
+                             checkpoint_path_ + ": " + e.what());
+  }
+  return true;
+}
+
+void WickTheorem::save_checkpoint(const std::string &key,
+                                  const std::vector<std::string> &products,
+                                  const Expression &result) const {
+  // write a temporary file and rename it, so that an interruption never
+  // leaves a partially written checkpoint
+  const std::string tmp_path = checkpoint_path_ + ".tmp";
+  {
+    std::ofstream out(tmp_path);
+    out << checkpoint_header << '\n';
+    out << "key " << key << '\n';
+    out << "products " << products.size() << '\n';
+    for (const auto &product : products) {
+      out << product << '\n';
+    }
+    out << "terms " << result.size() << '\n';
+    for (const auto &[term, c] : result.compact_terms()) {
+      std::string coefficient = c.str(true);
+      // rational::str() omits a unit numerator
+      if ((coefficient == "+") or (coefficient == "-")) {
+        coefficient += "1";
+      }
+      out << coefficient << ' ' << term.term().str() << '\n';
+    }
+    if (not out) {
+      throw std::runtime_error("\nWickTheorem::contract() - cannot write the "
+                               "checkpoint file " +
+                               tmp_path);
+    }
+  }
+  if (std::rename(tmp_path.c_str(), checkpoint_path_.c_str()) != 0) {
+    throw std::runtime_error("\nWickTheorem::contract() - cannot write the "
+                             "checkpoint file " +
+                             checkpoint_path_);
+  }
+}
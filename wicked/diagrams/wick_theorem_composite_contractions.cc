@@ -3,6 +3,8 @@
 
 #include "fmt/format.h"
 
+#include "helpers/profile.h"
+
 #include "contraction.h"
 #include "graph_matrix.h"
 #include "operator.h"
@@ -19,7 +21,8 @@ using namespace std;
 
 void WickTheorem::generate_composite_contractions(const OperatorProduct &ops,
                                                   const int minrank,
-                                                  const int maxrank) {
+                                                  const int maxrank,
+                                                  contraction_data &data) {
   PRINT(PrintLevel::Summary,
         std::cout << "\n- Step 2. Generating composite contractions"
                   << std::endl;)
@@ -42,20 +45,21 @@ void WickTheorem::generate_composite_contractions(const OperatorProduct &ops,
            "----------------------------------------------------------";)
 
   // generate all contractions by backtracking
-  generate_contractions_backtrack(a, 0, elementary_contractions_,
-                                  free_graph_matrix_vec, minrank, maxrank);
+  generate_contractions_backtrack(a, 0, data.elementary_contractions,
+                                  free_graph_matrix_vec, minrank, maxrank,
+                                  data);
   PRINT(PrintLevel::Summary, std::cout << "\n\n    Total contractions: "
-                                       << ncontractions_ << std::endl;)
+                                       << data.ncontractions << std::endl;)
 }
 
 void WickTheorem::generate_contractions_backtrack(
     std::vector<int> a, int k,
     const std::vector<ElementaryContraction> &el_contr_vec,
     std::vector<GraphMatrix> &free_graph_matrix_vec, const int minrank,
-    const int maxrank) {
+    const int maxrank, contraction_data &data) {
 
   // process this contraction
-  process_contraction(a, k, free_graph_matrix_vec, minrank, maxrank);
+  process_contraction(a, k, free_graph_matrix_vec, minrank, maxrank, data);
 
   // build a list of candidate contractions to add to this solution
   k = k + 1;
@@ -66,7 +70,7 @@ void WickTheorem::generate_contractions_backtrack(
   for (const auto &c : candidates) {
     make_move(a, k, c, el_contr_vec, free_graph_matrix_vec);
     generate_contractions_backtrack(a, k, el_contr_vec, free_graph_matrix_vec,
-                                    minrank, maxrank);
+                                    minrank, maxrank, data);
     unmake_move(a, k, c, el_contr_vec, free_graph_matrix_vec);
   }
 }
@@ -74,16 +78,18 @@ void WickTheorem::generate_contractions_backtrack(
 void WickTheorem::process_contraction(
     const std::vector<int> &a, int k,
     const std::vector<GraphMatrix> &free_graph_matrix_vec, const int minrank,
-    const int maxrank) {
+    const int maxrank, contraction_data &data) {
   int num_ops = sum_num_ops(free_graph_matrix_vec);
   if ((num_ops >= minrank) and (num_ops <= maxrank)) {
-    contractions_.push_back(std::vector<int>(a.begin(), a.begin() + k));
-    ncontractions_++;
+    data.contractions.push_back(std::vector<int>(a.begin(), a.begin() + k));
+    data.ncontractions++;
+    data.contractions_bytes += sizeof(std::vector<int>) + k * sizeof(int);
+    check_memory_limit(data);
     PRINT(
         PrintLevel::Summary, GraphMatrix free_ops;
         for (const auto &free_graph_matrix
              : free_graph_matrix_vec) { free_ops += free_graph_matrix; };
-        cout << fmt::format("\n  {:5d}    {:3d}    ", ncontractions_ + 1,
+        cout << fmt::format("\n  {:5d}    {:3d}    ", data.ncontractions + 1,
                             free_ops.num_ops());
         for (int i = 0; i < k; ++i) { cout << fmt::format(" {:3d}", a[i]); };
         cout << std::string(std::max(24 - 4 * k, 2), ' ') << free_ops;)
@@ -97,6 +103,7 @@ std::vector<int> WickTheorem::construct_candidates(
 
   std::vector<int> candidates;
   int nops = free_graph_matrix_vec.size();
+  const int nspaces = get_osi()->num_spaces();
 
   // determine the last elementary contraction used
   // the -2 is here because k is incremented just before calling this function
@@ -112,7 +119,7 @@ std::vector<int> WickTheorem::construct_candidates(
     // free (uncontracted) operators
     bool is_valid_contraction = true;
     for (int A = 0; A < nops; A++) {
-      for (int s = 0; s < orbital_subspaces->num_spaces(); s++) {
+      for (int s = 0; s < nspaces; s++) {
         if (free_graph_matrix_vec[A].cre(s) < el_contr[A].cre(s)) {
           is_valid_contraction = false;
         }
@@ -125,6 +132,7 @@ std::vector<int> WickTheorem::construct_candidates(
       candidates.push_back(c);
     }
   }
+  PROFILE_COUNT(Counter::PrunedBranches, (maxc - minc) - candidates.size());
   return candidates;
 }
 
@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <cstdlib>
+
+#include "helpers/orbital_space.h"
+#include "operator.h"
+#include "operator_product.h"
+
+#include "wick_theorem.h"
+
+// An operator in a composite space stands for the sum of its components in
+// the elementary spaces, and it is contracted by contracting each of them.
+// Expanding a product of such operators up front produces many products that
+// cannot contribute: every elementary contraction removes as many creation as
+// annihilation operators from a space, so a product with creation counts C_s
+// and annihilation counts A_s in each elementary space s leaves at least
+// sum_s |C_s - A_s| operators uncontracted. Here the products are expanded
+// one operator at a time, and a partial product is dropped when this bound,
+// lowered by the number of composite operators still to be assigned, exceeds
+// the maximum rank.
+
+namespace {
+/// A lower bound to the number of uncontracted operators of a product. The
+/// operators counted in free can each lower the bound by one
+int min_uncontracted(const std::vector<int> &imbalance, int free) {
+  int n = 0;
+  for (int d : imbalance) {
+    n += std::abs(d);
+  }
+  return std::max(0, n - free);
+}
+} // namespace
+
+std::vector<OperatorProduct>
+WickTheorem::expand_composite_product(const OperatorProduct &ops,
+                                      const int maxrank) {
+  const int nspaces = get_osi()->num_spaces();
+  // the creation minus annihilation counts of the operators in elementary
+  // spaces, and the number of operators in composite spaces not yet expanded
+  std::vector<int> fixed(nspaces, 0);
+  int free = 0;
+  for (const auto &op : ops) {
+    for (int s = 0; s < nspaces; s++) {
+      fixed[s] += op.cre(s) - op.ann(s);
+    }
+    free += op.composite_graph_matrix().num_ops();
+  }
+
+  // a partial product and its creation minus annihilation counts
+  std::vector<std::pair<std::vector<Operator>, std::vector<int>>> partial{
+      {{}, fixed}};
+  for (const auto &op : ops) {
+    free -= op.composite_graph_matrix().num_ops();
+    const auto blocks = expand_composite_spaces(op);
+    std::vector<std::pair<std::vector<Operator>, std::vector<int>>> expanded;
+    for (const auto &[prod, imbalance] : partial) {
+      for (const auto &block : blocks) {
+        // the operators of op in elementary spaces are already counted
+        std::vector<int> new_imbalance(imbalance);
+        for (int s = 0; s < nspaces; s++) {
+          new_imbalance[s] += (block.cre(s) - op.cre(s)) -
+                              (block.ann(s) - op.ann(s));
+        }
+        if (min_uncontracted(new_imbalance, free) > maxrank) {
+          continue;
+        }
+        expanded.emplace_back(prod, std::move(new_imbalance));
+        expanded.back().first.push_back(block);
+      }
+    }
+    partial = std::move(expanded);
+  }
+
+  std::vector<OperatorProduct> result;
+  for (const auto &[prod, imbalance] : partial) {
+    result.emplace_back(prod);
+  }
+  return result;
+}
+
+Expression WickTheorem::contract_composite_product(scalar_t factor,
+                                                   const OperatorProduct &ops,
+                                                   const int minrank,
+                                                   const int maxrank) {
+  Expression result;
+  for (const auto &prod : expand_composite_product(ops, maxrank)) {
+    result += contract(factor, prod, minrank, maxrank);
+  }
+  return result;
+}
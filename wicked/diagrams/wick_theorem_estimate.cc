@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+#include "fmt/format.h"
+
+#include "helpers/arena.hpp"
+#include "helpers/combinatorics.h"
+#include "helpers/orbital_space.h"
+
+#include "contraction.h"
+#include "graph_matrix.h"
+#include "operator.h"
+#include "operator_expression.h"
+
+#include "wick_theorem.h"
+
+using namespace std;
+
+namespace {
+
+/// Counts the composite contractions generated by the backtracking algorithm
+/// of WickTheorem::generate_composite_contractions. The backtracking
+/// algorithm visits each multiset of elementary contractions that fits in the
+/// free graph matrices once, so the number of multisets that use the
+/// elementary contractions c, c + 1, ... depends only on c and on the free
+/// graph matrices. These counts are memoized.
+class contraction_counter {
+public:
+  contraction_counter(const std::vector<ElementaryContraction> &el_contr_vec,
+                      int minrank, int maxrank)
+      : el_contr_vec_(el_contr_vec), minrank_(minrank), maxrank_(maxrank),
+        nspaces_(get_osi()->num_spaces()) {}
+
+  /// Return the number of contractions of the free graph matrices with rank
+  /// in [minrank, maxrank] that use the elementary contractions c, c + 1, ...
+  /// Element k of the result counts the contractions made of k elementary
+  /// contractions
+  const std::vector<uint64_t> &count(int c, std::vector<GraphMatrix> &free) {
+    auto key = std::make_pair(c, free);
+    if (auto it = memo_.find(key); it != memo_.end()) {
+      return it->second;
+    }
+    std::vector<uint64_t> result;
+    if (c == static_cast<int>(el_contr_vec_.size())) {
+      const int rank = sum_num_ops(free);
+      if ((rank >= minrank_) and (rank <= maxrank_)) {
+        result.push_back(1);
+      }
+    } else {
+      // the contractions that do not use c
+      result = count(c + 1, free);
+      // the contractions that use c at least once
+      if (fits(el_contr_vec_[c], free)) {
+        apply(el_contr_vec_[c], free, -1);
+        const auto &with_c = count(c, free);
+        apply(el_contr_vec_[c], free, +1);
+        if (result.size() < with_c.size() + 1) {
+          result.resize(with_c.size() + 1, 0);
+        }
+        for (size_t k = 0; k < with_c.size(); k++) {
+          result[k + 1] += with_c[k];
+        }
+      }
+    }
+    return memo_.emplace(std::move(key), std::move(result)).first->second;
+  }
+
+private:
+  /// Can this elementary contraction be applied to the free graph matrices?
+  bool fits(const ElementaryContraction &el_contr,
+            const std::vector<GraphMatrix> &free) const {
+    for (size_t A = 0; A < free.size(); A++) {
+      for (int s = 0; s < nspaces_; s++) {
+        if ((free[A].cre(s) < el_contr[A].cre(s)) or
+            (free[A].ann(s) < el_contr[A].ann(s))) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  /// Add (sign = 1) or remove (sign = -1) an elementary contraction from the
+  /// free graph matrices
+  void apply(const ElementaryContraction &el_contr,
+             std::vector<GraphMatrix> &free, int sign) const {
+    for (size_t A = 0; A < free.size(); A++) {
+      if (sign > 0) {
+        free[A] += el_contr[A];
+      } else {
+        free[A] -= el_contr[A];
+      }
+    }
+  }
+
+  const std::vector<ElementaryContraction> &el_contr_vec_;
+  const int minrank_;
+  const int maxrank_;
+  const int nspaces_;
+  std::map<std::pair<int, std::vector<GraphMatrix>>, std::vector<uint64_t>>
+      memo_;
+};
+
+} // namespace
+
+std::string ContractionEstimate::str() const {
+  return fmt::format("{}: {} elementary contractions, {} contractions, <= {} "
+                     "terms, {} operator permutations, <= {} graphs, <= {} "
+                     "bytes",
+                     product, elementary_contractions, contractions, terms,
+                     operator_permutations, graphs, bytes);
+}
+
+ContractionEstimate WickTheorem::estimate(const OperatorProduct &ops,
+                                          const int minrank,
+                                          const int maxrank) {
+  osi_scope scope(osi_);
+  ContractionEstimate result;
+  for (const auto &op : ops) {
+    result.product += (result.product.empty() ? "" : " ") + op.str();
+  }
+
+  // a product with composite spaces costs as much as its elementary products
+  for (const auto &op : ops) {
+    if (op.is_composite()) {
+      for (const auto &prod : expand_composite_product(ops, maxrank)) {
+        const auto estimate_prod = estimate(prod, minrank, maxrank);
+        result.elementary_contractions += estimate_prod.elementary_contractions;
+        result.contractions += estimate_prod.contractions;
+        result.terms += estimate_prod.terms;
+        result.operator_permutations += estimate_prod.operator_permutations;
+        result.graphs += estimate_prod.graphs;
+        result.bytes = std::max(result.bytes, estimate_prod.bytes);
+      }
+      return result;
+    }
+  }
+
+  const auto el_contr_vec = generate_elementary_contractions(ops);
+  result.elementary_contractions = el_contr_vec.size();
+
+  std::vector<GraphMatrix> free_graph_matrix_vec;
+  for (const auto &op : ops) {
+    free_graph_matrix_vec.push_back(op.graph_matrix());
+  }
+  contraction_counter counter(el_contr_vec, minrank, maxrank);
+  // counts[k] is the number of contractions made of k elementary contractions
+  const std::vector<uint64_t> counts =
+      counter.count(0, free_graph_matrix_vec);
+
+  // the memory estimates follow those of contract()
+  size_t elementary_contractions_bytes =
+      el_contr_vec.capacity() * sizeof(ElementaryContraction);
+  for (const auto &contr : el_contr_vec) {
+    elementary_contractions_bytes += contr.size() * sizeof(GraphMatrix);
+  }
+  size_t contractions_bytes = 0;
+  size_t graph_bytes = 0;
+
+  const int nops = ops.size();
+  const uint64_t nops_perms = factorial(nops);
+  for (int k = 0, maxk = counts.size(); k < maxk; k++) {
+    if (counts[k] == 0) {
+      continue;
+    }
+    result.contractions += counts[k];
+    contractions_bytes +=
+        counts[k] * (sizeof(std::vector<int>) + k * sizeof(int));
+    if (do_canonicalize_graph_) {
+      // all the operator permutations are tested, but only the valid ones
+      // are combined with the k! permutations of the contractions
+      const uint64_t con_perms = factorial(k);
+      result.operator_permutations += counts[k] * nops_perms;
+      result.graphs += counts[k] * nops_perms * con_perms;
+      graph_bytes = std::max(
+          graph_bytes,
+          nops_perms * con_perms * sizeof(std::pair<int, int>) +
+              nops_perms * (sizeof(arena_vector<int>) + nops * sizeof(int) +
+                            sizeof(scalar_t)) +
+              con_perms * (sizeof(arena_vector<int>) + k * sizeof(int)));
+    }
+  }
+  result.terms = result.contractions;
+  result.bytes = elementary_contractions_bytes + contractions_bytes +
+                 graph_bytes + result.terms * expression_term_bytes;
+  return result;
+}
+
+std::vector<ContractionEstimate>
+WickTheorem::estimate(const OperatorExpression &expr, const int minrank,
+                      const int maxrank) {
+  osi_scope scope(osi_);
+  std::vector<ContractionEstimate> result;
+  for (const auto &[ops, f] : expr.terms()) {
+    result.push_back(estimate(ops, minrank, maxrank));
+  }
+  return result;
+}
+
+std::vector<OperatorExpression>
+WickTheorem::shard_by_cost(const OperatorExpression &expr, int nshards,
+                           const int minrank, const int maxrank) {
+  if (nshards < 1) {
+    throw std::runtime_error("WickTheorem::shard_by_cost() - the number of "
+                             "shards must be positive");
+  }
+  const auto estimates = estimate(expr, minrank, maxrank);
+  std::vector<std::pair<uint64_t, size_t>> cost_index;
+  for (size_t n = 0; n < estimates.size(); n++) {
+    // every product has a minimum cost, even if it has no contractions
+    cost_index.emplace_back(estimates[n].contractions + 1, n);
+  }
+  // assign the most expensive products first, each to the cheapest shard
+  // (ties are broken by the position in expr, so the result is reproducible)
+  std::sort(cost_index.begin(), cost_index.end(), [](auto &a, auto &b) {
+    return a.first != b.first ? a.first > b.first : a.second < b.second;
+  });
+  std::vector<const std::pair<const OperatorProduct, scalar_t> *> terms;
+  for (const auto &term : expr.terms()) {
+    terms.push_back(&term);
+  }
+  std::vector<OperatorExpression> shards(nshards);
+  std::vector<uint64_t> shard_cost(nshards, 0);
+  for (const auto &[cost, n] : cost_index) {
+    const size_t s = std::min_element(shard_cost.begin(), shard_cost.end()) -
+                     shard_cost.begin();
+    shards[s].add(terms[n]->first, terms[n]->second);
+    shard_cost[s] += cost;
+  }
+  return shards;
+}
@@ -5,6 +5,8 @@
 
 #include "fmt/format.h"
 
+#include "helpers/arena.hpp"
+
 #include "contraction.h"
 #include "operator.h"
 #include "operator_product.h"
@@ -48,9 +50,9 @@ void print_key(std::tuple<int, int, bool, int> key, int n) {
 
 void print_contraction(const OperatorProduct &ops,
                        const std::vector<Tensor> &tensors,
-                       const std::vector<std::vector<bool>> &bit_map_vec,
+                       const arena_vector<arena_vector<bool>> &bit_map_vec,
                        const std::vector<SQOperator> &sqops,
-                       const std::vector<int> sign_order) {
+                       const arena_vector<int> &sign_order) {
   std::string pre("          ");
   // 1. Draw the contraction legs
   for (const auto &bit_map : bit_map_vec) {
@@ -1,14 +1,18 @@
 #include <algorithm>
 #include <iomanip>
 #include <iostream>
+#include <optional>
 
 #include "fmt/format.h"
 
+#include "helpers/arena.hpp"
 #include "helpers/combinatorics.h"
 #include "helpers/helpers.h"
 #include "helpers/orbital_space.h"
+#include "helpers/profile.h"
 #include "helpers/stl_utils.hpp"
 #include "helpers/timer.hpp"
+#include "helpers/trace.h"
 
 #include "contraction.h"
 #include "operator.h"
@@ -29,9 +33,9 @@
 void print_key(std::tuple<int, int, bool, int> key, int n);
 void print_contraction(const OperatorProduct &ops,
                        const std::vector<Tensor> &tensors,
-                       const std::vector<std::vector<bool>> &bit_map_vec,
+                       const arena_vector<arena_vector<bool>> &bit_map_vec,
                        const std::vector<SQOperator> &sqops,
-                       const std::vector<int> sign_order);
+                       const arena_vector<int> &sign_order);
 
 void print_contraction_graph(const OperatorProduct &ops,
                              const CompositeContraction &contractions,
@@ -48,7 +52,8 @@ using namespace std;
 Expression WickTheorem::process_contractions(scalar_t factor,
                                              const OperatorProduct &ops,
                                              const int minrank,
-                                             const int maxrank) {
+                                             const int maxrank,
+                                             contraction_data &data) {
   PRINT(PrintLevel::Summary,
         std::cout << "\n- Step 3. Processing contractions" << std::endl;)
 
@@ -59,10 +64,11 @@ Expression WickTheorem::process_contractions(scalar_t factor,
   // in a term
   int nprocessed = 0;
   int ops_rank = ops.num_ops();
-  for (const auto &contraction_vec : contractions_) {
+  const bool profile = profile_enabled();
+  for (const auto &contraction_vec : data.contractions) {
     int contr_rank = 0;
     for (int c : contraction_vec) {
-      contr_rank += elementary_contractions_[c].num_ops();
+      contr_rank += data.elementary_contractions[c].num_ops();
     }
     int term_rank = ops_rank - contr_rank;
 
@@ -72,27 +78,50 @@ Expression WickTheorem::process_contractions(scalar_t factor,
             cout << "\n\n  Contraction: " << nprocessed
                  << "  Operator rank: " << ops_rank - contr_rank << endl;)
 
+      // all the temporaries allocated while processing this contraction are
+      // released in one step at the end of this scope
+      arena_scope scope;
+
       CompositeContraction contraction;
       for (int c : contraction_vec) {
-        contraction.push_back(elementary_contractions_[c]);
+        contraction.push_back(data.elementary_contractions[c]);
       }
 
-      timer tc;
+      // these two parts are timed only when profiling
+      std::optional<timer> t;
+      if (profile) {
+        t.emplace();
+      }
+      trace_span graph_span("canonicalize graph");
       const auto [best_ops, best_contractions, sign] =
           do_canonicalize_graph_
-              ? canonicalize_contraction_graph(ops, contraction)
+              ? canonicalize_contraction_graph(ops, contraction, data)
               : std::make_tuple(ops, contraction, scalar_t(1));
-      timers_["canonicalize_contraction_graph"] += tc.get();
+      graph_span.end();
+      if (profile) {
+        data.timers["canonicalize_contraction_graph"] += t->get();
+        t->reset();
+      }
 
-      timer te;
+      trace_span evaluate_span("evaluate contraction");
       std::pair<SymbolicTerm, scalar_t> term_factor =
           evaluate_contraction(best_ops, best_contractions, factor * sign);
-      timers_["evaluate_contraction"] += te.get();
+      evaluate_span.end();
+      if (profile) {
+        data.timers["evaluate_contraction"] += t->get();
+      }
 
+      trace_span term_span("canonicalize term");
       SymbolicTerm &term = term_factor.first;
       scalar_t canonicalize_factor = term.canonicalize();
+      term_span.end();
+
+      trace_span merge_span("merge");
       result.add(
           std::make_pair(term, term_factor.second * canonicalize_factor));
+      merge_span.end();
+      data.result_bytes = result.size() * expression_term_bytes;
+      check_memory_limit(data);
 
       PRINT(PrintLevel::Summary,
             Term t(term_factor.second * canonicalize_factor, term);
@@ -145,14 +174,14 @@ WickTheorem::evaluate_contraction(const OperatorProduct &ops,
   //  std::map<std::tuple<int, int, bool, int>, int> op_map;
   //                       op space cre    n
   //
-  std::map<std::tuple<int, int, bool, int>, int> &op_map =
+  arena_map<std::tuple<int, int, bool, int>, int> &op_map =
       std::get<2>(tensors_sqops_op_map);
 
   // 2. Apply the contractions to the second quantized operators and add new
   // tensors (density matrices, cumulants)
 
   // counts of how many second quantized operators are not contracted
-  std::vector<GraphMatrix> ops_offset(ops.size());
+  arena_vector<GraphMatrix> ops_offset(ops.size());
 
   // a counter to keep track of the positions assigned to operators
   int sorted_position = 0;
@@ -167,13 +196,13 @@ WickTheorem::evaluate_contraction(const OperatorProduct &ops,
   index_map_t pair_contraction_reindex_map;
 
   // vector to store the order of operators
-  std::vector<int> sign_order(sqops.size(), -1);
-  std::vector<std::vector<bool>> bit_map_vec;
+  arena_vector<int> sign_order(sqops.size(), -1);
+  arena_vector<arena_vector<bool>> bit_map_vec;
 
   // Loop over elementary contractions
   for (const ElementaryContraction &contraction : contractions) {
     // a bit array to keep track of which operators are contracted
-    std::vector<bool> bit_map(sqops.size(), false);
+    arena_vector<bool> bit_map(sqops.size(), false);
 
     // Find the rank and space of this contraction
     int rank = contraction.num_ops();
@@ -181,10 +210,10 @@ WickTheorem::evaluate_contraction(const OperatorProduct &ops,
     nsqops_contracted += rank;
 
     // find the position of the creation operators
-    std::vector<int> pos_cre_sqops =
+    arena_vector<int> pos_cre_sqops =
         elements_vec_to_pos(contraction, ops_offset, op_map, true);
     // find the position of the annihilation operators
-    std::vector<int> pos_ann_sqops =
+    arena_vector<int> pos_ann_sqops =
         elements_vec_to_pos(contraction, ops_offset, op_map, false);
 
     // mark the creation operators contracted and their order
@@ -200,7 +229,7 @@ WickTheorem::evaluate_contraction(const OperatorProduct &ops,
       sorted_position += 1;
     }
 
-    SpaceType dmstruc = orbital_subspaces->space_type(s);
+    SpaceType dmstruc = get_osi()->space_type(s);
 
     // Pairwise contractions creation-annihilation:
     // ________
@@ -275,7 +304,7 @@ WickTheorem::evaluate_contraction(const OperatorProduct &ops,
   // creation operators come before annihilation operators
   for (SQOperatorType type :
        {SQOperatorType::Creation, SQOperatorType::Annihilation}) {
-    for (int s = 0; s < orbital_subspaces->num_spaces(); s++) {
+    for (int s = 0; s < get_osi()->num_spaces(); s++) {
       for (int i = 0; i < sqops.size(); i++) {
         if ((sign_order[i] == -1) and (sqops[i].index().space() == s) and
             (sqops[i].type() == type)) {
@@ -289,11 +318,13 @@ WickTheorem::evaluate_contraction(const OperatorProduct &ops,
   PRINT(PrintLevel::Basic,
         print_contraction(ops, tensors, bit_map_vec, sqops, sign_order);)
 
-  int sign = unoccupied_sign * permutation_sign(sign_order);
+  int sign = unoccupied_sign * permutation_sign(sign_order.data(),
+                                                sign_order.size());
 
   PRINT(PrintLevel::All, PRINT_ELEMENTS(sign_order, "\n  positions: "););
 
-  std::vector<std::pair<int, SQOperator>> sorted_sqops;
+  arena_vector<std::pair<int, SQOperator>> sorted_sqops;
+  sorted_sqops.reserve(sqops.size());
   sorted_position = 0;
   for (const auto &sqop : sqops) {
     sorted_sqops.push_back(std::make_pair(sign_order[sorted_position], sqop));
@@ -334,14 +365,14 @@ WickTheorem::evaluate_contraction(const OperatorProduct &ops,
 }
 
 std::tuple<std::vector<Tensor>, std::vector<SQOperator>,
-           std::map<std::tuple<int, int, bool, int>, int>>
+           arena_map<std::tuple<int, int, bool, int>, int>>
 WickTheorem::contraction_tensors_sqops(const OperatorProduct &ops) {
 
   std::vector<SQOperator> sqops;
   std::vector<Tensor> tensors;
-  std::map<std::tuple<int, int, bool, int>, int> op_map;
+  arena_map<std::tuple<int, int, bool, int>, int> op_map;
 
-  index_counter ic(orbital_subspaces->num_spaces());
+  index_counter ic(get_osi()->num_spaces());
 
   // Loop over all operators
   int n = 0;
@@ -349,7 +380,7 @@ WickTheorem::contraction_tensors_sqops(const OperatorProduct &ops) {
     const auto &op = ops[o];
     // Loop over creation operators (lower indices)
     std::vector<Index> lower;
-    for (int s = 0; s < orbital_subspaces->num_spaces(); s++) {
+    for (int s = 0; s < get_osi()->num_spaces(); s++) {
       for (int c = 0; c < op.cre(s); c++) {
         Index idx(s, ic.next_index(s)); // get next available index
         sqops.push_back(SQOperator(SQOperatorType::Creation, idx));
@@ -365,7 +396,7 @@ WickTheorem::contraction_tensors_sqops(const OperatorProduct &ops) {
     // the annihilation operators are layed out in a reversed order (hence the
     // need to reverse the upper indices of the tensor, see below)
     std::vector<Index> upper;
-    for (int s = orbital_subspaces->num_spaces() - 1; s >= 0; s--) {
+    for (int s = get_osi()->num_spaces() - 1; s >= 0; s--) {
       for (int a = op.ann(s) - 1; a >= 0; a--) {
         Index idx(s, ic.next_index(s)); // get next available index
         sqops.push_back(SQOperator(SQOperatorType::Annihilation, idx));
@@ -385,12 +416,12 @@ WickTheorem::contraction_tensors_sqops(const OperatorProduct &ops) {
   return make_tuple(tensors, sqops, op_map);
 }
 
-std::vector<int> WickTheorem::elements_vec_to_pos(
+arena_vector<int> WickTheorem::elements_vec_to_pos(
     const ElementaryContraction &elements_vec,
-    std::vector<GraphMatrix> &ops_offset,
-    std::map<std::tuple<int, int, bool, int>, int> &op_map, bool creation) {
+    arena_vector<GraphMatrix> &ops_offset,
+    arena_map<std::tuple<int, int, bool, int>, int> &op_map, bool creation) {
 
-  std::vector<int> result;
+  arena_vector<int> result;
 
   int s = elements_vec.spaces_in_elementary_contraction()[0];
 
@@ -436,7 +467,8 @@ WickTheorem::combinatorial_factor(const OperatorProduct &ops,
   scalar_t factor = 1;
 
   // stores the offset for each uncontracted operator
-  std::vector<GraphMatrix> free_graph_matrix;
+  arena_vector<GraphMatrix> free_graph_matrix;
+  free_graph_matrix.reserve(ops.size());
   for (const auto &op : ops) {
     free_graph_matrix.push_back(op.graph_matrix());
   }
@@ -446,7 +478,7 @@ WickTheorem::combinatorial_factor(const OperatorProduct &ops,
   for (const auto &contraction : contractions) {
     for (int v = 0; v < contraction.size(); v++) {
       const auto &graph_matrix = contraction[v];
-      for (int s = 0; s < orbital_subspaces->num_spaces(); s++) {
+      for (int s = 0; s < get_osi()->num_spaces(); s++) {
         const auto &[kcre, kann] = graph_matrix.elements(s);
         const auto &[ncre, nann] = free_graph_matrix[v].elements(s);
         factor *= binomial(ncre, kcre);
@@ -458,7 +490,7 @@ WickTheorem::combinatorial_factor(const OperatorProduct &ops,
 
   // This last factor accounts for permutations of contractions with
   // multiplicity higher than one
-  std::map<ElementaryContraction, int> contraction_count;
+  arena_map<ElementaryContraction, int> contraction_count;
   for (const auto &contraction : contractions) {
     contraction_count[contraction] += 1;
   }
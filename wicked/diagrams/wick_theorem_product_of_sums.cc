@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <set>
+#include <tuple>
+
+#include "helpers/orbital_space.h"
+#include "helpers/trace.h"
+#include "operator.h"
+#include "operator_expression.h"
+#include "operator_product.h"
+
+#include "wick_theorem.h"
+
+// A product of sums of operators (e.g., (F + V)(T1 + T2)(T1 + T2)) is
+// contracted by visiting the tree of its products depth first: level k of
+// the tree picks a component of factors[k], so the products that share a
+// prefix share the path to it. Every elementary contraction removes as many
+// creation as annihilation operators from a space, so a product whose
+// creation minus annihilation count in space s is d_s leaves at least
+// sum_s |d_s| operators uncontracted (operators in composite spaces can each
+// lower this bound by one). For each level the set of count vectors that
+// the remaining factors can add is computed once, and a prefix is dropped
+// when no completion brings the bound below maxrank, or when it cannot have
+// minrank operators. The products that are left are brought to canonical
+// form by sorting the operators that commute, so products that differ only
+// by their order (e.g., T1 T2 and T2 T1) are contracted once.
+
+namespace {
+/// The counts of the operators of a component of a factor, or of a product of
+/// components
+struct product_counts {
+  /// creation minus annihilation operators in each elementary space
+  std::vector<int> imbalance;
+  /// the number of operators in composite spaces
+  int flexible = 0;
+  /// the number of operators
+  int nops = 0;
+
+  bool operator<(const product_counts &other) const {
+    return std::tie(imbalance, flexible, nops) <
+           std::tie(other.imbalance, other.flexible, other.nops);
+  }
+};
+
+product_counts operator+(const product_counts &a, const product_counts &b) {
+  product_counts result(a);
+  for (size_t s = 0; s < result.imbalance.size(); s++) {
+    result.imbalance[s] += b.imbalance[s];
+  }
+  result.flexible += b.flexible;
+  result.nops += b.nops;
+  return result;
+}
+
+product_counts count_operators(const OperatorProduct &prod, int nspaces) {
+  product_counts result;
+  result.imbalance.assign(nspaces, 0);
+  for (const auto &op : prod) {
+    for (int s = 0; s < nspaces; s++) {
+      result.imbalance[s] += op.cre(s) - op.ann(s);
+    }
+    result.flexible += op.composite_graph_matrix().num_ops();
+    result.nops += op.num_ops();
+  }
+  return result;
+}
+
+/// Can a product with these counts have contractions with a rank in
+/// [minrank, maxrank]?
+bool can_contract(const product_counts &counts, int minrank, int maxrank) {
+  if (counts.nops < minrank) {
+    return false;
+  }
+  int n = 0;
+  for (int d : counts.imbalance) {
+    n += std::abs(d);
+  }
+  return n - counts.flexible <= maxrank;
+}
+} // namespace
+
+Expression
+WickTheorem::contract(scalar_t factor,
+                      const std::vector<OperatorExpression> &factors,
+                      const int minrank, const int maxrank) {
+  osi_scope scope(osi_);
+  trace_span span("contract product of sums");
+  span.arg("factors", std::to_string(factors.size()));
+  const int nspaces = get_osi()->num_spaces();
+  const int nfactors = factors.size();
+
+  // the counts of the components of each factor
+  std::vector<std::vector<product_counts>> component_counts(nfactors);
+  for (int k = 0; k < nfactors; k++) {
+    for (const auto &[prod, f] : factors[k].terms()) {
+      component_counts[k].push_back(count_operators(prod, nspaces));
+    }
+  }
+
+  // suffix[k] holds the distinct counts of the products of components of
+  // factors[k], ..., factors[nfactors - 1]
+  std::vector<std::set<product_counts>> suffix(nfactors + 1);
+  suffix[nfactors].insert(count_operators(OperatorProduct(), nspaces));
+  for (int k = nfactors - 1; k >= 0; k--) {
+    for (const auto &counts : component_counts[k]) {
+      for (const auto &rest : suffix[k + 1]) {
+        suffix[k].insert(counts + rest);
+      }
+    }
+  }
+
+  // the distinct products, with the operators that commute sorted
+  OperatorExpression products;
+  std::vector<Operator> ops;
+  std::function<void(int, scalar_t, const product_counts &)> visit =
+      [&](int k, scalar_t coefficient, const product_counts &prefix) {
+        const bool viable = std::any_of(
+            suffix[k].begin(), suffix[k].end(), [&](const auto &rest) {
+              return can_contract(prefix + rest, minrank, maxrank);
+            });
+        if (not viable) {
+          return;
+        }
+        if (k == nfactors) {
+          OperatorProduct prod(ops);
+          const scalar_t sign = prod.canonicalize();
+          products.add(prod, sign * coefficient);
+          return;
+        }
+        int n = 0;
+        for (const auto &[prod, f] : factors[k].terms()) {
+          for (const auto &op : prod) {
+            ops.push_back(op);
+          }
+          visit(k + 1, coefficient * f, prefix + component_counts[k][n]);
+          ops.erase(ops.end() - prod.size(), ops.end());
+          n++;
+        }
+      };
+  visit(0, scalar_t(1), count_operators(OperatorProduct(), nspaces));
+  span.arg("products", std::to_string(products.size()));
+  return contract(factor, products, minrank, maxrank);
+}
@@ -1,76 +1,141 @@
 #ifndef _wicked_vector_space_h_
 #define _wicked_vector_space_h_
 
+#include <atomic>
+#include <map>
+#include <memory>
 #include <vector>
 
 #include "helpers/helpers.h"
 
 /// Represents a vector space of objects of type T over the field F
+///
+/// The terms are stored in a map that is shared by copies of an object and is
+/// copied only when one of them is modified (copy-on-write), so copying an
+/// object is O(1). Modifying functions must access the terms via
+/// mutable_terms(). Iterators obtained from mutable_terms() are invalidated
+/// if the object is copied and then modified again.
+///
+/// Copies that share their terms may be used (and destroyed) by different
+/// threads. A single object must not be modified by a thread while another
+/// thread reads or modifies it.
 template <class T, class F> class Algebra {
 
 public:
   using vecspace_t = std::map<T, F>;
   Algebra() {}
-  Algebra(const vecspace_t &v) : terms_(v) {}
+  Algebra(const vecspace_t &v) : terms_(std::make_shared<vecspace_t>(v)) {}
 
   /// size of
-  size_t size() const { return terms_.size(); }
-  const vecspace_t &terms() const { return terms_; }
-  vecspace_t &terms() { return terms_; }
+  size_t size() const { return const_terms().size(); }
+  const vecspace_t &terms() const { return const_terms(); }
+  vecspace_t &terms() { return mutable_terms(); }
 
   /// add an element
-  void add(const T &e, F c = scalar_t(1, 1)) { add_to_map(terms_, e, c); }
+  void add(const T &e, F c = scalar_t(1, 1)) {
+    add_to_map(mutable_terms(), e, c);
+  }
 
   /// comparison
-  bool is_equal(const Algebra &rhs) const { return terms_ == rhs.terms_; }
+  bool is_equal(const Algebra &rhs) const {
+    return (terms_ == rhs.terms_) or (const_terms() == rhs.const_terms());
+  }
 
   /// addition assignment
   Algebra &operator+=(const Algebra &rhs) {
-    for (const auto &[e, c] : rhs.terms()) {
-      add(e, c);
+    if (this == &rhs) {
+      return *this *= scalar_t(2);
+    }
+    if (size() == 0) {
+      // share the terms of rhs
+      terms_ = rhs.terms_;
+      return *this;
+    }
+    auto &terms = mutable_terms();
+    for (const auto &[e, c] : rhs.const_terms()) {
+      add_to_map(terms, e, c);
     }
     return *this;
   }
   /// subtraction assignment
   Algebra &operator-=(const Algebra &rhs) {
-    for (const auto &[e, c] : rhs.terms()) {
-      add(e, -c);
+    if (this == &rhs) {
+      terms_.reset();
+      return *this;
+    }
+    auto &terms = mutable_terms();
+    for (const auto &[e, c] : rhs.const_terms()) {
+      add_to_map(terms, e, -c);
     }
     return *this;
   }
   /// multiplication assignment (scalar)
   Algebra &operator*=(const Algebra &rhs) {
     Algebra result;
-    for (const auto &[e, c] : terms()) {
-      for (const auto &[er, cr] : rhs.terms()) {
-        result.add(e * er, c * cr);
+    auto &result_terms = result.mutable_terms();
+    for (const auto &[e, c] : const_terms()) {
+      for (const auto &[er, cr] : rhs.const_terms()) {
+        add_to_map(result_terms, e * er, c * cr);
       }
     }
-    terms_ = result.terms_;
+    terms_ = std::move(result.terms_);
     return *this;
   }
   /// multiplication assignment (scalar)
   Algebra &operator*=(scalar_t factor) {
-    for (auto &[e, c] : terms()) {
+    for (auto &[e, c] : mutable_terms()) {
       c *= factor;
     }
     return *this;
   }
   /// division assignment (scalar)
   Algebra &operator/=(scalar_t factor) {
-    for (auto &[e, c] : terms()) {
+    for (auto &[e, c] : mutable_terms()) {
       c /= factor;
     }
     return *this;
   }
 
-  typename vecspace_t::iterator begin() { return terms_.begin(); }
-  typename vecspace_t::const_iterator begin() const { return terms_.begin(); }
-  typename vecspace_t::iterator end() { return terms_.end(); }
-  typename vecspace_t::const_iterator end() const { return terms_.end(); }
+  typename vecspace_t::iterator begin() { return mutable_terms().begin(); }
+  typename vecspace_t::const_iterator begin() const {
+    return const_terms().begin();
+  }
+  typename vecspace_t::iterator end() { return mutable_terms().end(); }
+  typename vecspace_t::const_iterator end() const {
+    return const_terms().end();
+  }
 
 protected:
-  vecspace_t terms_;
+  /// Return the terms for reading
+  const vecspace_t &const_terms() const {
+    static const vecspace_t empty;
+    return terms_ ? *terms_ : empty;
+  }
+
+  /// Return the terms for writing. The terms are copied first if they are
+  /// shared with another object
+  vecspace_t &mutable_terms() {
+    if (not terms_) {
+      terms_ = std::make_shared<vecspace_t>();
+    } else if (terms_.use_count() > 1) {
+      terms_ = std::make_shared<vecspace_t>(*terms_);
+    } else {
+      // use_count() is a relaxed read. If another thread just destroyed the
+      // last copy, its accesses to the terms must happen before ours
+      std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    return *terms_;
+  }
+
+  /// Replace the terms
+  void set_terms(vecspace_t &&terms) {
+    terms_ = std::make_shared<vecspace_t>(std::move(terms));
+  }
+
+private:
+  /// the terms (null if there are no terms). This pointer may be shared by
+  /// several objects
+  std::shared_ptr<vecspace_t> terms_;
 };
 
 #endif // _wicked_vector_space_h_
\ No newline at end of file
@@ -0,0 +1,163 @@
+#ifndef _wicked_arena_h_
+#define _wicked_arena_h_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief A resettable monotonic arena for short-lived temporaries
+ *
+ * Memory is handed out by bumping a pointer inside large blocks and is never
+ * returned individually. A position in the arena can be saved with mark() and
+ * restored with rewind(), which releases everything allocated after the mark
+ * in one step. Blocks are kept after a rewind, so once the arena has grown to
+ * the size required by a contraction no further calls to malloc/free are made.
+ *
+ * Each thread owns one arena (see thread_arena()). Containers that draw from
+ * it must be destroyed before the scope that owns their memory is rewound and
+ * must not grow while a nested scope is active.
+ */
+class arena {
+public:
+  /// A position in the arena
+  struct marker {
+    size_t block;
+    size_t offset;
+  };
+
+  /// constructor. No memory is allocated until the first request
+  explicit arena(size_t block_size = 1 << 16) : block_size_(block_size) {}
+
+  arena(const arena &) = delete;
+  arena &operator=(const arena &) = delete;
+
+  /// allocate a chunk of memory with a given alignment
+  void *allocate(size_t bytes, size_t alignment) {
+    while (current_ < blocks_.size()) {
+      if (void *p = try_allocate(blocks_[current_], bytes, alignment)) {
+        return p;
+      }
+      // this block is exhausted, move on to the next one
+      current_ += 1;
+      offset_ = 0;
+    }
+    // no block can satisfy this request, add a new one
+    const size_t size = std::max(block_size_, bytes + alignment);
+    blocks_.push_back({std::make_unique<char[]>(size), size});
+    current_ = blocks_.size() - 1;
+    offset_ = 0;
+    return try_allocate(blocks_[current_], bytes, alignment);
+  }
+
+  /// return the current position in the arena
+  marker mark() const { return {current_, offset_}; }
+
+  /// release all the memory allocated after the marker m
+  void rewind(const marker &m) {
+    current_ = m.block;
+    offset_ = m.offset;
+  }
+
+  /// release all the memory allocated by this arena (blocks are retained)
+  void reset() { rewind({0, 0}); }
+
+  /// return the total size of the blocks owned by this arena
+  size_t capacity() const {
+    size_t result = 0;
+    for (const auto &b : blocks_) {
+      result += b.size;
+    }
+    return result;
+  }
+
+private:
+  struct block {
+    std::unique_ptr<char[]> data;
+    size_t size;
+  };
+
+  void *try_allocate(block &b, size_t bytes, size_t alignment) {
+    const auto base = reinterpret_cast<std::uintptr_t>(b.data.get());
+    const auto start = (base + offset_ + alignment - 1) & ~(alignment - 1);
+    const size_t end = start - base + bytes;
+    if (end > b.size) {
+      return nullptr;
+    }
+    offset_ = end;
+    return reinterpret_cast<void *>(start);
+  }
+
+  /// the default size of a block
+  size_t block_size_;
+  /// the blocks owned by this arena
+  std::vector<block> blocks_;
+  /// the block currently used
+  size_t current_ = 0;
+  /// the first free byte in the current block
+  size_t offset_ = 0;
+};
+
+/// Return the arena owned by the calling thread
+inline arena &thread_arena() {
+  thread_local arena a;
+  return a;
+}
+
+/**
+ * @brief Saves the position of the thread arena and rewinds it on exit
+ *
+ * Create an arena_scope before declaring arena containers. The containers are
+ * destroyed first and then the memory is released in one step.
+ */
+class arena_scope {
+public:
+  arena_scope() : marker_(thread_arena().mark()) {}
+  ~arena_scope() { thread_arena().rewind(marker_); }
+
+  arena_scope(const arena_scope &) = delete;
+  arena_scope &operator=(const arena_scope &) = delete;
+
+private:
+  arena::marker marker_;
+};
+
+/// A stateless allocator that draws from the thread arena
+template <class T> class arena_allocator {
+public:
+  using value_type = T;
+
+  arena_allocator() noexcept {}
+  template <class U> arena_allocator(const arena_allocator<U> &) noexcept {}
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(
+        thread_arena().allocate(n * sizeof(T), alignof(T)));
+  }
+
+  /// memory is released by rewinding the arena
+  void deallocate(T *, size_t) noexcept {}
+};
+
+template <class T, class U>
+bool operator==(const arena_allocator<T> &, const arena_allocator<U> &) {
+  return true;
+}
+
+template <class T, class U>
+bool operator!=(const arena_allocator<T> &, const arena_allocator<U> &) {
+  return false;
+}
+
+/// A vector allocated from the thread arena
+template <class T> using arena_vector = std::vector<T, arena_allocator<T>>;
+
+/// A map allocated from the thread arena
+template <class K, class V>
+using arena_map =
+    std::map<K, V, std::less<K>, arena_allocator<std::pair<const K, V>>>;
+
+#endif // _wicked_arena_h_
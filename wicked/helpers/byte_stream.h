@@ -0,0 +1,230 @@
+#ifndef _wicked_byte_stream_h_
+#define _wicked_byte_stream_h_
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "orbital_space.h"
+
+/**
+ * @brief Writers and readers of the binary format used to serialize objects
+ *
+ * A serialized object has the layout
+ *
+ *   magic    the three bytes "wkd"
+ *   version  one byte (byte_stream_version)
+ *   type     one byte that identifies the type of the object
+ *   spaces   a varint n followed by the n labels of the orbital spaces
+ *   labels   a varint n followed by n strings (a varint length + the bytes)
+ *   payload  the object
+ *
+ * Unsigned integers are stored as LEB128 varints. Labels (of tensors and
+ * operators) are stored once in the label table and referred to by their
+ * position. Indices refer to orbital spaces by their position in the space
+ * table, and are mapped to the spaces with the same label when they are read,
+ * so an object can be read by any process that defines the spaces it uses.
+ */
+
+/// The version of the binary format (2: rationals are zig-zag encoded)
+constexpr uint8_t byte_stream_version = 2;
+
+/// Writes the binary representation of an object
+class byte_writer {
+public:
+  /// Start writing an object of a given type
+  explicit byte_writer(char type)
+      : type_(type), nspaces_(get_osi()->num_spaces()) {}
+
+  /// Write a byte
+  void byte(uint8_t b) { payload_.push_back(static_cast<char>(b)); }
+
+  /// Write an unsigned integer as a varint
+  void varint(uint64_t n) {
+    while (n >= 0x80) {
+      byte(static_cast<uint8_t>(n) | 0x80);
+      n >>= 7;
+    }
+    byte(static_cast<uint8_t>(n));
+  }
+
+  /// Write a label (stored once in the label table)
+  void label(const std::string &s) {
+    auto [it, inserted] = label_ids_.try_emplace(s, labels_.size());
+    if (inserted) {
+      labels_.push_back(s);
+    }
+    varint(it->second);
+  }
+
+  /// Write an orbital space
+  void space(int s) { varint(s); }
+
+  /// Return the number of orbital spaces in the space table
+  int num_spaces() const { return nspaces_; }
+
+  /// Return the serialized object
+  std::string str() const {
+    const auto osi = get_osi();
+    byte_writer header(type_);
+    header.payload_ = "wkd";
+    header.byte(byte_stream_version);
+    header.byte(static_cast<uint8_t>(type_));
+    header.varint(osi->num_spaces());
+    for (int s = 0; s < osi->num_spaces(); s++) {
+      header.byte(static_cast<uint8_t>(osi->label(s)));
+    }
+    header.varint(labels_.size());
+    for (const auto &l : labels_) {
+      header.varint(l.size());
+      header.payload_ += l;
+    }
+    return header.payload_ + payload_;
+  }
+
+private:
+  char type_;
+  int nspaces_;
+  std::string payload_;
+  std::vector<std::string> labels_;
+  std::unordered_map<std::string, size_t> label_ids_;
+};
+
+/// Reads the binary representation of an object
+class byte_reader {
+public:
+  /// Start reading an object of a given type. Throws if the header is not
+  /// valid
+  byte_reader(const std::string &bytes, char type)
+      : data_(reinterpret_cast<const uint8_t *>(bytes.data())),
+        end_(data_ + bytes.size()) {
+    if ((bytes.size() < 5) or (bytes.compare(0, 3, "wkd") != 0)) {
+      error("the data is not a serialized wicked object");
+    }
+    data_ += 3;
+    if (byte() != byte_stream_version) {
+      error("unsupported version of the binary format");
+    }
+    if (byte() != static_cast<uint8_t>(type)) {
+      error("the data is a serialized object of another type");
+    }
+    const auto osi = get_osi();
+    spaces_.resize(count());
+    for (auto &s : spaces_) {
+      const char label = static_cast<char>(byte());
+      s = -1;
+      for (int t = 0; t < osi->num_spaces(); t++) {
+        if (osi->label(t) == label) {
+          s = t;
+        }
+      }
+      space_labels_.push_back(label);
+    }
+    labels_.resize(count());
+    for (auto &l : labels_) {
+      const size_t n = varint();
+      check(n);
+      l.assign(reinterpret_cast<const char *>(data_), n);
+      data_ += n;
+    }
+  }
+
+  /// Read a byte
+  uint8_t byte() {
+    check(1);
+    return *data_++;
+  }
+
+  /// Read a varint
+  uint64_t varint() {
+    uint64_t n = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      const uint8_t b = byte();
+      if ((shift == 63) and ((b & 0x7f) > 1)) {
+        error("invalid varint");
+      }
+      n |= static_cast<uint64_t>(b & 0x7f) << shift;
+      if ((b & 0x80) == 0) {
+        return n;
+      }
+    }
+    error("invalid varint");
+    return 0;
+  }
+
+  /// Read the length of a sequence whose elements take at least one byte
+  size_t count() {
+    const uint64_t n = varint();
+    if (n > static_cast<uint64_t>(end_ - data_)) {
+      error("the data is truncated");
+    }
+    return n;
+  }
+
+  /// Read a label
+  const std::string &label() {
+    const uint64_t id = varint();
+    if (id >= labels_.size()) {
+      error("invalid label");
+    }
+    return labels_[id];
+  }
+
+  /// Read an orbital space and map it to the current orbital spaces
+  int space() { return map_space(varint()); }
+
+  /// Map an orbital space of the space table to the current orbital spaces
+  int map_space(uint64_t s) const {
+    if (s >= spaces_.size()) {
+      error("invalid orbital space");
+    }
+    if (spaces_[s] < 0) {
+      error(std::string("the orbital space '") + space_labels_[s] +
+            "' is not defined");
+    }
+    return spaces_[s];
+  }
+
+  /// Return the number of spaces in the space table
+  int num_spaces() const { return static_cast<int>(spaces_.size()); }
+
+  /// Return true if every space of the space table maps to the space with
+  /// the same position (so objects keep the order they were written in)
+  bool spaces_in_order() const {
+    for (size_t s = 0; s < spaces_.size(); s++) {
+      if (spaces_[s] != static_cast<int>(s)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// Check that all the data was read
+  void finish() const {
+    if (data_ != end_) {
+      error("unexpected data at the end");
+    }
+  }
+
+  /// Throw an exception
+  [[noreturn]] void error(const std::string &msg) const {
+    throw std::runtime_error("Cannot read the serialized object: " + msg);
+  }
+
+private:
+  void check(size_t n) const {
+    if (static_cast<size_t>(end_ - data_) < n) {
+      error("the data is truncated");
+    }
+  }
+
+  const uint8_t *data_;
+  const uint8_t *end_;
+  std::vector<int> spaces_;
+  std::vector<char> space_labels_;
+  std::vector<std::string> labels_;
+};
+
+#endif // _wicked_byte_stream_h_
@@ -25,13 +25,16 @@ long long int binomial(int n, int k) {
 }
 
 int permutation_sign(const std::vector<int> &vec) {
+  return permutation_sign(vec.data(), vec.size());
+}
+
+int permutation_sign(const int *perm, int n) {
   /// A quadratic algorithm to compute the sign of a permutation
   /// http://math.stackexchange.com/questions/65923/how-does-one-compute-the-sign-of-a-permutation
   int sign = 0;
-  int n = vec.size();
   for (int i = 0; i < n; i++) {
     for (int j = i + 1; j < n; ++j) {
-      if (vec[i] > vec[j]) {
+      if (perm[i] > perm[j]) {
         sign += 1;
       }
     }
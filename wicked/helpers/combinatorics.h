@@ -17,4 +17,7 @@ std::vector<std::vector<int>> integer_partitions(int n, int maxlen = 1024);
 // Computes the sign of a permutation of integers
 int permutation_sign(const std::vector<int> &vec);
 
+// Computes the sign of a permutation of n integers stored in perm
+int permutation_sign(const int *perm, int n);
+
 #endif // _wicked_combinatorics_h_
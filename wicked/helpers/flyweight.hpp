@@ -0,0 +1,111 @@
+#ifndef _wicked_flyweight_h_
+#define _wicked_flyweight_h_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+/**
+ * @brief A thread-safe pool of immutable objects addressed by a 32-bit id
+ *
+ * Equal objects are stored only once. intern() returns the id of an object,
+ * adding it to the pool if necessary, and get() returns a reference to the
+ * stored object. Objects are kept in fixed-size chunks that are never moved,
+ * so references returned by get() stay valid for the lifetime of the pool and
+ * can be read without locking. Objects are removed only by clear(), which
+ * invalidates every id and reference handed out by the pool.
+ *
+ * @tparam T the type of the objects stored
+ * @tparam Hash a hash function for T
+ * @tparam Equal an equality predicate for T consistent with Hash
+ */
+template <class T, class Hash, class Equal> class flyweight_pool {
+public:
+  using id_t = uint32_t;
+
+  flyweight_pool() : chunks_(new std::atomic<T *>[max_chunks_]) {
+    for (size_t c = 0; c < max_chunks_; c++) {
+      chunks_[c].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  ~flyweight_pool() {
+    for (size_t c = 0; c < max_chunks_; c++) {
+      delete[] chunks_[c].load(std::memory_order_relaxed);
+    }
+  }
+
+  flyweight_pool(const flyweight_pool &) = delete;
+  flyweight_pool &operator=(const flyweight_pool &) = delete;
+
+  /// return the id of an object, adding it to the pool if it is not present
+  id_t intern(const T &obj) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto search = ids_.find(std::cref(obj));
+    if (search != ids_.end()) {
+      return search->second;
+    }
+    const size_t id = size_.load(std::memory_order_relaxed);
+    const size_t c = id >> chunk_bits_;
+    if (c >= max_chunks_) {
+      throw std::runtime_error("flyweight_pool: too many distinct objects");
+    }
+    T *chunk = chunks_[c].load(std::memory_order_relaxed);
+    if (chunk == nullptr) {
+      chunk = new T[chunk_size_];
+      chunks_[c].store(chunk, std::memory_order_release);
+    }
+    T &stored = chunk[id & (chunk_size_ - 1)];
+    stored = obj;
+    ids_.emplace(std::cref(stored), static_cast<id_t>(id));
+    size_.store(id + 1, std::memory_order_release);
+    return static_cast<id_t>(id);
+  }
+
+  /// return a reference to the object with a given id
+  const T &get(id_t id) const {
+    const T *chunk = chunks_[id >> chunk_bits_].load(std::memory_order_acquire);
+    return chunk[id & (chunk_size_ - 1)];
+  }
+
+  /// return the mutex that guards intern()
+  std::mutex &mutex() { return mutex_; }
+
+  /// remove all the objects. The caller must hold mutex() and ensure that no
+  /// id or reference obtained from the pool is used afterwards
+  void clear() {
+    ids_.clear();
+    for (size_t c = 0; c < max_chunks_; c++) {
+      delete[] chunks_[c].exchange(nullptr, std::memory_order_relaxed);
+    }
+    size_.store(0, std::memory_order_release);
+  }
+
+  /// return the number of distinct objects stored
+  size_t size() const { return size_.load(std::memory_order_acquire); }
+
+private:
+  static constexpr size_t chunk_bits_ = 10;
+  static constexpr size_t chunk_size_ = size_t(1) << chunk_bits_;
+  static constexpr size_t max_chunks_ = size_t(1) << 16;
+
+  /// pointers to the chunks that store the objects
+  std::unique_ptr<std::atomic<T *>[]> chunks_;
+  /// the number of objects stored
+  std::atomic<size_t> size_{0};
+  /// maps an object stored in a chunk to its id
+  std::unordered_map<std::reference_wrapper<const T>, id_t, Hash, Equal> ids_;
+  /// guards intern()
+  std::mutex mutex_;
+};
+
+/// Combine a hash value into a seed (as in boost::hash_combine)
+inline void hash_combine(size_t &seed, size_t value) {
+  seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+}
+
+#endif // _wicked_flyweight_h_
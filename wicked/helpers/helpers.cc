@@ -1,11 +1,11 @@
 #include <iostream>
 #include <iterator>
+#include <regex>
 #include <sstream>
+#include <unordered_map>
 
 #include "helpers.h"
 
-using std::regex;
-using std::sregex_token_iterator;
 using std::string;
 
 std::string join(const std::vector<std::string> &strvec,
@@ -42,32 +42,41 @@ inline std::string &rtrim(std::string &s) {
 // trim from both ends
 inline std::string &trim(std::string &s) { return ltrim(rtrim(s)); }
 
-std::vector<std::string> split(const std::string &s, regex re) {
-  sregex_token_iterator it(s.begin(), s.end(), re, -1);
-  sregex_token_iterator reg_end;
-
+std::vector<std::string> split(const std::string &s,
+                               const std::string &delimiters) {
   std::vector<std::string> result;
-  for (; it != reg_end; ++it) {
-    result.push_back(it->str());
+  size_t end = 0;
+  while (true) {
+    const size_t begin = s.find_first_not_of(delimiters, end);
+    if (begin == std::string::npos) {
+      break;
+    }
+    end = s.find_first_of(delimiters, begin);
+    result.push_back(s.substr(begin, end - begin));
   }
   return result;
 }
 
 std::vector<std::string> findall(const string &s, const string &regex) {
+  // compiling a regular expression is expensive, so each thread keeps those
+  // it has used
+  thread_local std::unordered_map<std::string, std::regex> cache;
+  auto it = cache.find(regex);
+  if (it == cache.end()) {
+    it = cache.emplace(regex, std::regex(regex)).first;
+  }
   std::vector<std::string> result;
-  std::regex this_regex(regex);
   try {
-    std::sregex_iterator next(s.begin(), s.end(), this_regex);
+    std::sregex_iterator next(s.begin(), s.end(), it->second);
     std::sregex_iterator end;
-    std::vector<std::string> matches;
     for (; next != end; ++next) {
-      std::smatch match = *next;
+      const std::smatch &match = *next;
       for (size_t k = 1; k < match.size(); ++k) {
         result.push_back(match[k]);
       }
     }
   } catch (std::regex_error &e) {
-    // Syntax error in the regular expression
+    // the matching exceeded the limits of std::regex
   }
   return result;
 }
@@ -84,3 +93,11 @@ std::vector<std::string> split_indices(const std::string &idx) {
 
   return v;
 }
+
+uint64_t hash_string(const std::string &s) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : s) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+  }
+  return hash;
+}
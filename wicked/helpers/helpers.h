@@ -1,10 +1,10 @@
 #ifndef _wicked_helpers_h_
 #define _wicked_helpers_h_
 
+#include <cstdint>
 #include <iostream>
 #include <map>
 #include <numeric>
-#include <regex>
 #include <string>
 #include <vector>
 
@@ -14,17 +14,23 @@
 std::string join(const std::vector<std::string> &svec,
                  const std::string &sep = ",");
 
-/// Split a string.  Default delimiters are spaces (\s) and/or commas
+/// Split a string at the runs of the characters in delimiters (by default
+/// spaces and commas). Empty parts are not returned
 std::vector<std::string> split(const std::string &s,
-                               std::regex re = std::regex("[\\s,]+"));
+                               const std::string &delimiters = " \t\n\r\f\v,");
 
-/// Find all occurences of a pattern
+/// Find all occurences of a pattern (a regular expression) and return the
+/// groups of each match
 std::vector<std::string> findall(const std::string &s,
                                  const std::string &regex);
 
 /// Split indices
 std::vector<std::string> split_indices(const std::string &s);
 
+/// Return the 64-bit FNV-1a hash of a string. Unlike std::hash, the result is
+/// the same in all builds, so it may be stored or compared across processes
+uint64_t hash_string(const std::string &s);
+
 template <class T> std::vector<T> iota_vector(size_t size, T value = T(0)) {
   std::vector<T> v(size);
   std::iota(v.begin(), v.end(), value);
@@ -1,20 +1,45 @@
+#include <algorithm>
 #include <iostream>
 
 #include "helpers.h"
 #include "orbital_space.h"
 
-std::shared_ptr<OrbitalSpaceInfo> orbital_subspaces =
-    std::make_shared<OrbitalSpaceInfo>();
+namespace {
+/// the orbital space information used by the calling thread
+std::shared_ptr<OrbitalSpaceInfo> &thread_osi() {
+  thread_local std::shared_ptr<OrbitalSpaceInfo> osi = default_osi();
+  return osi;
+}
+} // namespace
+
+const std::shared_ptr<OrbitalSpaceInfo> &default_osi() {
+  static const std::shared_ptr<OrbitalSpaceInfo> osi =
+      std::make_shared<OrbitalSpaceInfo>();
+  return osi;
+}
+
+const std::shared_ptr<OrbitalSpaceInfo> &get_osi() { return thread_osi(); }
+
+void set_osi(std::shared_ptr<OrbitalSpaceInfo> osi) {
+  thread_osi() = osi ? std::move(osi) : default_osi();
+}
+
+osi_scope::osi_scope(std::shared_ptr<OrbitalSpaceInfo> osi)
+    : previous_(thread_osi()) {
+  if (osi) {
+    thread_osi() = std::move(osi);
+  }
+}
 
-std::shared_ptr<OrbitalSpaceInfo> get_osi() { return orbital_subspaces; }
+osi_scope::~osi_scope() { thread_osi() = std::move(previous_); }
 
-std::map<FieldType, std::string> FieldType_to_str{
+const std::map<FieldType, std::string> FieldType_to_str{
     {FieldType::Fermion, "fermion"}, {FieldType::Boson, "boson"}};
 
-std::map<FieldType, std::string> FieldType_to_op_symbol{
+const std::map<FieldType, std::string> FieldType_to_op_symbol{
     {FieldType::Fermion, "a"}, {FieldType::Boson, "b"}};
 
-std::map<SpaceType, std::string> SpaceType_to_str{
+const std::map<SpaceType, std::string> SpaceType_to_str{
     {SpaceType::Occupied, "occupied"},
     {SpaceType::Unoccupied, "unoccupied"},
     {SpaceType::General, "general"},
@@ -75,7 +100,7 @@ void OrbitalSpaceInfo::add_space(char label, FieldType field_type,
                                  SpaceType space_type,
                                  const std::vector<std::string> &indices,
                                  const std::vector<char> &elementary_spaces) {
-  if (label_to_pos_.count(label) != 0) {
+  if ((label_to_pos_.count(label) != 0) or is_composite_space(label)) {
     throw std::runtime_error("add_space: Orbitals space label \"" +
                              std::string(1, label) +
                              "\" is already defined. Use another label.");
@@ -100,14 +125,79 @@ void OrbitalSpaceInfo::add_space(char label, FieldType field_type,
                                      elementary_spaces_int));
 }
 
+void OrbitalSpaceInfo::add_composite_space(
+    char label, const std::vector<char> &elementary_spaces) {
+  if ((label_to_pos_.count(label) != 0) or is_composite_space(label)) {
+    throw std::runtime_error("add_composite_space: Orbitals space label \"" +
+                             std::string(1, label) +
+                             "\" is already defined. Use another label.");
+  }
+  if (num_composite_spaces() == max_composite_spaces) {
+    throw std::runtime_error("add_composite_space: at most " +
+                             std::to_string(max_composite_spaces) +
+                             " composite spaces can be defined.");
+  }
+  if (elementary_spaces.empty()) {
+    throw std::runtime_error("add_composite_space: the composite space \"" +
+                             std::string(1, label) +
+                             "\" must contain at least one space.");
+  }
+  std::vector<int> elements;
+  for (char e : elementary_spaces) {
+    elements.push_back(label_to_space(e));
+  }
+  std::sort(elements.begin(), elements.end());
+  elements.erase(std::unique(elements.begin(), elements.end()), elements.end());
+  const FieldType field_type = space_info_[elements.front()].field_type();
+  for (int e : elements) {
+    if (space_info_[e].field_type() != field_type) {
+      throw std::runtime_error(
+          "add_composite_space: the spaces of the composite space \"" +
+          std::string(1, label) + "\" must have the same field type.");
+    }
+  }
+  composite_label_to_pos_[label] = composite_space_info_.size();
+  composite_space_info_.push_back(
+      OrbitalSpace(label, field_type, SpaceType::General, {}, elements));
+}
+
+char OrbitalSpaceInfo::composite_label(int pos) const {
+  return composite_space_info_[pos].label();
+}
+
+const std::vector<int> &OrbitalSpaceInfo::composite_elements(int pos) const {
+  return composite_space_info_[pos].elementary_spaces();
+}
+
+bool OrbitalSpaceInfo::is_composite_space(char label) const {
+  return composite_label_to_pos_.count(label) != 0;
+}
+
+int OrbitalSpaceInfo::label_to_composite_space(char label) const {
+  auto search = composite_label_to_pos_.find(label);
+  if (search == composite_label_to_pos_.end()) {
+    throw std::runtime_error("\n  Could not find the composite space label :'" +
+                             std::string(1, label) + "' in OrbitalSpaceInfo.");
+  }
+  return search->second;
+}
+
 std::string OrbitalSpaceInfo::str() const {
   std::vector<std::string> s;
   for (const auto &info : space_info_) {
     s.push_back("space label: " + std::string(1, info.label()) +
-                "\nfield type: " + FieldType_to_str[info.field_type()] +
-                "\nspace type: " + SpaceType_to_str[info.space_type()] +
+                "\nfield type: " + FieldType_to_str.at(info.field_type()) +
+                "\nspace type: " + SpaceType_to_str.at(info.space_type()) +
                 "\nindices: [" + join(info.indices(), ",") + "]");
   }
+  for (const auto &info : composite_space_info_) {
+    std::string elements;
+    for (int e : info.elementary_spaces()) {
+      elements += label(e);
+    }
+    s.push_back("space label: " + std::string(1, info.label()) +
+                "\ncomposite of: " + elements);
+  }
   return join(s, "\n\n");
 }
 
@@ -142,7 +232,7 @@ FieldType OrbitalSpaceInfo::field_type(int pos) const {
 }
 
 const std::string &OrbitalSpaceInfo::op_symbol(int pos) const {
-  return FieldType_to_op_symbol[field_type(pos)];
+  return FieldType_to_op_symbol.at(field_type(pos));
 }
 
 const std::vector<std::string> &OrbitalSpaceInfo::indices(int pos) const {
@@ -164,6 +254,8 @@ void OrbitalSpaceInfo::reset() {
   space_info_.clear();
   label_to_pos_.clear();
   indices_to_pos_.clear();
+  composite_space_info_.clear();
+  composite_label_to_pos_.clear();
 }
 
 // void OrbitalSpaceInfo::default_spaces() {
@@ -40,6 +40,10 @@ public:
 
 class OrbitalSpaceInfo {
 public:
+  /// The largest number of composite spaces (their operator counts are stored
+  /// in a GraphMatrix)
+  static constexpr int max_composite_spaces = 8;
+
   OrbitalSpaceInfo();
 
   /// Set default spaces
@@ -50,12 +54,31 @@ public:
                  const std::vector<std::string> &indices,
                  const std::vector<char> &elementary_spaces = {});
 
-  // /// Add a composite space
-  // void add_composite_space(char label,
-  //                          const std::vector<char> &elementary_spaces);
+  /// Add a composite space, the union of elementary spaces. An operator
+  /// component in a composite space stands for the sum of its components in
+  /// the elementary spaces (see Operator)
+  void add_composite_space(char label,
+                           const std::vector<char> &elementary_spaces);
 
   /// Return the number of elementary spaces
-  int num_spaces() { return static_cast<int>(space_info_.size()); }
+  int num_spaces() const { return static_cast<int>(space_info_.size()); }
+
+  /// Return the number of composite spaces
+  int num_composite_spaces() const {
+    return static_cast<int>(composite_space_info_.size());
+  }
+
+  /// The label of a composite space
+  char composite_label(int pos) const;
+
+  /// The elementary spaces that make up a composite space
+  const std::vector<int> &composite_elements(int pos) const;
+
+  /// Is label the label of a composite space?
+  bool is_composite_space(char label) const;
+
+  /// Maps a label into a composite space
+  int label_to_composite_space(char label) const;
 
   /// The label of an orbital space
   char label(int pos) const;
@@ -89,16 +112,46 @@ private:
   /// Vector of spaces
   std::vector<OrbitalSpace> space_info_;
 
+  /// Vector of composite spaces
+  std::vector<OrbitalSpace> composite_space_info_;
+
   /// Maps a space label to its index
   std::map<char, int> label_to_pos_;
 
+  /// Maps a composite space label to its index
+  std::map<char, int> composite_label_to_pos_;
+
   /// Maps orbital indices to a composite space
   std::map<std::string, int> indices_to_pos_;
 };
 
-extern std::shared_ptr<OrbitalSpaceInfo> orbital_subspaces;
+/// Return the orbital space information used by the calling thread. Threads
+/// share a default object unless they install their own with osi_scope.
+const std::shared_ptr<OrbitalSpaceInfo> &get_osi();
+
+/// Return the orbital space information shared by all threads by default
+const std::shared_ptr<OrbitalSpaceInfo> &default_osi();
 
-std::shared_ptr<OrbitalSpaceInfo> get_osi();
+/// Set the orbital space information used by the calling thread (nullptr =
+/// use the default object)
+void set_osi(std::shared_ptr<OrbitalSpaceInfo> osi);
+
+/**
+ * @brief Install an orbital space context on the calling thread
+ *
+ * The previous context is restored when this object goes out of scope. A null
+ * pointer keeps the current context.
+ */
+class osi_scope {
+public:
+  explicit osi_scope(std::shared_ptr<OrbitalSpaceInfo> osi);
+  ~osi_scope();
+  osi_scope(const osi_scope &) = delete;
+  osi_scope &operator=(const osi_scope &) = delete;
+
+private:
+  std::shared_ptr<OrbitalSpaceInfo> previous_;
+};
 
 /// Used to convert a string (e.g., "unoccupied") to a SpaceType
 SpaceType string_to_space_type(const std::string &str);
@@ -0,0 +1,96 @@
+#ifndef _wicked_parallel_h_
+#define _wicked_parallel_h_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "orbital_space.h"
+
+/// Return a reference to the maximum number of threads (0 = one per core)
+inline std::atomic<int> &max_threads_setting() {
+  static std::atomic<int> n(0);
+  return n;
+}
+
+/// Set the maximum number of threads used by parallel loops (0 = one per core)
+inline void set_num_threads(int n) { max_threads_setting() = std::max(n, 0); }
+
+/// Return the maximum number of threads used by parallel loops
+inline int num_threads() {
+  const int n = max_threads_setting();
+  if (n > 0) {
+    return n;
+  }
+  return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+/**
+ * @brief Call f(i) for i = 0, ..., n - 1 using several threads
+ *
+ * The iterations are handed out in chunks of `grain` consecutive indices.
+ * Loops with fewer than two chunks run on the calling thread. If f throws,
+ * the remaining chunks are skipped and the first exception is rethrown on the
+ * calling thread. The order in which the iterations run is unspecified, so f
+ * must write its result to a location determined by i. The worker threads use
+ * the orbital spaces of the calling thread.
+ */
+template <class F> void parallel_for(size_t n, F f, size_t grain = 64) {
+  grain = std::max<size_t>(grain, 1);
+  const size_t nchunks = (n + grain - 1) / grain;
+  const size_t nthreads =
+      std::min(nchunks, static_cast<size_t>(num_threads()));
+  if (nthreads <= 1) {
+    for (size_t i = 0; i < n; i++) {
+      f(i);
+    }
+    return;
+  }
+
+  std::atomic<size_t> next_chunk(0);
+  std::atomic<bool> failed(false);
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  const std::shared_ptr<OrbitalSpaceInfo> osi = get_osi();
+
+  auto worker = [&]() {
+    osi_scope scope(osi);
+    while (not failed) {
+      const size_t chunk = next_chunk++;
+      if (chunk >= nchunks) {
+        return;
+      }
+      const size_t end = std::min(n, (chunk + 1) * grain);
+      try {
+        for (size_t i = chunk * grain; i < end; i++) {
+          f(i);
+        }
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (not error) {
+          error = std::current_exception();
+        }
+        failed = true;
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(nthreads - 1);
+  for (size_t t = 1; t < nthreads; t++) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto &t : threads) {
+    t.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+#endif // _wicked_parallel_h_
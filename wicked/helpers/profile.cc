@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#include "fmt/format.h"
+
+#include "profile.h"
+
+namespace {
+
+/// The data collected by one thread. Only the owning thread updates the
+/// counters, so a relaxed load followed by a store is enough.
+struct thread_profile {
+  std::array<std::atomic<uint64_t>, num_counters> counters = {};
+  /// guards product_time
+  std::mutex mutex;
+  std::map<std::string, std::pair<uint64_t, double>> product_time;
+
+  thread_profile();
+  ~thread_profile();
+
+  profile_data data() {
+    profile_data result;
+    for (int i = 0; i < num_counters; i++) {
+      result.counters[i] = counters[i].load(std::memory_order_relaxed);
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    result.product_time = product_time;
+    return result;
+  }
+
+  void reset() {
+    for (auto &c : counters) {
+      c.store(0, std::memory_order_relaxed);
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    product_time.clear();
+  }
+};
+
+/// The list of threads that collect data and the data of the threads that
+/// have exited
+struct profile_registry {
+  std::mutex mutex;
+  std::vector<thread_profile *> threads;
+  profile_data retired;
+};
+
+profile_registry &registry() {
+  // never destroyed, since threads may exit after static destruction starts
+  static profile_registry *r = new profile_registry;
+  return *r;
+}
+
+thread_profile::thread_profile() {
+  std::lock_guard<std::mutex> lock(registry().mutex);
+  registry().threads.push_back(this);
+}
+
+thread_profile::~thread_profile() {
+  profile_data d = data();
+  std::lock_guard<std::mutex> lock(registry().mutex);
+  auto &threads = registry().threads;
+  threads.erase(std::find(threads.begin(), threads.end(), this));
+  registry().retired += d;
+}
+
+thread_profile &this_thread_profile() {
+  thread_local thread_profile p;
+  return p;
+}
+
+const char *counter_names[num_counters] = {
+    "elementary_contractions", "composite_contractions", "pruned_branches",
+    "operator_permutations",   "terms_added",            "terms_cancelled"};
+
+} // namespace
+
+const char *counter_name(Counter c) {
+  return counter_names[static_cast<int>(c)];
+}
+
+profile_data &profile_data::operator+=(const profile_data &other) {
+  for (int i = 0; i < num_counters; i++) {
+    counters[i] += other.counters[i];
+  }
+  for (const auto &[product, calls_time] : other.product_time) {
+    auto &[calls, time] = product_time[product];
+    calls += calls_time.first;
+    time += calls_time.second;
+  }
+  return *this;
+}
+
+std::string profile_data::str() const {
+  std::string s;
+  for (int i = 0; i < num_counters; i++) {
+    s += fmt::format("{:<28s}{:>16d}\n", counter_names[i], counters[i]);
+  }
+  for (const auto &[product, calls_time] : product_time) {
+    s += fmt::format("{:>10d} {:12.6f} s  {}\n", calls_time.first,
+                     calls_time.second, product);
+  }
+  return s;
+}
+
+void enable_profile(bool val) {
+#ifndef WICKED_DISABLE_PROFILE
+  profile_flag() = val;
+#endif
+}
+
+void count_event(Counter c, uint64_t n) {
+  auto &counter = this_thread_profile().counters[static_cast<int>(c)];
+  counter.store(counter.load(std::memory_order_relaxed) + n,
+                std::memory_order_relaxed);
+}
+
+void count_product_time(const std::string &product, double time) {
+  thread_profile &p = this_thread_profile();
+  std::lock_guard<std::mutex> lock(p.mutex);
+  auto &[calls, t] = p.product_time[product];
+  calls += 1;
+  t += time;
+}
+
+profile_data profile() {
+  std::lock_guard<std::mutex> lock(registry().mutex);
+  profile_data result = registry().retired;
+  for (thread_profile *p : registry().threads) {
+    result += p->data();
+  }
+  return result;
+}
+
+void reset_profile() {
+  std::lock_guard<std::mutex> lock(registry().mutex);
+  registry().retired = profile_data();
+  for (thread_profile *p : registry().threads) {
+    p->reset();
+  }
+}
@@ -0,0 +1,94 @@
+#ifndef _wicked_profile_h_
+#define _wicked_profile_h_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+
+/// The events counted when profiling is enabled
+enum class Counter {
+  /// elementary contractions generated (step 1)
+  ElementaryContractions,
+  /// composite contractions generated (step 2)
+  CompositeContractions,
+  /// elementary contractions rejected while building composite contractions
+  PrunedBranches,
+  /// operator permutations examined to canonicalize contraction graphs
+  OperatorPermutations,
+  /// terms passed to Expression::add
+  TermsAdded,
+  /// terms that cancelled an existing term in Expression::add
+  TermsCancelled,
+  /// the number of counters (not a counter)
+  NumCounters
+};
+
+constexpr int num_counters = static_cast<int>(Counter::NumCounters);
+
+/// Return the name of a counter (e.g., "pruned_branches")
+const char *counter_name(Counter c);
+
+/// The counters and times collected while profiling
+struct profile_data {
+  /// the value of each counter
+  std::array<uint64_t, num_counters> counters = {};
+
+  /// the number of calls and the time spent (s) contracting each product of
+  /// operators
+  std::map<std::string, std::pair<uint64_t, double>> product_time;
+
+  /// Return the value of a counter
+  uint64_t operator[](Counter c) const {
+    return counters[static_cast<int>(c)];
+  }
+
+  /// Add the data of another object
+  profile_data &operator+=(const profile_data &other);
+
+  /// Return a string representation
+  std::string str() const;
+};
+
+#ifdef WICKED_DISABLE_PROFILE
+constexpr bool profile_enabled() { return false; }
+#else
+/// Return a reference to the flag that turns on profiling
+inline std::atomic<bool> &profile_flag() {
+  static std::atomic<bool> flag(false);
+  return flag;
+}
+
+/// Is profiling enabled?
+inline bool profile_enabled() {
+  return profile_flag().load(std::memory_order_relaxed);
+}
+#endif
+
+/// Turn on/off profiling (has no effect if compiled with
+/// WICKED_DISABLE_PROFILE)
+void enable_profile(bool val);
+
+/// Add n to a counter of the calling thread (call only if profiling is enabled)
+void count_event(Counter c, uint64_t n = 1);
+
+/// Add the time spent contracting a product of operators (call only if
+/// profiling is enabled)
+void count_product_time(const std::string &product, double time);
+
+/// Return the sum of the data collected by all threads
+profile_data profile();
+
+/// Reset the data collected by all threads
+void reset_profile();
+
+/// Add n to a counter if profiling is enabled
+#define PROFILE_COUNT(counter, n)                                              \
+  do {                                                                         \
+    if (profile_enabled()) {                                                   \
+      count_event(counter, n);                                                 \
+    }                                                                          \
+  } while (0)
+
+#endif // _wicked_profile_h_
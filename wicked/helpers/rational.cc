@@ -1,13 +1,15 @@
+#include <iomanip>
+#include <limits>
 #include <numeric>
-#include <regex>
 #include <sstream>
-#include <iomanip>
+#include <stdexcept>
 
 #if USE_BOOST_1024_INT
 #include "boost/lexical_cast.hpp"
 #endif
 
 #include "rational.h"
+#include "string_scanner.h"
 
 rational::rational() : numerator_(0), denominator_(1) {}
 
@@ -218,38 +220,60 @@ void rational::reduce() {
   }
 }
 
-#include <iostream>
-
-rational make_rational_from_str(const std::string &s) {
-  std::smatch sm;
-  auto factor_re = std::regex("^\\s*([+-])?(\\d*)?(\\/)?(\\d*)?\\s*");
-  auto m = std::regex_match(s, sm, factor_re);
-  if (not m) {
+namespace {
+/// Convert a string of digits to an integer
+rational_t digits_to_int(std::string_view digits, const std::string &s) {
+  // the largest number of digits that cannot overflow
+  if (digits.size() > std::numeric_limits<rational_t>::digits10) {
     throw std::runtime_error("\nCould not convert the string " + s +
-                             " to a rational object");
+                             " to a rational object (the number is too large)");
+  }
+  rational_t n = 0;
+  for (char c : digits) {
+    n = n * 10 + (c - '0');
   }
-  std::string sign = sm[1];
-  std::string numerator_str = sm[2];
-  std::string division = sm[3];
-  std::string denominator_str = sm[4];
-  int numerator = 1, denominator = 1;
-  if (sign == "-") {
-    numerator *= -1;
+  return n;
+}
+} // namespace
+
+rational parse_rational(string_scanner &in) {
+  in.skip_space();
+  bool negative = false;
+  if (not in.accept('+')) {
+    negative = in.accept('-');
   }
-  // if we have a division sign
-  if (division.size() != 0) {
-    // make sure there is a numerator
-    if ((numerator_str.size() == 0) or (denominator_str.size() == 0))
-      throw std::runtime_error("\nCould not convert the string " + s +
+  const std::string_view numerator_str = in.read_digits();
+  rational_t numerator = 1, denominator = 1;
+  if (in.accept('/')) {
+    const std::string_view denominator_str = in.read_digits();
+    // make sure there is a numerator and a denominator
+    if (numerator_str.empty() or denominator_str.empty()) {
+      throw std::runtime_error("\nCould not convert the string " +
+                               std::string(in.input()) +
                                " to a rational object");
+    }
+    denominator = digits_to_int(denominator_str, std::string(in.input()));
+    if (denominator == 0) {
+      throw std::runtime_error("\nCould not convert the string " +
+                               std::string(in.input()) +
+                               " to a rational object (zero denominator)");
+    }
   }
-  if (numerator_str.size() > 0) {
-    numerator *= std::stoi(numerator_str);
+  if (not numerator_str.empty()) {
+    numerator = digits_to_int(numerator_str, std::string(in.input()));
   }
-  if ((division == "/") and (denominator_str.size() > 0)) {
-    denominator *= std::stoi(denominator_str);
+  in.skip_space();
+  return rational(negative ? rational_t(-numerator) : numerator, denominator);
+}
+
+rational make_rational_from_str(const std::string &s) {
+  string_scanner in(s);
+  rational r = parse_rational(in);
+  if (not in.done()) {
+    throw std::runtime_error("\nCould not convert the string " + s +
+                             " to a rational object");
   }
-  return rational(numerator, denominator);
+  return r;
 }
 
 /// return true if boost rational is used
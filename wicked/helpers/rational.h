@@ -16,6 +16,8 @@ using rational_t = boost::multiprecision::int1024_t;
 using rational_t = long long int;
 #endif
 
+class string_scanner;
+
 /// A class for rational numbers
 class rational {
 
@@ -80,6 +82,9 @@ rational operator*(rational lhs, const rational &rhs);
 rational operator/(rational lhs, const rational &rhs);
 /// make a rational from a string
 rational make_rational_from_str(const std::string &s);
+/// read a rational (e.g., "-1/2", "+3", "-", or "") from a scanner. The
+/// surrounding spaces are skipped. A missing numerator is read as 1
+rational parse_rational(string_scanner &in);
 /// output a rational to a stream
 std::ostream &operator<<(std::ostream &os, const rational &rhs);
 /// return true if boost rational is used
@@ -0,0 +1,85 @@
+#ifndef _wicked_string_scanner_h_
+#define _wicked_string_scanner_h_
+
+#include <string>
+#include <string_view>
+
+/**
+ * @brief A cursor over a string used by the parsers of the text
+ * representations (of indices, tensors, operators, and expressions)
+ *
+ * The parsers read the input in a single pass, one character at a time, and
+ * return views of the input instead of copies.
+ */
+class string_scanner {
+public:
+  explicit string_scanner(std::string_view s)
+      : begin_(s.data()), p_(s.data()), end_(s.data() + s.size()) {}
+
+  /// Return true if all the input was read
+  bool done() const { return p_ == end_; }
+
+  /// Return the current character ('\0' at the end of the input)
+  char peek() const { return p_ != end_ ? *p_ : '\0'; }
+
+  /// Return the character after the current one ('\0' if there is none)
+  char peek_next() const { return (end_ - p_ > 1) ? p_[1] : '\0'; }
+
+  /// Read the current character
+  char get() { return p_ != end_ ? *p_++ : '\0'; }
+
+  /// Read the character c if it is the current one
+  bool accept(char c) {
+    if ((p_ != end_) and (*p_ == c)) {
+      ++p_;
+      return true;
+    }
+    return false;
+  }
+
+  /// Skip spaces and tabs (and carriage returns)
+  void skip_space() {
+    while ((p_ != end_) and ((*p_ == ' ') or (*p_ == '\t') or (*p_ == '\r'))) {
+      ++p_;
+    }
+  }
+
+  /// Read a sequence of characters that satisfy pred
+  template <class Pred> std::string_view read_while(Pred pred) {
+    const char *start = p_;
+    while ((p_ != end_) and pred(*p_)) {
+      ++p_;
+    }
+    return std::string_view(start, p_ - start);
+  }
+
+  /// Read a (possibly empty) sequence of digits
+  std::string_view read_digits() { return read_while(is_digit); }
+
+  /// Read up to the end of the line and skip the end of line
+  std::string_view read_line() {
+    std::string_view line = read_while([](char c) { return c != '\n'; });
+    accept('\n');
+    return line;
+  }
+
+  /// Return the input
+  std::string_view input() const {
+    return std::string_view(begin_, end_ - begin_);
+  }
+
+  static bool is_digit(char c) { return (c >= '0') and (c <= '9'); }
+
+  static bool is_alpha(char c) {
+    return ((c >= 'a') and (c <= 'z')) or ((c >= 'A') and (c <= 'Z'));
+  }
+
+  static bool is_alnum(char c) { return is_alpha(c) or is_digit(c); }
+
+private:
+  const char *begin_;
+  const char *p_;
+  const char *end_;
+};
+
+#endif // _wicked_string_scanner_h_
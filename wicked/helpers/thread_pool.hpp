@@ -0,0 +1,100 @@
+#ifndef _wicked_thread_pool_h_
+#define _wicked_thread_pool_h_
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "orbital_space.h"
+#include "parallel.hpp"
+
+/**
+ * @brief A fixed set of threads that run tasks in the order they are submitted
+ *
+ * Each task runs with the orbital spaces of the thread that submitted it.
+ * The destructor waits for the running tasks to finish and discards the
+ * queued ones (their futures report a broken promise).
+ */
+class thread_pool {
+public:
+  /// Create a pool with nthreads threads (at least one)
+  explicit thread_pool(int nthreads) {
+    nthreads = std::max(nthreads, 1);
+    threads_.reserve(nthreads);
+    for (int i = 0; i < nthreads; i++) {
+      threads_.emplace_back([this]() { run(); });
+    }
+  }
+
+  ~thread_pool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &t : threads_) {
+      t.join();
+    }
+  }
+
+  thread_pool(const thread_pool &) = delete;
+  thread_pool &operator=(const thread_pool &) = delete;
+
+  /// Return the number of threads
+  int size() const { return static_cast<int>(threads_.size()); }
+
+  /// Queue the call f() and return a future holding its result
+  template <class F> auto submit(F f) -> std::future<decltype(f())> {
+    using result_t = decltype(f());
+    auto task = std::make_shared<std::packaged_task<result_t()>>(
+        [f = std::move(f), osi = get_osi()]() mutable {
+          osi_scope scope(osi);
+          return f();
+        });
+    std::future<result_t> result = task->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.emplace_back([task]() { (*task)(); });
+    }
+    cv_.notify_one();
+    return result;
+  }
+
+private:
+  std::vector<std::thread> threads_;
+  std::deque<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_ = false;
+
+  void run() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return stop_ or not tasks_.empty(); });
+        if (stop_) {
+          return;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+    }
+  }
+};
+
+/// Return the pool used to run asynchronous tasks. It is created on first use
+/// with num_threads() threads.
+inline thread_pool &default_thread_pool() {
+  static thread_pool pool(num_threads());
+  return pool;
+}
+
+#endif // _wicked_thread_pool_h_
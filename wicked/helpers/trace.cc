@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+
+#include "fmt/format.h"
+
+#include "trace.h"
+
+namespace {
+
+struct event {
+  const char *name;
+  double start;
+  double duration;
+  std::vector<std::pair<const char *, std::string>> args;
+};
+
+/// The events recorded by one thread
+struct thread_trace {
+  /// guards events
+  std::mutex mutex;
+  std::vector<event> events;
+  /// the thread id written to the trace
+  int tid;
+
+  thread_trace();
+  ~thread_trace();
+};
+
+/// The list of threads that record events and the events of the threads that
+/// have exited
+struct trace_registry {
+  std::mutex mutex;
+  std::vector<thread_trace *> threads;
+  std::vector<std::pair<int, std::vector<event>>> retired;
+  std::string path;
+  std::atomic<int64_t> start_ns{0};
+  int next_tid = 0;
+};
+
+trace_registry &registry() {
+  // never destroyed, since threads may exit after static destruction starts
+  static trace_registry *r = new trace_registry;
+  return *r;
+}
+
+thread_trace::thread_trace() {
+  std::lock_guard<std::mutex> lock(registry().mutex);
+  tid = registry().next_tid++;
+  registry().threads.push_back(this);
+}
+
+thread_trace::~thread_trace() {
+  std::lock_guard<std::mutex> lock(registry().mutex);
+  auto &threads = registry().threads;
+  threads.erase(std::find(threads.begin(), threads.end(), this));
+  if (not events.empty()) {
+    registry().retired.emplace_back(tid, std::move(events));
+  }
+}
+
+thread_trace &this_thread_trace() {
+  thread_local thread_trace t;
+  return t;
+}
+
+int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+std::string json_escape(const std::string &s) {
+  std::string result;
+  for (char c : s) {
+    if (c == '"' or c == '\\') {
+      result += '\\';
+      result += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      result += fmt::format("\\u{:04x}", static_cast<int>(c));
+    } else {
+      result += c;
+    }
+  }
+  return result;
+}
+
+void write_events(std::ofstream &file, int tid,
+                  const std::vector<event> &events, bool &first) {
+  for (const auto &e : events) {
+    file << (first ? "\n" : ",\n");
+    first = false;
+    file << fmt::format("{{\"name\":\"{}\",\"cat\":\"wicked\",\"ph\":\"X\","
+                        "\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":0,\"tid\":{}",
+                        json_escape(e.name), e.start, e.duration, tid);
+    if (not e.args.empty()) {
+      file << ",\"args\":{";
+      for (size_t i = 0; i < e.args.size(); i++) {
+        file << (i ? "," : "") << "\"" << json_escape(e.args[i].first)
+             << "\":\"" << json_escape(e.args[i].second) << "\"";
+      }
+      file << "}";
+    }
+    file << "}";
+  }
+}
+
+} // namespace
+
+void start_trace(const std::string &path) {
+#ifdef WICKED_DISABLE_PROFILE
+  throw std::runtime_error(
+      "start_trace: wicked was compiled without profiling support");
+#else
+  // check that the file can be written before recording anything
+  std::ofstream file(path);
+  if (not file) {
+    throw std::runtime_error("start_trace: cannot open the file " + path);
+  }
+  std::lock_guard<std::mutex> lock(registry().mutex);
+  registry().path = path;
+  registry().retired.clear();
+  for (thread_trace *t : registry().threads) {
+    std::lock_guard<std::mutex> thread_lock(t->mutex);
+    t->events.clear();
+  }
+  registry().start_ns = now_ns();
+  trace_flag() = true;
+#endif
+}
+
+void stop_trace() {
+#ifndef WICKED_DISABLE_PROFILE
+  trace_flag() = false;
+  std::lock_guard<std::mutex> lock(registry().mutex);
+  if (registry().path.empty()) {
+    return;
+  }
+  std::ofstream file(registry().path);
+  if (not file) {
+    throw std::runtime_error("stop_trace: cannot open the file " +
+                             registry().path);
+  }
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  for (const auto &[tid, events] : registry().retired) {
+    write_events(file, tid, events, first);
+  }
+  for (thread_trace *t : registry().threads) {
+    std::lock_guard<std::mutex> thread_lock(t->mutex);
+    write_events(file, t->tid, t->events, first);
+    t->events.clear();
+  }
+  file << "\n]}\n";
+  registry().retired.clear();
+  registry().path.clear();
+#endif
+}
+
+double trace_now() { return 1.0e-3 * (now_ns() - registry().start_ns); }
+
+void trace_event(
+    const char *name, double start, double end,
+    const std::vector<std::pair<const char *, std::string>> &args) {
+  if (not trace_enabled()) {
+    return;
+  }
+  thread_trace &t = this_thread_trace();
+  std::lock_guard<std::mutex> lock(t.mutex);
+  t.events.push_back(event{name, start, end - start, args});
+}
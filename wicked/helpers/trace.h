@@ -0,0 +1,86 @@
+#ifndef _wicked_trace_h_
+#define _wicked_trace_h_
+
+#include <atomic>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef WICKED_DISABLE_PROFILE
+constexpr bool trace_enabled() { return false; }
+#else
+/// Return a reference to the flag that turns on tracing
+inline std::atomic<bool> &trace_flag() {
+  static std::atomic<bool> flag(false);
+  return flag;
+}
+
+/// Is tracing enabled?
+inline bool trace_enabled() {
+  return trace_flag().load(std::memory_order_relaxed);
+}
+#endif
+
+/// Start recording a trace that will be written to a file in the Chrome trace
+/// event format (readable with chrome://tracing or https://ui.perfetto.dev).
+/// Any trace being recorded is discarded.
+void start_trace(const std::string &path);
+
+/// Stop recording and write the trace to the file passed to start_trace()
+void stop_trace();
+
+/// The time (in microseconds) since the trace was started
+double trace_now();
+
+/// Record a span that started at time start and ended at time end
+void trace_event(const char *name, double start, double end,
+                 const std::vector<std::pair<const char *, std::string>> &args);
+
+/**
+ * @brief A span of time recorded in the trace
+ *
+ * The span starts when this object is created and ends when it is destroyed
+ * (or when end() is called).
+ * Spans created in nested scopes appear nested in the trace. If tracing is
+ * off, this object does nothing.
+ */
+class trace_span {
+public:
+  /// Start a span. name must be a string literal
+  explicit trace_span(const char *name)
+      : name_(trace_enabled() ? name : nullptr) {
+    if (name_) {
+      start_ = trace_now();
+    }
+  }
+
+  ~trace_span() { end(); }
+
+  trace_span(const trace_span &) = delete;
+  trace_span &operator=(const trace_span &) = delete;
+
+  /// Is this span being recorded? Use it to skip building arguments
+  bool active() const { return name_ != nullptr; }
+
+  /// End the span before this object is destroyed
+  void end() {
+    if (name_) {
+      trace_event(name_, start_, trace_now(), args_);
+      name_ = nullptr;
+    }
+  }
+
+  /// Attach an argument to this span. key must be a string literal
+  void arg(const char *key, std::string value) {
+    if (name_) {
+      args_.emplace_back(key, std::move(value));
+    }
+  }
+
+private:
+  const char *name_;
+  double start_ = 0.0;
+  std::vector<std::pair<const char *, std::string>> args_;
+};
+
+#endif // _wicked_trace_h_
@@ -1,56 +1,58 @@
+import contextlib
+
 import wicked
 
-__all__ = ["string_to_expr", "gen_op"]
+__all__ = ["string_to_expr", "gen_op", "trace"]
 
 
 def string_to_expr(s):
     """
-    This function takes a string, splits it, and converts
+    This function takes a string with one term per line and converts
     it into an Expression object
     """
-    expr = wicked.Expression()
-    for line in s.split("\n"):
-        expr += wicked.expression(line)
-    return expr
+    return wicked.expression(s)
 
 
 def split(word):
     return [char for char in word]
 
 
-def gen_op(label, rank, cre_spaces, ann_spaces, diagonal=True):
+def gen_op(
+    label, rank, cre_spaces, ann_spaces, diagonal=True, excitation_classes=None
+):
     """
     This function automates the creation of operators that span multiple spaces.
 
     For example, instead of specifying all the components of an operator via
     wicked.op('T',['a+ c','v+ c','v+ a'])
     one can directly specify the
-    wicked.op('T',1,'av','ca')
+    wicked.utils.gen_op('T',1,'av','ca')
+
+    If diagonal is False, the components with the same spaces for the creation
+    and annihilation operators (e.g., 'o+ o' and 'o+ v+ v o') are skipped. If
+    excitation_classes is not empty, only the components with the listed
+    excitation class (the number of holes and particles created minus the
+    number destroyed, e.g., 2 for 'v+ o') are included.
+    """
+    if excitation_classes is None:
+        excitation_classes = []
+    return wicked.gen_op(
+        label, rank, cre_spaces, ann_spaces, diagonal, excitation_classes
+    )
+
+
+@contextlib.contextmanager
+def trace(path):
+    """
+    Record a trace of the contractions run inside a `with` block and write it
+    to a file in the Chrome trace event format (see chrome://tracing or
+    https://ui.perfetto.dev)
+
+    with wicked.trace("ccsd.json"):
+        wt.contract(Hbar, 0, 2)
     """
-    import itertools
-
-    cre_spaces = split(cre_spaces)
-    ann_spaces = split(ann_spaces)
-
-    osi = wicked.osi()
-    m = {osi.label(n): n for n in range(osi.num_spaces())}
-
-    c = [cre_spaces for n in range(rank)]
-    a = [ann_spaces for n in range(rank)]
-    terms = []
-    for le in itertools.product(*c):
-        is_le_sorted = all(m[le[i]] <= m[le[i + 1]] for i in range(len(le) - 1))
-        if is_le_sorted:
-            for re in itertools.product(*a):
-                is_re_sorted = all(m[re[i]] >= m[re[i + 1]] for i in range(len(re) - 1))
-                if is_re_sorted:
-                    if not diagonal:
-                        if le != re:
-                            terms.append(
-                                " ".join([s + "+" for s in le]) + " " + " ".join(re)
-                            )
-                    else:
-                        terms.append(
-                            " ".join([s + "+" for s in le]) + " " + " ".join(re)
-                        )
-    return wicked.op(label, terms)
+    wicked.start_trace(path)
+    try:
+        yield
+    finally:
+        wicked.stop_trace()